@@ -1,153 +1,600 @@
-#include "api-base.h"
-
-#include "logger/log-utils.h"
-#include "types.h"
-
-#include <format>
-
-namespace loomis
-{
-   ApiBase::ApiBase(std::string_view name,
-                    std::string_view url,
-                    std::string_view apiKey,
-                    std::string_view className,
-                    std::string_view ansiiCode)
-      : Base(className, ansiiCode, name)
-      , name_(name)
-      , url_(url)
-      , apiKey_(apiKey)
-   {
-   }
-
-   std::optional<std::vector<Task>> ApiBase::GetTaskList()
-   {
-      return std::nullopt;
-   }
-
-   const std::string& ApiBase::GetName() const
-   {
-      return name_;
-   }
-
-   const std::string& ApiBase::GetUrl() const
-   {
-      return url_;
-   }
-
-   const std::string& ApiBase::GetApiKey() const
-   {
-      return apiKey_;
-   }
-
-   void ApiBase::AddApiParam(std::string& url, const ApiParams& params) const
-   {
-      if (params.empty()) return;
-
-      bool hasQuery = (url.find('?') != std::string::npos);
-      bool lastIsSeparator = !url.empty() && (url.back() == '?' || url.back() == '&');
-      for (const auto& [key, value] : params)
-      {
-         if (!lastIsSeparator)
-         {
-            url += hasQuery ? '&' : '?';
-         }
-         url += key;
-         url += '=';
-         url += GetPercentEncoded(value);
-
-         hasQuery = true;
-         lastIsSeparator = false;
-      }
-   }
-
-   std::string ApiBase::BuildApiPath(std::string_view path) const
-   {
-      auto apiTokenName = GetApiTokenName();
-      char separator = (path.find('?') == std::string_view::npos) ? '?' : '&';
-      if (apiTokenName.empty())
-      {
-         return std::format("{}{}", GetApiBase(), path);
-      }
-      else
-      {
-         return std::format("{}{}{}{}={}",
-                            GetApiBase(),
-                            path,
-                            separator,
-                            apiTokenName,
-                            GetPercentEncoded(GetApiKey()));
-      }
-   }
-
-   std::string ApiBase::BuildApiParamsPath(std::string_view path, const ApiParams& params) const
-   {
-      auto apiPath = BuildApiPath(path);
-      AddApiParam(apiPath, params);
-      return apiPath;
-   }
-
-   std::string ApiBase::GetPercentEncoded(std::string_view src) const
-   {
-      // 1. Lookup table for "unreserved" characters (RFC 3986)
-      // 0 = needs encoding, 1 = safe
-      static const bool SAFE[256] = {
-          0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 0-31
-          0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,1,1,1,1,1,1,1,1,1,1,0,0,0,0,0,0, // 32-63 (Keep . -)
-          0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,0,0,0,1, // 64-95 (Keep _)
-          0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,0,0,1,0, // 96-127 (Keep ~)
-          // ... all others (128-255) are 0
-      };
-
-      static const char hex_chars[] = "0123456789ABCDEF";
-
-      // 2. Pre-calculate exact size to avoid reallocations
-      size_t new_size{0};
-      for (unsigned char c : src)
-      {
-         new_size += SAFE[c] ? 1 : 3;
-      }
-
-      // 3. One single allocation
-      std::string result;
-      result.reserve(new_size);
-
-      // 4. Direct pointer-style insertion
-      for (unsigned char c : src)
-      {
-         if (SAFE[c])
-         {
-            result.push_back(c);
-         }
-         else
-         {
-            result.push_back('%');
-            result.push_back(hex_chars[c >> 4]);   // High nibble
-            result.push_back(hex_chars[c & 0x0F]); // Low nibble
-         }
-      }
-
-      return result;
-   }
-
-   bool ApiBase::IsHttpSuccess(std::string_view name, const httplib::Result& result, bool log)
-   {
-      std::string error;
-
-      if (result.error() != httplib::Error::Success)
-      {
-         error = httplib::to_string(result.error());
-      }
-      else if (result->status >= VALID_HTTP_RESPONSE_MAX)
-      {
-         error = std::format("Status {}: {} - {}", result->status, result->reason, result->body);
-      }
-      else
-      {
-         // Everything passed
-         return true;
-      }
-
-      if (log) LogWarning("{} - HTTP error {}", name, log::GetTag("error", error));
-      return false;
-   }
-}
\ No newline at end of file
+#include "api-base.h"
+
+#include "logger/log-utils.h"
+#include "types.h"
+
+#include <algorithm>
+#include <charconv>
+#include <format>
+#include <thread>
+
+namespace loomis
+{
+   namespace
+   {
+      constexpr int HTTP_NOT_MODIFIED{304};
+
+      const std::string HEADER_ETAG{"ETag"};
+      const std::string HEADER_LAST_MODIFIED{"Last-Modified"};
+      const std::string HEADER_IF_NONE_MATCH{"If-None-Match"};
+      const std::string HEADER_IF_MODIFIED_SINCE{"If-Modified-Since"};
+      const std::string HEADER_CONTENT_LENGTH{"Content-Length"};
+      const std::string HEADER_CONTENT_ENCODING{"Content-Encoding"};
+
+      const std::string METHOD_GET{"GET"};
+      const std::string METHOD_POST{"POST"};
+
+      size_t GetMaxInFlight(const ServerConfig& serverConfig)
+      {
+         return serverConfig.max_in_flight > 0u ? serverConfig.max_in_flight : DEFAULT_MAX_CONNECTIONS;
+      }
+
+      constexpr auto HEALTH_PROBE_INTERVAL{std::chrono::seconds(60)};
+
+      // Down servers are probed after 15s, 30s, 60s... up to every 10 minutes
+      constexpr auto HEALTH_RETRY_MIN{std::chrono::seconds(15)};
+      constexpr auto HEALTH_RETRY_MAX{std::chrono::seconds(600)};
+      constexpr uint32_t HEALTH_RETRY_MAX_SHIFT{6u};
+   }
+
+   ApiBase::ApiBase(const ServerConfig& serverConfig,
+                    std::string_view url,
+                    std::string_view apiKey,
+                    std::string_view className,
+                    std::string_view ansiiCode)
+      : Base(className, ansiiCode, serverConfig.server_name)
+      , className_(className)
+      , name_(serverConfig.server_name)
+      , url_(url)
+      , apiKey_(apiKey)
+      , cacheTtl_(serverConfig.cache_ttl_seconds)
+      , clientPool_(url_, GetMaxInFlight(serverConfig), serverConfig.http_compression)
+      , rateLimiter_(serverConfig.requests_per_second)
+      , executor_(GetMaxInFlight(serverConfig))
+   {
+   }
+
+   ApiBase::~ApiBase()
+   {
+      Shutdown();
+   }
+
+   void ApiBase::Shutdown()
+   {
+      executor_.Shutdown();
+   }
+
+   std::optional<std::vector<Task>> ApiBase::GetTaskList()
+   {
+      std::vector<Task> tasks;
+
+      auto& transferStats = tasks.emplace_back();
+      transferStats.name = std::format("{}({}) - Transfer Stats", className_, GetName());
+      transferStats.cronExpression = "0 0 * * * *";
+      transferStats.func = [this]() {this->LogTransferStats(); };
+
+      return tasks;
+   }
+
+   const std::string& ApiBase::GetClassName() const
+   {
+      return className_;
+   }
+
+   const std::string& ApiBase::GetName() const
+   {
+      return name_;
+   }
+
+   const std::string& ApiBase::GetUrl() const
+   {
+      return url_;
+   }
+
+   const std::string& ApiBase::GetApiKey() const
+   {
+      return apiKey_;
+   }
+
+   std::chrono::seconds ApiBase::GetCacheTtl() const
+   {
+      return cacheTtl_;
+   }
+
+   void ApiBase::ClearResponseCache()
+   {
+      responseCache_.Clear();
+   }
+
+   void ApiBase::AddApiParam(std::string& url, const ApiParams& params) const
+   {
+      if (params.empty()) return;
+
+      bool hasQuery = (url.find('?') != std::string::npos);
+      bool lastIsSeparator = !url.empty() && (url.back() == '?' || url.back() == '&');
+      for (const auto& [key, value] : params)
+      {
+         if (!lastIsSeparator)
+         {
+            url += hasQuery ? '&' : '?';
+         }
+         url += key;
+         url += '=';
+         url += GetPercentEncoded(value);
+
+         hasQuery = true;
+         lastIsSeparator = false;
+      }
+   }
+
+   std::string ApiBase::BuildApiPath(std::string_view path) const
+   {
+      auto apiTokenName = GetApiTokenName();
+      char separator = (path.find('?') == std::string_view::npos) ? '?' : '&';
+      if (apiTokenName.empty())
+      {
+         return std::format("{}{}", GetApiBase(), path);
+      }
+      else
+      {
+         return std::format("{}{}{}{}={}",
+                            GetApiBase(),
+                            path,
+                            separator,
+                            apiTokenName,
+                            GetPercentEncoded(GetApiKey()));
+      }
+   }
+
+   std::string ApiBase::BuildApiParamsPath(std::string_view path, const ApiParams& params) const
+   {
+      auto apiPath = BuildApiPath(path);
+      AddApiParam(apiPath, params);
+      return apiPath;
+   }
+
+   std::string ApiBase::BuildApiParamsPath(std::string_view path, const ApiParams& params, const ApiParams& profile) const
+   {
+      auto apiPath = BuildApiParamsPath(path, params);
+      AddApiParam(apiPath, profile);
+      return apiPath;
+   }
+
+   std::string ApiBase::GetPercentEncoded(std::string_view src) const
+   {
+      // 1. Lookup table for "unreserved" characters (RFC 3986)
+      // 0 = needs encoding, 1 = safe
+      static const bool SAFE[256] = {
+          0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 0-31
+          0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,1,1,1,1,1,1,1,1,1,1,0,0,0,0,0,0, // 32-63 (Keep . -)
+          0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,0,0,0,1, // 64-95 (Keep _)
+          0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,0,0,1,0, // 96-127 (Keep ~)
+          // ... all others (128-255) are 0
+      };
+
+      static const char hex_chars[] = "0123456789ABCDEF";
+
+      // 2. Pre-calculate exact size to avoid reallocations
+      size_t new_size{0};
+      for (unsigned char c : src)
+      {
+         new_size += SAFE[c] ? 1 : 3;
+      }
+
+      // 3. One single allocation
+      std::string result;
+      result.reserve(new_size);
+
+      // 4. Direct pointer-style insertion
+      for (unsigned char c : src)
+      {
+         if (SAFE[c])
+         {
+            result.push_back(c);
+         }
+         else
+         {
+            result.push_back('%');
+            result.push_back(hex_chars[c >> 4]);   // High nibble
+            result.push_back(hex_chars[c & 0x0F]); // Low nibble
+         }
+      }
+
+      return result;
+   }
+
+   bool ApiBase::GetRequestIdempotent(std::string_view method, std::string_view) const
+   {
+      return method == METHOD_GET;
+   }
+
+   std::string ApiBase::GetEndpointName(std::string_view path) const
+   {
+      return GetEndpointTemplate(path);
+   }
+
+   httplib::Result ApiBase::SendWithRetry(std::string_view method,
+                                          const std::string& path,
+                                          size_t bytesSent,
+                                          const std::function<httplib::Result()>& send,
+                                          const size_t* streamedBytes)
+   {
+      const bool idempotent = GetRequestIdempotent(method, path);
+      const auto endpoint = std::format("{} {}", method, GetEndpointName(path));
+      for (uint32_t attempt = 1u;; ++attempt)
+      {
+         rateLimiter_.Acquire();
+
+         // Latency includes any wait for a free connection but not the rate limit
+         auto start = std::chrono::steady_clock::now();
+         auto res = send();
+         auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+         size_t bodyBytes = streamedBytes ? *streamedBytes : (res ? res->body.size() : 0u);
+         RecordTransfer(res, bodyBytes);
+         requestMetrics_.Record(endpoint, latency, res, bytesSent, bodyBytes);
+
+         // Once part of a streamed body was handed on the receiver can not take it again
+         bool resendable = streamedBytes == nullptr || *streamedBytes == 0u;
+         if (attempt >= retryPolicy_.maxAttempts || !GetRetryable(res, idempotent) || !resendable) return res;
+
+         // A server already marked down is left to the health monitor instead of waiting on it here
+         if (probed_.load() && !online_.load()) return res;
+
+         auto delay = GetRetryDelay(retryPolicy_, res, attempt);
+         if (!ApiDeadline::GetAllows(delay)) return res;
+
+         retries_.fetch_add(1u, std::memory_order_relaxed);
+         requestMetrics_.RecordRetry(endpoint);
+         LogTrace("{} {} failed with {}. Retrying in {}ms",
+                  method, path,
+                  res.error() == httplib::Error::Success ? std::to_string(res->status) : httplib::to_string(res.error()),
+                  delay.count());
+         std::this_thread::sleep_for(delay);
+      }
+   }
+
+   httplib::Result ApiBase::Get(const std::string& path, const httplib::Headers& headers)
+   {
+      return SendWithRetry(METHOD_GET, path, 0u, [&]() {
+         auto client = clientPool_.Acquire();
+         return client->Get(path, headers);
+      });
+   }
+
+   httplib::Result ApiBase::Post(const std::string& path, const httplib::Headers& headers)
+   {
+      return SendWithRetry(METHOD_POST, path, 0u, [&]() {
+         auto client = clientPool_.Acquire();
+         return client->Post(path, headers);
+      });
+   }
+
+   httplib::Result ApiBase::Post(const std::string& path,
+                                 const httplib::Headers& headers,
+                                 const std::string& body,
+                                 const std::string& contentType)
+   {
+      return SendWithRetry(METHOD_POST, path, body.size(), [&]() {
+         auto client = clientPool_.Acquire();
+         return client->Post(path, headers, body, contentType);
+      });
+   }
+
+   httplib::ResponseHandler ApiBase::GetStreamResponseHandler(bool& bodyAccepted)
+   {
+      // Error pages are read and dropped instead of being fed to the receiver. The request then completes
+      // with its status so the failure is reported and retried like any other request.
+      return [&bodyAccepted](const httplib::Response& response) {
+         bodyAccepted = response.status < VALID_HTTP_RESPONSE_MAX;
+         return true;
+      };
+   }
+
+   httplib::Result ApiBase::GetStream(const std::string& path,
+                                      const httplib::Headers& headers,
+                                      httplib::ContentReceiver receiver)
+   {
+      size_t bodyBytes{0u};
+      bool bodyAccepted{false};
+      auto countingReceiver = [&bodyBytes, &bodyAccepted, receiver = std::move(receiver)](const char* data, size_t size) {
+         if (!bodyAccepted) return true;
+         bodyBytes += size;
+         return receiver(data, size);
+      };
+
+      return SendWithRetry(METHOD_GET, path, 0u, [&]() {
+         auto client = clientPool_.Acquire();
+         return client->Get(path, headers, GetStreamResponseHandler(bodyAccepted), countingReceiver);
+      }, &bodyBytes);
+   }
+
+   httplib::Result ApiBase::PostStream(const std::string& path,
+                                       const httplib::Headers& headers,
+                                       const std::string& body,
+                                       const std::string& contentType,
+                                       httplib::ContentReceiver receiver)
+   {
+      httplib::Request request;
+      request.method = METHOD_POST;
+      request.path = path;
+      request.headers = headers;
+      request.body = body;
+      request.set_header("Content-Type", contentType);
+      size_t bodyBytes{0u};
+      bool bodyAccepted{false};
+      request.response_handler = GetStreamResponseHandler(bodyAccepted);
+      request.content_receiver = [&bodyBytes, &bodyAccepted, receiver = std::move(receiver)](const char* data, size_t size, uint64_t, uint64_t) {
+         if (!bodyAccepted) return true;
+         bodyBytes += size;
+         return receiver(data, size);
+      };
+
+      return SendWithRetry(METHOD_POST, path, body.size(), [&]() {
+         auto client = clientPool_.Acquire();
+         return client->send(request);
+      }, &bodyBytes);
+   }
+
+   void ApiBase::RecordTransfer(const httplib::Result& result, size_t bodyBytes)
+   {
+      if (result.error() != httplib::Error::Success) return;
+
+      // Any answer from a server marked down means it is back without waiting for the next probe
+      if (probed_.load() && !online_.load() && result->status < VALID_HTTP_RESPONSE_MAX) SetOnline(true, false);
+
+      replies_.fetch_add(1u, std::memory_order_relaxed);
+      bodyBytes_.fetch_add(bodyBytes, std::memory_order_relaxed);
+      if (result->has_header(HEADER_CONTENT_ENCODING)) compressedReplies_.fetch_add(1u, std::memory_order_relaxed);
+
+      // The header holds the length as sent, before httplib decompresses the body
+      auto contentLength = result->get_header_value(HEADER_CONTENT_LENGTH);
+      uint64_t wireBytes{0u};
+      if (std::from_chars(contentLength.data(), contentLength.data() + contentLength.size(), wireBytes).ec == std::errc{})
+      {
+         wireBytes_.fetch_add(wireBytes, std::memory_order_relaxed);
+         wireBodyBytes_.fetch_add(bodyBytes, std::memory_order_relaxed);
+      }
+   }
+
+   bool ApiBase::GetValid()
+   {
+      if (!probed_.load()) RunHealthProbe();
+      return online_.load();
+   }
+
+   ApiHealth ApiBase::GetHealth() const
+   {
+      std::lock_guard lock(healthLock_);
+      return health_;
+   }
+
+   std::chrono::steady_clock::time_point ApiBase::GetNextHealthProbe() const
+   {
+      std::lock_guard lock(healthLock_);
+      return nextHealthProbe_;
+   }
+
+   void ApiBase::RunHealthProbe()
+   {
+      // Probes are never retried. The monitor backs off on its own.
+      ApiDeadlineScope noRetries(std::chrono::steady_clock::now());
+      SetOnline(ProbeServer(), true);
+   }
+
+   void ApiBase::SetOnline(bool online, bool probed)
+   {
+      auto now = std::chrono::system_clock::now();
+      bool changed{false};
+      {
+         std::lock_guard lock(healthLock_);
+
+         // The first result is reported by the api manager at startup
+         bool first = !probed_.load();
+         changed = !first && health_.online != online;
+         if (first || health_.online != online) health_.lastChange = now;
+
+         health_.online = online;
+         if (probed) health_.lastProbe = now;
+         health_.failedProbes = online ? 0u : health_.failedProbes + 1u;
+
+         auto delay = online ? HEALTH_PROBE_INTERVAL : std::min(HEALTH_RETRY_MIN * (1u << std::min(health_.failedProbes - 1u, HEALTH_RETRY_MAX_SHIFT)), HEALTH_RETRY_MAX);
+         nextHealthProbe_ = std::chrono::steady_clock::now() + delay;
+
+         online_.store(online);
+         probed_.store(true);
+      }
+
+      if (changed)
+      {
+         online ? LogInfo("Server is back online {}", log::GetTag("url", GetUrl()))
+                : LogWarning("Server is not responding. Checking again with backoff {}", log::GetTag("url", GetUrl()));
+      }
+   }
+
+   ApiTransferStats ApiBase::GetTransferStats() const
+   {
+      return ApiTransferStats{
+         .replies = replies_.load(std::memory_order_relaxed),
+         .compressedReplies = compressedReplies_.load(std::memory_order_relaxed),
+         .bodyBytes = bodyBytes_.load(std::memory_order_relaxed),
+         .wireBytes = wireBytes_.load(std::memory_order_relaxed),
+         .wireBodyBytes = wireBodyBytes_.load(std::memory_order_relaxed),
+         .sharedRequests = getFlights_.GetSharedCalls() + parsedFlights_.GetSharedCalls(),
+         .retries = retries_.load(std::memory_order_relaxed),
+         .throttledMs = static_cast<uint64_t>(rateLimiter_.GetWaitTime().count())
+      };
+   }
+
+   ApiCacheStats ApiBase::GetCacheStats() const
+   {
+      return ApiCacheStats{
+         .hits = cacheHits_.load(std::memory_order_relaxed),
+         .revalidated = cacheRevalidated_.load(std::memory_order_relaxed),
+         .misses = cacheMisses_.load(std::memory_order_relaxed),
+         .entries = responseCache_.Size()
+      };
+   }
+
+   std::vector<ApiEndpointStats> ApiBase::GetEndpointStats() const
+   {
+      return requestMetrics_.GetSnapshot();
+   }
+
+   bool ApiBase::GetRateLimited() const
+   {
+      return rateLimiter_.GetEnabled();
+   }
+
+   void ApiBase::LogTransferStats()
+   {
+      auto stats = GetTransferStats();
+      if (stats.replies == 0u && stats.sharedRequests == 0u) return;
+
+      // Share of the decoded bytes that went over the wire for the replies where both are known
+      auto wireRatio = stats.wireBodyBytes > 0u ? static_cast<double>(stats.wireBytes) / static_cast<double>(stats.wireBodyBytes) : 1.0;
+      LogTrace("Transfer stats {} {} {} {} {} {} {} {}",
+               log::GetTag("replies", stats.replies),
+               log::GetTag("shared", stats.sharedRequests),
+               log::GetTag("retries", stats.retries),
+               log::GetTag("throttled_ms", stats.throttledMs),
+               log::GetTag("compressed", stats.compressedReplies),
+               log::GetTag("body_bytes", stats.bodyBytes),
+               log::GetTag("wire_bytes", stats.wireBytes),
+               log::GetTag("wire_ratio", std::format("{:.2f}", wireRatio)));
+
+      for (const auto& endpoint : GetEndpointStats())
+      {
+         LogTrace("Endpoint stats {} {} {} {} {} {} {} {} {} {} {}",
+                  log::GetTag("endpoint", endpoint.endpoint),
+                  log::GetTag("requests", endpoint.requests),
+                  log::GetTag("errors", endpoint.errors),
+                  log::GetTag("retries", endpoint.retries),
+                  log::GetTag("total_ms", endpoint.latencySum.count() / 1000),
+                  log::GetTag("p50_ms", std::format("{:.1f}", endpoint.p50.count() / 1000.0)),
+                  log::GetTag("p90_ms", std::format("{:.1f}", endpoint.p90.count() / 1000.0)),
+                  log::GetTag("p99_ms", std::format("{:.1f}", endpoint.p99.count() / 1000.0)),
+                  log::GetTag("max_ms", std::format("{:.1f}", endpoint.max.count() / 1000.0)),
+                  log::GetTag("bytes_sent", endpoint.bytesSent),
+                  log::GetTag("bytes_received", endpoint.bytesReceived));
+      }
+   }
+
+   std::future<httplib::Result> ApiBase::GetAsync(std::string path, httplib::Headers headers)
+   {
+      return RunAsync([this, path = std::move(path), headers = std::move(headers)]() {
+         return Get(path, headers);
+      });
+   }
+
+   std::future<httplib::Result> ApiBase::PostAsync(std::string path, httplib::Headers headers)
+   {
+      return RunAsync([this, path = std::move(path), headers = std::move(headers)]() {
+         return Post(path, headers);
+      });
+   }
+
+   std::shared_ptr<const std::string> ApiBase::GetCached(std::string_view name,
+                                                         const std::string& path,
+                                                         const httplib::Headers& headers,
+                                                         std::chrono::seconds ttl)
+   {
+      const auto now = std::chrono::steady_clock::now();
+      auto entry = responseCache_.Find(path);
+      if (entry && now < entry->expires)
+      {
+         cacheHits_.fetch_add(1u, std::memory_order_relaxed);
+         return entry->body;
+      }
+
+      return getFlights_.Run(std::format("GET {}", path), [&]() {
+         return GetCachedFromServer(name, path, headers, ttl, std::move(entry));
+      });
+   }
+
+   std::shared_ptr<const std::string> ApiBase::GetCachedFromServer(std::string_view name,
+                                                                   const std::string& path,
+                                                                   const httplib::Headers& headers,
+                                                                   std::chrono::seconds ttl,
+                                                                   std::optional<ApiCacheEntry> entry)
+   {
+      const auto now = std::chrono::steady_clock::now();
+      auto requestHeaders = headers;
+      if (entry)
+      {
+         if (!entry->etag.empty()) requestHeaders.emplace(HEADER_IF_NONE_MATCH, entry->etag);
+         if (!entry->lastModified.empty()) requestHeaders.emplace(HEADER_IF_MODIFIED_SINCE, entry->lastModified);
+      }
+
+      auto res = Get(path, requestHeaders);
+
+      // Server confirmed the cached body is still current
+      if (entry && res.error() == httplib::Error::Success && res->status == HTTP_NOT_MODIFIED)
+      {
+         cacheRevalidated_.fetch_add(1u, std::memory_order_relaxed);
+         entry->expires = now + ttl;
+         responseCache_.Store(path, *entry);
+         return entry->body;
+      }
+
+      cacheMisses_.fetch_add(1u, std::memory_order_relaxed);
+
+      if (!IsHttpSuccess(name, res)) return nullptr;
+
+      ApiCacheEntry newEntry{
+         .body = std::make_shared<const std::string>(std::move(res->body)),
+         .etag = res->get_header_value(HEADER_ETAG),
+         .lastModified = res->get_header_value(HEADER_LAST_MODIFIED),
+         .expires = now + ttl
+      };
+
+      // Entries with no ttl are still worth keeping if they can be revalidated for the cost of a 304
+      auto body = newEntry.body;
+      if (ttl.count() > 0 || newEntry.CanRevalidate())
+      {
+         responseCache_.Store(path, std::move(newEntry));
+      }
+      return body;
+   }
+
+   bool ApiBase::IsHttpSuccess(std::string_view name, const httplib::Result& result, bool log)
+   {
+      std::string error;
+
+      if (result.error() != httplib::Error::Success)
+      {
+         error = httplib::to_string(result.error());
+      }
+      else if (result->status >= VALID_HTTP_RESPONSE_MAX)
+      {
+         error = std::format("Status {}: {} - {}", result->status, result->reason, result->body);
+      }
+      else
+      {
+         // Everything passed
+         return true;
+      }
+
+      if (log) LogWarning("{} - HTTP error {}", name, log::GetTag("error", error));
+      return false;
+   }
+
+   bool ApiBase::IsJsonStreamSuccess(std::string_view name, const httplib::Result& result, const JsonArrayStream& stream)
+   {
+      // A stream that stopped the transfer shows up as a canceled request so report the reason it stopped
+      if (stream.GetFailed() && result.error() == httplib::Error::Canceled)
+      {
+         LogWarning("{} - JSON stream error {}", name, log::GetTag("error", stream.GetError()));
+         return false;
+      }
+
+      if (!IsHttpSuccess(name, result)) return false;
+
+      if (!stream.GetComplete())
+      {
+         LogWarning("{} - JSON reply is missing the {} array", name, stream.GetKeyPathStr());
+         return false;
+      }
+      return true;
+   }
+}
@@ -1,56 +1,279 @@
-#pragma once
-
-#include "base.h"
-#include "config-reader/config-reader-types.h"
-#include "types.h"
-
-#include <httplib.h>
-
-#include <optional>
-#include <string>
-#include <vector>
-
-namespace loomis
-{
-   using ApiParams = std::vector<std::pair<std::string_view, std::string_view>>;
-
-   class ApiBase : public Base
-   {
-   public:
-      ApiBase(std::string_view name,
-              std::string_view url,
-              std::string_view apiKey,
-              std::string_view className,
-              std::string_view ansiiCode);
-      virtual ~ApiBase() = default;
-
-      // Api tasks are optional. Api's can override to perform a task
-      [[nodiscard]] virtual std::optional<std::vector<Task>> GetTaskList();
-
-      [[nodiscard]] const std::string& GetName() const;
-      [[nodiscard]] const std::string& GetUrl() const;
-      [[nodiscard]] const std::string& GetApiKey() const;
-
-      [[nodiscard]] virtual bool GetValid() = 0;
-      [[nodiscard]] virtual std::optional<std::string> GetServerReportedName() = 0;
-
-   protected:
-      [[nodiscard]] virtual std::string_view GetApiBase() const = 0;
-      [[nodiscard]] virtual std::string_view GetApiTokenName() const = 0;
-
-      void AddApiParam(std::string& url, const ApiParams& params) const;
-      [[nodiscard]] std::string BuildApiPath(std::string_view path) const;
-      [[nodiscard]] std::string BuildApiParamsPath(std::string_view path, const ApiParams& params) const;
-
-      // Encode the source string to percent encoding
-      [[nodiscard]] std::string GetPercentEncoded(std::string_view src) const;
-
-      // Returns if the http request was successful and outputs to the log if not successful
-      bool IsHttpSuccess(std::string_view name, const httplib::Result& result, bool log = true);
-
-   private:
-      std::string name_;
-      std::string url_;
-      std::string apiKey_;
-   };
+#pragma once
+
+#include "api/api-client-pool.h"
+#include "api/api-executor.h"
+#include "api/api-json-stream.h"
+#include "api/api-rate-limiter.h"
+#include "api/api-request-metrics.h"
+#include "api/api-response-cache.h"
+#include "api/api-retry-policy.h"
+#include "api/api-single-flight.h"
+#include "base.h"
+#include "config-reader/config-reader-types.h"
+#include "types.h"
+
+#include <httplib.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace loomis
+{
+   using ApiParams = std::vector<std::pair<std::string_view, std::string_view>>;
+
+   // Maximum number of persistent connections kept open to a single server
+   inline constexpr size_t DEFAULT_MAX_CONNECTIONS{8u};
+
+   // Totals of the replies read from one server
+   struct ApiTransferStats
+   {
+      uint64_t replies{0u};
+      uint64_t compressedReplies{0u};
+
+      // Body bytes after any decompression
+      uint64_t bodyBytes{0u};
+
+      // Bytes on the wire and the decoded body bytes of the replies that reported a Content-Length.
+      // Chunked replies do not so they are only part of the body total.
+      uint64_t wireBytes{0u};
+      uint64_t wireBodyBytes{0u};
+
+      // Calls that shared a request already in flight instead of sending their own
+      uint64_t sharedRequests{0u};
+
+      // Requests sent again after a transient failure
+      uint64_t retries{0u};
+
+      // Time requests waited on the rate limit
+      uint64_t throttledMs{0u};
+   };
+
+   // Outcome of GetCached calls
+   struct ApiCacheStats
+   {
+      // Served from the cache without asking the server
+      uint64_t hits{0u};
+
+      // Expired entries the server confirmed with a 304
+      uint64_t revalidated{0u};
+
+      // Bodies downloaded again
+      uint64_t misses{0u};
+      size_t entries{0u};
+   };
+
+   // Server status published by the health monitor
+   struct ApiHealth
+   {
+      bool online{false};
+      std::chrono::system_clock::time_point lastChange;
+      std::chrono::system_clock::time_point lastProbe;
+
+      // Probes failed in a row. Probing backs off while this grows.
+      uint32_t failedProbes{0u};
+   };
+
+   class ApiBase : public Base
+   {
+   public:
+      ApiBase(const ServerConfig& serverConfig,
+              std::string_view url,
+              std::string_view apiKey,
+              std::string_view className,
+              std::string_view ansiiCode);
+      virtual ~ApiBase();
+
+      // Api tasks are optional. Api's can override to perform a task and should keep the base tasks.
+      [[nodiscard]] virtual std::optional<std::vector<Task>> GetTaskList();
+
+      // Name of the api class, EmbyApi, PlexApi...
+      [[nodiscard]] const std::string& GetClassName() const;
+      [[nodiscard]] const std::string& GetName() const;
+      [[nodiscard]] const std::string& GetUrl() const;
+      [[nodiscard]] const std::string& GetApiKey() const;
+      [[nodiscard]] std::chrono::seconds GetCacheTtl() const;
+
+      // Drops every cached response so the next request goes to the server
+      void ClearResponseCache();
+
+      [[nodiscard]] ApiTransferStats GetTransferStats() const;
+      [[nodiscard]] ApiCacheStats GetCacheStats() const;
+
+      // Request counts and latency of every endpoint this api has called, slowest total first
+      [[nodiscard]] std::vector<ApiEndpointStats> GetEndpointStats() const;
+
+      // True when requests_per_second is set for this server
+      [[nodiscard]] bool GetRateLimited() const;
+
+      // Returns the cached server status. Only the first call before the health monitor runs asks the server.
+      [[nodiscard]] bool GetValid();
+      [[nodiscard]] ApiHealth GetHealth() const;
+
+      // Asks the server and publishes the result. Called by the health monitor when the next probe is due.
+      void RunHealthProbe();
+      [[nodiscard]] std::chrono::steady_clock::time_point GetNextHealthProbe() const;
+
+      [[nodiscard]] virtual std::optional<std::string> GetServerReportedName() = 0;
+
+   protected:
+      // Returns true if the server is reachable and the API key is valid
+      [[nodiscard]] virtual bool ProbeServer() = 0;
+
+      [[nodiscard]] virtual std::string_view GetApiBase() const = 0;
+      [[nodiscard]] virtual std::string_view GetApiTokenName() const = 0;
+
+      void AddApiParam(std::string& url, const ApiParams& params) const;
+      [[nodiscard]] std::string BuildApiPath(std::string_view path) const;
+      [[nodiscard]] std::string BuildApiParamsPath(std::string_view path, const ApiParams& params) const;
+
+      // Profiles are fixed params that shape a reply down to the fields its caller reads
+      [[nodiscard]] std::string BuildApiParamsPath(std::string_view path, const ApiParams& params, const ApiParams& profile) const;
+
+      // Encode the source string to percent encoding
+      [[nodiscard]] std::string GetPercentEncoded(std::string_view src) const;
+
+      // Requests that are safe to send twice are retried after any transient failure. Others only when they never
+      // reached the server. Api's override this for POST endpoints that only set state and GET endpoints that change it.
+      [[nodiscard]] virtual bool GetRequestIdempotent(std::string_view method, std::string_view path) const;
+
+      // Name requests are grouped under in the endpoint stats. Api's override this when the endpoint is in the query.
+      [[nodiscard]] virtual std::string GetEndpointName(std::string_view path) const;
+
+      // Http requests are run on a pooled keep-alive connection and are safe to call from any thread.
+      // Transient failures are retried with backoff while the run deadline allows.
+      [[nodiscard]] httplib::Result Get(const std::string& path, const httplib::Headers& headers);
+      [[nodiscard]] httplib::Result Post(const std::string& path, const httplib::Headers& headers);
+      [[nodiscard]] httplib::Result Post(const std::string& path,
+                                         const httplib::Headers& headers,
+                                         const std::string& body,
+                                         const std::string& contentType);
+
+      // Streaming requests hand the body to the receiver as it arrives instead of buffering it.
+      // The result carries the status and headers with an empty body. Error replies never reach the receiver.
+      [[nodiscard]] httplib::Result GetStream(const std::string& path,
+                                              const httplib::Headers& headers,
+                                              httplib::ContentReceiver receiver);
+      [[nodiscard]] httplib::Result PostStream(const std::string& path,
+                                               const httplib::Headers& headers,
+                                               const std::string& body,
+                                               const std::string& contentType,
+                                               httplib::ContentReceiver receiver);
+
+      // Async requests are queued on the api worker pool so several can be in flight to the server at once
+      [[nodiscard]] std::future<httplib::Result> GetAsync(std::string path, httplib::Headers headers);
+      [[nodiscard]] std::future<httplib::Result> PostAsync(std::string path, httplib::Headers headers);
+
+      // Runs any api function on the worker pool. Arguments must be captured by value.
+      // The function runs under the run deadline of the calling thread.
+      template <typename F>
+      [[nodiscard]] auto RunAsync(F&& func)
+      {
+         return executor_.Submit([deadline = ApiDeadline::Get(), func = std::forward<F>(func)]() mutable {
+            ApiDeadlineScope deadlineScope(deadline);
+            return func();
+         });
+      }
+
+      // Concurrent calls with the same key share one run of the function and its parsed result.
+      // The key should be the method and url of the request the function sends.
+      template <typename T, typename F>
+      [[nodiscard]] std::shared_ptr<const T> RunSingleFlight(const std::string& key, F&& func)
+      {
+         // The type is part of the key so a url parsed into different results never shares a flight
+         auto result = parsedFlights_.Run(std::format("{} {}", typeid(T).name(), key), [&func]() -> std::shared_ptr<const void> {
+            return func();
+         });
+         return std::static_pointer_cast<const T>(result);
+      }
+
+      // Returns the body of a GET request or nullptr on failure. Bodies are served from the cache until the ttl expires.
+      // Expired entries are revalidated with If-None-Match/If-Modified-Since when the server supplied an ETag or Last-Modified.
+      // Concurrent callers missing the cache for the same url share one request.
+      [[nodiscard]] std::shared_ptr<const std::string> GetCached(std::string_view name,
+                                                                 const std::string& path,
+                                                                 const httplib::Headers& headers,
+                                                                 std::chrono::seconds ttl);
+
+      // Returns if the http request was successful and outputs to the log if not successful
+      bool IsHttpSuccess(std::string_view name, const httplib::Result& result, bool log = true);
+
+      // Returns if a streamed request succeeded and the whole array was read. Outputs to the log if not.
+      bool IsJsonStreamSuccess(std::string_view name, const httplib::Result& result, const JsonArrayStream& stream);
+
+      // Stops the worker pool. Derived api's call this first in their destructor so no queued work
+      // runs against members that are already destroyed.
+      void Shutdown();
+
+   private:
+      [[nodiscard]] std::shared_ptr<const std::string> GetCachedFromServer(std::string_view name,
+                                                                           const std::string& path,
+                                                                           const httplib::Headers& headers,
+                                                                           std::chrono::seconds ttl,
+                                                                           std::optional<ApiCacheEntry> entry);
+
+      // Sends until the request succeeds, fails for good, runs out of attempts or the next wait would pass the run deadline.
+      // Streamed requests pass the count of body bytes handed to their receiver and are only sent again while it is 0.
+      [[nodiscard]] httplib::Result SendWithRetry(std::string_view method,
+                                                  const std::string& path,
+                                                  size_t bytesSent,
+                                                  const std::function<httplib::Result()>& send,
+                                                  const size_t* streamedBytes = nullptr);
+
+      // Sets bodyAccepted for each reply so streamed requests only pass on the body of a successful one
+      [[nodiscard]] static httplib::ResponseHandler GetStreamResponseHandler(bool& bodyAccepted);
+
+      void RecordTransfer(const httplib::Result& result, size_t bodyBytes);
+      void LogTransferStats();
+
+      void SetOnline(bool online, bool probed);
+
+      std::string className_;
+      std::string name_;
+      std::string url_;
+      std::string apiKey_;
+      std::chrono::seconds cacheTtl_;
+
+      // Pool size caps the requests in flight and the token bucket paces them
+      ApiClientPool clientPool_;
+      ApiRateLimiter rateLimiter_;
+      ApiResponseCache responseCache_;
+
+      ApiSingleFlight<std::shared_ptr<const std::string>> getFlights_;
+      ApiSingleFlight<std::shared_ptr<const void>> parsedFlights_;
+
+      std::atomic<uint64_t> replies_{0u};
+      std::atomic<uint64_t> compressedReplies_{0u};
+      std::atomic<uint64_t> bodyBytes_{0u};
+      std::atomic<uint64_t> wireBytes_{0u};
+      std::atomic<uint64_t> wireBodyBytes_{0u};
+
+      ApiRetryPolicy retryPolicy_;
+      std::atomic<uint64_t> retries_{0u};
+
+      ApiRequestMetrics requestMetrics_;
+
+      std::atomic<uint64_t> cacheHits_{0u};
+      std::atomic<uint64_t> cacheRevalidated_{0u};
+      std::atomic<uint64_t> cacheMisses_{0u};
+
+      // Read on every GetValid so kept apart from the rest of the health
+      std::atomic<bool> online_{false};
+      std::atomic<bool> probed_{false};
+      ApiHealth health_;
+      std::chrono::steady_clock::time_point nextHealthProbe_;
+      mutable std::mutex healthLock_;
+
+      // Declared last so the workers are stopped before anything they use is destroyed
+      ApiExecutor executor_;
+   };
 }
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include "api-client-pool.h"
+
+#include <algorithm>
+
+namespace loomis
+{
+   namespace
+   {
+      constexpr time_t CONNECTION_TIMEOUT_SEC{5};
+   }
+
+   ApiClientPool::Lease::Lease(ApiClientPool& pool, std::unique_ptr<httplib::Client> client)
+      : pool_(&pool)
+      , client_(std::move(client))
+   {
+   }
+
+   ApiClientPool::Lease::~Lease()
+   {
+      if (pool_ && client_) pool_->Release(std::move(client_));
+   }
+
+   httplib::Client* ApiClientPool::Lease::operator->() const
+   {
+      return client_.get();
+   }
+
+   httplib::Client& ApiClientPool::Lease::operator*() const
+   {
+      return *client_;
+   }
+
+   ApiClientPool::ApiClientPool(std::string_view url, size_t maxClients, bool compression)
+      : url_(url)
+      , maxClients_(std::max<size_t>(maxClients, 1u))
+      , compression_(compression)
+   {
+      idleClients_.reserve(maxClients_);
+   }
+
+   std::unique_ptr<httplib::Client> ApiClientPool::CreateClient() const
+   {
+      auto client = std::make_unique<httplib::Client>(url_);
+      client->set_connection_timeout(CONNECTION_TIMEOUT_SEC);
+      client->set_keep_alive(true);
+
+      // httplib only sends Accept-Encoding when it is allowed to decompress the reply
+      client->set_decompress(compression_);
+      return client;
+   }
+
+   ApiClientPool::Lease ApiClientPool::Acquire()
+   {
+      std::unique_lock lock(lock_);
+      cv_.wait(lock, [this] { return !idleClients_.empty() || createdClients_ < maxClients_; });
+
+      if (!idleClients_.empty())
+      {
+         auto client = std::move(idleClients_.back());
+         idleClients_.pop_back();
+         return Lease(*this, std::move(client));
+      }
+
+      // Reserve the slot before releasing the lock so the pool never grows past the max
+      ++createdClients_;
+      lock.unlock();
+      return Lease(*this, CreateClient());
+   }
+
+   void ApiClientPool::Release(std::unique_ptr<httplib::Client> client)
+   {
+      {
+         std::lock_guard lock(lock_);
+         idleClients_.emplace_back(std::move(client));
+      }
+      cv_.notify_one();
+   }
+
+   size_t ApiClientPool::GetMaxClients() const
+   {
+      return maxClients_;
+   }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <httplib.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace loomis
+{
+   // Bounded pool of persistent (keep-alive) connections to a single server.
+   // httplib::Client is not thread safe so each client is only ever used by the thread holding its lease.
+   class ApiClientPool
+   {
+   public:
+      // With compression on the clients ask for gzip/deflate replies when built with zlib support
+      ApiClientPool(std::string_view url, size_t maxClients, bool compression = true);
+
+      // RAII handle to a checked out client. The client is returned to the pool on destruction.
+      class Lease
+      {
+      public:
+         Lease(ApiClientPool& pool, std::unique_ptr<httplib::Client> client);
+         Lease(Lease&& other) noexcept = default;
+         Lease(const Lease&) = delete;
+         Lease& operator=(const Lease&) = delete;
+         Lease& operator=(Lease&&) = delete;
+         ~Lease();
+
+         httplib::Client* operator->() const;
+         httplib::Client& operator*() const;
+
+      private:
+         ApiClientPool* pool_{nullptr};
+         std::unique_ptr<httplib::Client> client_;
+      };
+
+      // Blocks until a client is available or a new connection can be created
+      [[nodiscard]] Lease Acquire();
+
+      [[nodiscard]] size_t GetMaxClients() const;
+
+   private:
+      void Release(std::unique_ptr<httplib::Client> client);
+      [[nodiscard]] std::unique_ptr<httplib::Client> CreateClient() const;
+
+      std::string url_;
+      size_t maxClients_{1u};
+      bool compression_{true};
+      size_t createdClients_{0u};
+
+      std::vector<std::unique_ptr<httplib::Client>> idleClients_;
+      std::mutex lock_;
+      std::condition_variable cv_;
+   };
+}
@@ -1,92 +1,94 @@
-#pragma once
-
-#include <string>
-#include <vector>
-
-namespace loomis
-{
-   struct JsonServerResponse
-   {
-      std::string ServerName;
-   };
-
-   struct JsonEmbyItem
-   {
-      std::string Id;
-      std::string Type;
-      std::string Name;
-      std::string Path;
-      std::string SeriesName;
-      uint32_t ParentIndexNumber{0};
-      uint32_t IndexNumber{0};
-      uint64_t RunTimeTicks{0};
-   };
-
-   struct JsonEmbyItemsResponse
-   {
-      std::vector<JsonEmbyItem> Items;
-   };
-
-   struct PathRebuildItem
-   {
-      std::string Id;
-      std::string Path;
-      std::string DateModified;
-   };
-
-   struct PathRebuildItems
-   {
-      std::vector<PathRebuildItem> Items;
-   };
-
-   struct JsonEmbyPlaylistItem
-   {
-      std::string Id;
-      std::string Name;
-      std::string PlaylistItemId;
-   };
-
-   struct JsonEmbyPlaylistItemsResponse
-   {
-      std::vector<JsonEmbyPlaylistItem> Items;
-   };
-
-   struct JsonEmbyUser
-   {
-      std::string Name;
-      std::string Id;
-   };
-
-   struct JsonEmbyLibrary
-   {
-      std::string Name;
-      std::string Id;
-   };
-
-   struct JsonTotalRecordCount
-   {
-      int32_t TotalRecordCount;
-   };
-
-   struct JsonEmbyPlaystateUserData
-   {
-      float PlayedPercentage{0.0f};
-      int64_t PlaybackPositionTicks{0};
-      int32_t PlayCount{0};
-      bool Played{false};
-   };
-
-   struct JsonEmbyPlaystate
-   {
-      std::string Name;
-      std::string Type;
-      std::string Path;
-      int64_t RunTimeTicks{0};
-      JsonEmbyPlaystateUserData UserData;
-   };
-
-   struct JsonEmbyPlayStates
-   {
-      std::vector<JsonEmbyPlaystate> Items;
-   };
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace loomis
+{
+   struct JsonServerResponse
+   {
+      std::string ServerName;
+   };
+
+   // The bulk item replies are decoded without copies. The string views point at the raw JSON text
+   // in the reply body so they are only valid while the body is and must be read with GetJsonString.
+   struct JsonEmbyItem
+   {
+      std::string_view Id;
+      std::string_view Type;
+      std::string_view Name;
+      std::string_view Path;
+      std::string_view SeriesName;
+      uint32_t ParentIndexNumber{0};
+      uint32_t IndexNumber{0};
+      uint64_t RunTimeTicks{0};
+   };
+
+   struct JsonEmbyItemsResponse
+   {
+      std::vector<JsonEmbyItem> Items;
+   };
+
+   struct PathRebuildItem
+   {
+      std::string_view Id;
+      std::string_view Path;
+      std::string_view DateLastSaved;
+
+      // Only asked for by the delta to tell new items from moved ones
+      std::string_view DateCreated;
+   };
+
+   struct JsonEmbyPlaylistItem
+   {
+      std::string_view Id;
+      std::string_view Name;
+      std::string_view PlaylistItemId;
+   };
+
+   struct JsonEmbyPlaylistItemsResponse
+   {
+      std::vector<JsonEmbyPlaylistItem> Items;
+   };
+
+   struct JsonEmbyUser
+   {
+      std::string Name;
+      std::string Id;
+   };
+
+   struct JsonEmbyLibrary
+   {
+      std::string Name;
+      std::string Id;
+   };
+
+   struct JsonTotalRecordCount
+   {
+      int32_t TotalRecordCount{0};
+   };
+
+   struct JsonEmbyPlaystateUserData
+   {
+      float PlayedPercentage{0.0f};
+      int64_t PlaybackPositionTicks{0};
+      int32_t PlayCount{0};
+      bool Played{false};
+   };
+
+   struct JsonEmbyPlaystate
+   {
+      std::string Id;
+      std::string Name;
+      std::string Type;
+      std::string Path;
+      int64_t RunTimeTicks{0};
+      JsonEmbyPlaystateUserData UserData;
+   };
+
+   struct JsonEmbyPlayStates
+   {
+      std::vector<JsonEmbyPlaystate> Items;
+   };
 }
\ No newline at end of file
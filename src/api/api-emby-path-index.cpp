@@ -0,0 +1,304 @@
+#include "api-emby-path-index.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ranges>
+
+namespace loomis
+{
+   namespace
+   {
+      constexpr uint32_t INDEX_MAGIC{0x58495050u}; // "PPIX"
+      constexpr uint32_t INDEX_VERSION{1u};
+
+      constexpr size_t HEADER_FIELDS{6u};
+      constexpr size_t HEADER_SIZE{HEADER_FIELDS * sizeof(uint32_t)};
+
+      // Number of paths front coded against the first path of a bucket
+      constexpr size_t BUCKET_SIZE{16u};
+
+      // Ids that are not plain numbers are stored in the arena. The id value is then
+      // the arena flag, the arena offset and the id length packed together.
+      constexpr uint64_t ID_ARENA_FLAG{1ull << 63};
+      constexpr uint64_t ID_ARENA_LENGTH_BITS{16u};
+      constexpr uint64_t ID_ARENA_LENGTH_MASK{(1ull << ID_ARENA_LENGTH_BITS) - 1};
+      constexpr size_t MAX_NUMERIC_ID_DIGITS{18u};
+
+      template <typename T>
+      T ReadValue(std::span<const char> data, size_t offset)
+      {
+         T value;
+         std::memcpy(&value, data.data() + offset, sizeof(T));
+         return value;
+      }
+
+      template <typename T>
+      void AppendValue(std::vector<char>& buffer, T value)
+      {
+         const auto* bytes = reinterpret_cast<const char*>(&value);
+         buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+      }
+
+      void AppendVarint(std::vector<char>& buffer, size_t value)
+      {
+         while (value >= 0x80)
+         {
+            buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+         }
+         buffer.push_back(static_cast<char>(value));
+      }
+
+      // Returns false if the varint runs past the end of the data
+      bool ReadVarint(std::span<const char> data, size_t& offset, size_t& value)
+      {
+         value = 0;
+         for (size_t shift = 0; offset < data.size() && shift < 64; shift += 7)
+         {
+            auto byte = static_cast<uint8_t>(data[offset++]);
+            value |= static_cast<size_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) return true;
+         }
+         return false;
+      }
+
+      std::optional<uint64_t> ParseNumericId(std::string_view id)
+      {
+         // Leading zeros would be lost when converted back to a string
+         if (id.empty() || id.size() > MAX_NUMERIC_ID_DIGITS || (id.size() > 1 && id[0] == '0')) return std::nullopt;
+
+         uint64_t value{0};
+         for (char c : id)
+         {
+            if (c < '0' || c > '9') return std::nullopt;
+            value = (value * 10) + static_cast<uint64_t>(c - '0');
+         }
+         return value;
+      }
+   }
+
+   EmbyPathIndex EmbyPathIndex::Build(Entries entries)
+   {
+      std::ranges::stable_sort(entries, {}, &Entries::value_type::first);
+      auto [newEnd, _] = std::ranges::unique(entries, {}, &Entries::value_type::first);
+      entries.erase(newEnd, entries.end());
+
+      std::vector<char> bucketOffsets;
+      std::vector<char> ids;
+      std::vector<char> idArena;
+      std::vector<char> pathData;
+
+      bucketOffsets.reserve(((entries.size() + BUCKET_SIZE - 1) / BUCKET_SIZE) * sizeof(uint32_t));
+      ids.reserve(entries.size() * sizeof(uint64_t));
+
+      std::string_view previousPath;
+      for (size_t i = 0; i < entries.size(); ++i)
+      {
+         std::string_view path{entries[i].first};
+         std::string_view id{entries[i].second};
+
+         if (i % BUCKET_SIZE == 0)
+         {
+            AppendValue<uint32_t>(bucketOffsets, static_cast<uint32_t>(pathData.size()));
+            AppendVarint(pathData, path.size());
+            pathData.insert(pathData.end(), path.begin(), path.end());
+         }
+         else
+         {
+            auto sharedLength = static_cast<size_t>(std::ranges::mismatch(previousPath, path).in1 - previousPath.begin());
+            AppendVarint(pathData, sharedLength);
+            AppendVarint(pathData, path.size() - sharedLength);
+            pathData.insert(pathData.end(), path.begin() + sharedLength, path.end());
+         }
+         previousPath = path;
+
+         if (auto numericId = ParseNumericId(id))
+         {
+            AppendValue<uint64_t>(ids, *numericId);
+         }
+         else
+         {
+            auto length = std::min<uint64_t>(id.size(), ID_ARENA_LENGTH_MASK);
+            AppendValue<uint64_t>(ids, ID_ARENA_FLAG | (static_cast<uint64_t>(idArena.size()) << ID_ARENA_LENGTH_BITS) | length);
+            idArena.insert(idArena.end(), id.begin(), id.begin() + length);
+         }
+      }
+
+      auto buffer = std::make_shared<std::vector<char>>();
+      buffer->reserve(HEADER_SIZE + bucketOffsets.size() + ids.size() + idArena.size() + pathData.size());
+
+      AppendValue<uint32_t>(*buffer, INDEX_MAGIC);
+      AppendValue<uint32_t>(*buffer, INDEX_VERSION);
+      AppendValue<uint32_t>(*buffer, static_cast<uint32_t>(entries.size()));
+      AppendValue<uint32_t>(*buffer, static_cast<uint32_t>(bucketOffsets.size() / sizeof(uint32_t)));
+      AppendValue<uint32_t>(*buffer, static_cast<uint32_t>(idArena.size()));
+      AppendValue<uint32_t>(*buffer, static_cast<uint32_t>(pathData.size()));
+      buffer->insert(buffer->end(), bucketOffsets.begin(), bucketOffsets.end());
+      buffer->insert(buffer->end(), ids.begin(), ids.end());
+      buffer->insert(buffer->end(), idArena.begin(), idArena.end());
+      buffer->insert(buffer->end(), pathData.begin(), pathData.end());
+
+      std::span<const char> data{buffer->data(), buffer->size()};
+      return FromBuffer(std::move(buffer), data).value_or(EmbyPathIndex{});
+   }
+
+   std::optional<EmbyPathIndex> EmbyPathIndex::FromBuffer(std::shared_ptr<const void> owner, std::span<const char> data)
+   {
+      if (data.size() < HEADER_SIZE) return std::nullopt;
+      if (ReadValue<uint32_t>(data, 0) != INDEX_MAGIC || ReadValue<uint32_t>(data, 4) != INDEX_VERSION) return std::nullopt;
+
+      EmbyPathIndex index;
+      index.itemCount_ = ReadValue<uint32_t>(data, 8);
+      index.bucketCount_ = ReadValue<uint32_t>(data, 12);
+      const size_t idArenaSize = ReadValue<uint32_t>(data, 16);
+      const size_t pathDataSize = ReadValue<uint32_t>(data, 20);
+
+      if (index.bucketCount_ != (index.itemCount_ + BUCKET_SIZE - 1) / BUCKET_SIZE) return std::nullopt;
+
+      const size_t bucketOffsetsSize = static_cast<size_t>(index.bucketCount_) * sizeof(uint32_t);
+      const size_t idsSize = static_cast<size_t>(index.itemCount_) * sizeof(uint64_t);
+      if (data.size() != HEADER_SIZE + bucketOffsetsSize + idsSize + idArenaSize + pathDataSize) return std::nullopt;
+
+      size_t offset{HEADER_SIZE};
+      index.bucketOffsets_ = data.subspan(offset, bucketOffsetsSize);
+      offset += bucketOffsetsSize;
+      index.ids_ = data.subspan(offset, idsSize);
+      offset += idsSize;
+      index.idArena_ = data.subspan(offset, idArenaSize);
+      offset += idArenaSize;
+      index.pathData_ = data.subspan(offset, pathDataSize);
+
+      index.owner_ = std::move(owner);
+      index.data_ = data;
+      return index;
+   }
+
+   size_t EmbyPathIndex::EstimatePathMapMemory(const Entries& entries)
+   {
+      // Each node holds the pair, the next pointer and the cached hash plus one bucket pointer per entry.
+      // Strings longer than the small string buffer allocate their characters separately.
+      const size_t smallStringCapacity = std::string().capacity();
+      size_t total = entries.size() * (sizeof(std::pair<std::string, std::string>) + (3 * sizeof(void*)));
+      for (const auto& [path, id] : entries)
+      {
+         if (path.size() > smallStringCapacity) total += path.size() + 1;
+         if (id.size() > smallStringCapacity) total += id.size() + 1;
+      }
+      return total;
+   }
+
+   std::string_view EmbyPathIndex::GetBucketFirstPath(size_t bucket) const
+   {
+      size_t offset = ReadValue<uint32_t>(bucketOffsets_, bucket * sizeof(uint32_t));
+      size_t length{0};
+      if (!ReadVarint(pathData_, offset, length) || length > pathData_.size() - offset) return {};
+      return {pathData_.data() + offset, length};
+   }
+
+   std::optional<size_t> EmbyPathIndex::FindIndex(std::string_view path) const
+   {
+      if (bucketCount_ == 0) return std::nullopt;
+
+      // Binary search for the last bucket whose first path is not greater than the path
+      size_t low{0};
+      size_t high{bucketCount_};
+      while (low < high)
+      {
+         auto mid = low + ((high - low) / 2);
+         if (GetBucketFirstPath(mid) <= path)
+         {
+            low = mid + 1;
+         }
+         else
+         {
+            high = mid;
+         }
+      }
+      if (low == 0) return std::nullopt;
+
+      // Walk the bucket rebuilding each front coded path
+      const size_t bucket = low - 1;
+      const size_t first = bucket * BUCKET_SIZE;
+      const size_t last = std::min<size_t>(first + BUCKET_SIZE, itemCount_);
+      size_t offset = ReadValue<uint32_t>(bucketOffsets_, bucket * sizeof(uint32_t));
+
+      std::string current;
+      for (size_t i = first; i < last; ++i)
+      {
+         size_t sharedLength{0};
+         size_t suffixLength{0};
+         if (i != first && !ReadVarint(pathData_, offset, sharedLength)) return std::nullopt;
+         if (!ReadVarint(pathData_, offset, suffixLength)) return std::nullopt;
+         if (sharedLength > current.size() || suffixLength > pathData_.size() - offset) return std::nullopt;
+
+         current.resize(sharedLength);
+         current.append(pathData_.data() + offset, suffixLength);
+         offset += suffixLength;
+
+         // Paths are sorted so once past the path it can not be in the index
+         auto compare = std::string_view(current).compare(path);
+         if (compare == 0) return i;
+         if (compare > 0) return std::nullopt;
+      }
+
+      return std::nullopt;
+   }
+
+   std::string EmbyPathIndex::GetId(size_t index) const
+   {
+      auto value = ReadValue<uint64_t>(ids_, index * sizeof(uint64_t));
+      if ((value & ID_ARENA_FLAG) == 0) return std::to_string(value);
+
+      auto arenaOffset = static_cast<size_t>((value & ~ID_ARENA_FLAG) >> ID_ARENA_LENGTH_BITS);
+      auto length = static_cast<size_t>(value & ID_ARENA_LENGTH_MASK);
+      if (arenaOffset > idArena_.size() || length > idArena_.size() - arenaOffset) return {};
+      return {idArena_.data() + arenaOffset, length};
+   }
+
+   std::optional<std::string> EmbyPathIndex::Find(std::string_view path) const
+   {
+      auto index = FindIndex(path);
+      if (!index) return std::nullopt;
+      return GetId(*index);
+   }
+
+   bool EmbyPathIndex::Contains(std::string_view path) const
+   {
+      return FindIndex(path).has_value();
+   }
+
+   bool EmbyPathIndex::Empty() const
+   {
+      return itemCount_ == 0;
+   }
+
+   size_t EmbyPathIndex::Size() const
+   {
+      return itemCount_;
+   }
+
+   size_t EmbyPathIndex::GetMemoryUsage() const
+   {
+      return data_.size();
+   }
+
+   std::span<const char> EmbyPathIndex::GetData() const
+   {
+      return data_;
+   }
+
+   std::optional<std::string> EmbyPathMapSnapshot::Find(const std::string& path) const
+   {
+      // Recently patched items take priority over the rebuilt index
+      if (auto it = delta.find(path); it != delta.end())
+      {
+         return it->second;
+      }
+      return index.Find(path);
+   }
+
+   bool EmbyPathMapSnapshot::Empty() const
+   {
+      return index.Empty() && delta.empty();
+   }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "api/api-emby-types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace loomis
+{
+   // Read only path -> id index stored in a single flat buffer.
+   // Paths are sorted and front coded in buckets so the shared /media/... prefixes are stored once per bucket.
+   // Numeric Emby ids are stored as integers with a string arena fallback for any other id format.
+   //
+   // Buffer layout (integers in native byte order)
+   //    header         : magic, version, itemCount, bucketCount, idArenaSize, pathDataSize (uint32 each)
+   //    bucket offsets : uint32[bucketCount] offset into the path data of each buckets first path
+   //    ids            : uint64[itemCount]
+   //    id arena       : char[idArenaSize]
+   //    path data      : char[pathDataSize]
+   //       first path of a bucket : varint length, bytes
+   //       other paths            : varint shared prefix length, varint suffix length, suffix bytes
+   class EmbyPathIndex
+   {
+   public:
+      // Path, id pairs. The views only have to stay valid until Build returns.
+      using Entries = std::vector<std::pair<std::string_view, std::string_view>>;
+
+      EmbyPathIndex() = default;
+
+      // Builds an index from path, id pairs. If a path is duplicated the first id is kept.
+      [[nodiscard]] static EmbyPathIndex Build(Entries entries);
+
+      // Creates an index over an existing buffer. The owner keeps the buffer memory alive.
+      // Returns nullopt if the buffer is not a valid index.
+      [[nodiscard]] static std::optional<EmbyPathIndex> FromBuffer(std::shared_ptr<const void> owner, std::span<const char> data);
+
+      // Rough size of the same entries held in an std::unordered_map. Used to report the memory saved.
+      [[nodiscard]] static size_t EstimatePathMapMemory(const Entries& entries);
+
+      [[nodiscard]] std::optional<std::string> Find(std::string_view path) const;
+      [[nodiscard]] bool Contains(std::string_view path) const;
+
+      [[nodiscard]] bool Empty() const;
+      [[nodiscard]] size_t Size() const;
+      [[nodiscard]] size_t GetMemoryUsage() const;
+      [[nodiscard]] std::span<const char> GetData() const;
+
+   private:
+      // Returns the item index for the path if found
+      [[nodiscard]] std::optional<size_t> FindIndex(std::string_view path) const;
+      [[nodiscard]] std::string_view GetBucketFirstPath(size_t bucket) const;
+      [[nodiscard]] std::string GetId(size_t index) const;
+
+      std::shared_ptr<const void> owner_;
+      std::span<const char> data_;
+
+      uint32_t itemCount_{0u};
+      uint32_t bucketCount_{0u};
+      std::span<const char> bucketOffsets_;
+      std::span<const char> ids_;
+      std::span<const char> idArena_;
+      std::span<const char> pathData_;
+   };
+   // Immutable state of a path map. Updates publish a new snapshot so lookups never wait on an update
+   // and always see an index and delta that belong together.
+   struct EmbyPathMapSnapshot
+   {
+      EmbyPathIndex index;
+
+      // Items patched in by quick checks since the last full rebuild
+      EmbyPathMap delta;
+
+      // Newest DateLastSaved seen by the map
+      std::string lastSyncTimestamp;
+
+      // Number of items the map has seen. Compared to the server count to detect deletes.
+      uint32_t itemCount{0u};
+
+      [[nodiscard]] std::optional<std::string> Find(const std::string& path) const;
+      [[nodiscard]] bool Empty() const;
+   };
+}
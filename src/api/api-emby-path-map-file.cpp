@@ -0,0 +1,149 @@
+#include "api-emby-path-map-file.h"
+
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <system_error>
+#include <vector>
+
+#if defined(_WIN32)
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace loomis
+{
+   namespace
+   {
+      constexpr uint32_t FILE_MAGIC{0x4D50504Cu}; // "LPPM"
+      constexpr uint32_t FILE_VERSION{2u}; // 2: timestamp is DateLastSaved
+      constexpr size_t HEADER_SIZE{(4 * sizeof(uint32_t)) + (2 * sizeof(uint64_t))};
+
+      constexpr uint64_t FNV_OFFSET_BASIS{14695981039346656037ull};
+      constexpr uint64_t FNV_PRIME{1099511628211ull};
+
+      uint64_t Fnv1a(std::span<const char> data, uint64_t hash = FNV_OFFSET_BASIS)
+      {
+         for (char c : data)
+         {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= FNV_PRIME;
+         }
+         return hash;
+      }
+
+      template <typename T>
+      T ReadValue(std::span<const char> data, size_t offset)
+      {
+         T value;
+         std::memcpy(&value, data.data() + offset, sizeof(T));
+         return value;
+      }
+
+      template <typename T>
+      void WriteValue(std::ofstream& stream, T value)
+      {
+         stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+      }
+
+      // Returns the owner of the file contents along with a view of them
+      std::optional<std::pair<std::shared_ptr<const void>, std::span<const char>>> MapFile(const std::filesystem::path& file)
+      {
+#if defined(_WIN32)
+         // No mmap on windows builds. Read the file into memory instead.
+         std::ifstream stream(file, std::ios::in | std::ios::binary);
+         if (!stream.is_open()) return std::nullopt;
+
+         auto buffer = std::make_shared<std::vector<char>>(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+         std::span<const char> data{buffer->data(), buffer->size()};
+         return std::make_pair(std::shared_ptr<const void>(std::move(buffer)), data);
+#else
+         int fd = ::open(file.c_str(), O_RDONLY);
+         if (fd < 0) return std::nullopt;
+
+         struct stat fileStat{};
+         if (::fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0)
+         {
+            ::close(fd);
+            return std::nullopt;
+         }
+
+         auto size = static_cast<size_t>(fileStat.st_size);
+         void* address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+         // The mapping stays valid after the descriptor is closed
+         ::close(fd);
+         if (address == MAP_FAILED) return std::nullopt;
+
+         std::shared_ptr<const void> owner(address, [size](const void* mapped) {
+            ::munmap(const_cast<void*>(mapped), size);
+         });
+         return std::make_pair(std::move(owner), std::span<const char>(static_cast<const char*>(address), size));
+#endif
+      }
+   }
+
+   std::optional<EmbyPathMapFile> LoadEmbyPathMapFile(const std::filesystem::path& file)
+   {
+      auto mapped = MapFile(file);
+      if (!mapped) return std::nullopt;
+
+      auto& [owner, data] = *mapped;
+      if (data.size() < HEADER_SIZE) return std::nullopt;
+      if (ReadValue<uint32_t>(data, 0) != FILE_MAGIC || ReadValue<uint32_t>(data, 4) != FILE_VERSION) return std::nullopt;
+
+      auto itemCount = ReadValue<uint32_t>(data, 8);
+      auto timestampSize = static_cast<size_t>(ReadValue<uint32_t>(data, 12));
+      auto indexSize = ReadValue<uint64_t>(data, 16);
+      auto checksum = ReadValue<uint64_t>(data, 24);
+
+      auto payload = data.subspan(HEADER_SIZE);
+      if (payload.size() != timestampSize + indexSize || Fnv1a(payload) != checksum) return std::nullopt;
+
+      auto index = EmbyPathIndex::FromBuffer(owner, payload.subspan(timestampSize));
+      if (!index) return std::nullopt;
+
+      return EmbyPathMapFile{
+         .index = std::move(*index),
+         .lastSyncTimestamp = std::string(payload.data(), timestampSize),
+         .itemCount = itemCount
+      };
+   }
+
+   bool SaveEmbyPathMapFile(const std::filesystem::path& file, const EmbyPathMapFile& pathMapFile)
+   {
+      std::error_code ec;
+      std::filesystem::create_directories(file.parent_path(), ec);
+      if (ec) return false;
+
+      auto tempFile = file;
+      tempFile += ".tmp";
+
+      auto indexData = pathMapFile.index.GetData();
+      std::span<const char> timestamp{pathMapFile.lastSyncTimestamp.data(), pathMapFile.lastSyncTimestamp.size()};
+
+      {
+         std::ofstream stream(tempFile, std::ios::out | std::ios::binary | std::ios::trunc);
+         if (!stream.is_open()) return false;
+
+         WriteValue<uint32_t>(stream, FILE_MAGIC);
+         WriteValue<uint32_t>(stream, FILE_VERSION);
+         WriteValue<uint32_t>(stream, pathMapFile.itemCount);
+         WriteValue<uint32_t>(stream, static_cast<uint32_t>(timestamp.size()));
+         WriteValue<uint64_t>(stream, indexData.size());
+         WriteValue<uint64_t>(stream, Fnv1a(indexData, Fnv1a(timestamp)));
+         stream.write(timestamp.data(), static_cast<std::streamsize>(timestamp.size()));
+         stream.write(indexData.data(), static_cast<std::streamsize>(indexData.size()));
+
+         if (!stream.good()) return false;
+      }
+
+      std::filesystem::rename(tempFile, file, ec);
+      return !ec;
+   }
+}
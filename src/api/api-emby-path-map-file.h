@@ -0,0 +1,36 @@
+#pragma once
+
+#include "api/api-emby-path-index.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+namespace loomis
+{
+   // Versioned on disk copy of an Emby path map so startup does not have to download the whole library.
+   //
+   // File layout (integers in native byte order)
+   //    magic, version, itemCount, timestampSize (uint32 each), indexSize, checksum (uint64 each)
+   //    timestamp bytes followed by the EmbyPathIndex buffer
+   //
+   // The checksum is a 64 bit FNV-1a of the timestamp and index bytes.
+   struct EmbyPathMapFile
+   {
+      EmbyPathIndex index;
+
+      // Newest DateLastSaved seen when the index was built
+      std::string lastSyncTimestamp;
+
+      // Server item count when the index was built
+      uint32_t itemCount{0u};
+   };
+
+   // Memory maps the file so the index is used in place. Returns nullopt if the file is missing,
+   // from another version or fails the checksum.
+   [[nodiscard]] std::optional<EmbyPathMapFile> LoadEmbyPathMapFile(const std::filesystem::path& file);
+
+   // Writes to a temporary file and renames it over the old file so a crash never leaves a partial snapshot
+   bool SaveEmbyPathMapFile(const std::filesystem::path& file, const EmbyPathMapFile& pathMapFile);
+}
@@ -1,65 +1,92 @@
-#pragma once
-
-#include <cstdint>
-#include <string>
-#include <unordered_map>
-#include <vector>
-
-namespace loomis
-{
-   using EmbyPathMap = std::unordered_map<std::string, std::string>;
-
-   enum class EmbySearchType
-   {
-      id,
-      name,
-      path
-   };
-
-   struct EmbyItemSeries
-   {
-      std::string name;
-      uint32_t seasonNum{0u};
-      uint32_t episodeNum{0u};
-   };
-
-   struct EmbyItem
-   {
-      std::string name;
-      std::string id;
-      std::string path;
-      std::string type;
-      EmbyItemSeries series;
-      uint64_t runTimeTicks{0u};
-   };
-
-   struct EmbyPlaylistItem
-   {
-      std::string name;
-      std::string id;
-      std::string playlistId;
-   };
-
-   struct EmbyPlaylist
-   {
-      std::string name;
-      std::string id;
-      std::vector<EmbyPlaylistItem> items;
-   };
-
-   struct EmbyUserData
-   {
-      std::string name;
-      std::string id;
-   };
-
-   struct EmbyPlayState
-   {
-      std::string path;
-      float percentage{0.0f};
-      int64_t runTimeTicks{0};
-      int64_t playbackPositionTicks{0};
-      int32_t play_count{0};
-      bool played{false};
-   };
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace loomis
+{
+   using EmbyPathMap = std::unordered_map<std::string, std::string>;
+
+   // Size of the current path map for reporting
+   struct EmbyPathMapStats
+   {
+      size_t indexItems{0u};
+      size_t indexBytes{0u};
+
+      // Items patched in since the last rebuild. Bytes are an estimate of the map holding them.
+      size_t deltaItems{0u};
+      size_t deltaBytes{0u};
+   };
+
+   enum class EmbySearchType
+   {
+      id,
+      name,
+      path
+   };
+
+   struct EmbyItemSeries
+   {
+      std::string name;
+      uint32_t seasonNum{0u};
+      uint32_t episodeNum{0u};
+   };
+
+   struct EmbyItem
+   {
+      std::string name;
+      std::string id;
+      std::string path;
+      std::string type;
+      EmbyItemSeries series;
+      uint64_t runTimeTicks{0u};
+   };
+
+   struct EmbyPlaylistItem
+   {
+      std::string name;
+      std::string id;
+      std::string playlistId;
+   };
+
+   struct EmbyPlaylist
+   {
+      std::string name;
+      std::string id;
+      std::vector<EmbyPlaylistItem> items;
+   };
+
+   struct EmbyUserData
+   {
+      std::string name;
+      std::string id;
+   };
+
+   struct EmbyPlayState
+   {
+      std::string path;
+      float percentage{0.0f};
+      int64_t runTimeTicks{0};
+      int64_t playbackPositionTicks{0};
+      int32_t play_count{0};
+      bool played{false};
+   };
+
+   // Item id -> play state
+   using EmbyPlayStates = std::unordered_map<std::string, EmbyPlayState>;
+
+   // Compact watch state of one item for a user. Kept for every played or in progress item.
+   struct EmbyWatchState
+   {
+      int64_t runTimeTicks{0};
+      int64_t playbackPositionTicks{0};
+      float percentage{0.0f};
+      bool played{false};
+   };
+
+   // Item id -> watch state
+   using EmbyWatchStates = std::unordered_map<std::string, EmbyWatchState>;
 }
\ No newline at end of file
@@ -1,497 +1,891 @@
-#include "api-emby.h"
-
-#include "api/api-emby-json-types.h"
-#include "api/api-utils.h"
-#include "logger/log-utils.h"
-#include "types.h"
-
-#include <glaze/glaze.hpp>
-
-#include <format>
-#include <mutex>
-#include <numeric>
-#include <ranges>
-
-namespace loomis
-{
-   namespace
-   {
-      const std::string API_BASE{"/emby"};
-      const std::string API_TOKEN_NAME{"api_key"};
-
-      const std::string API_SYSTEM_INFO{"/System/Info"};
-      const std::string API_MEDIA_FOLDERS{"/Library/SelectableMediaFolders"};
-      const std::string API_ITEMS{"/Items"};
-      const std::string API_PLAYLISTS{"/Playlists"};
-      const std::string API_USERS{"/Users"};
-
-      constexpr std::string_view NAME{"Name"};
-      constexpr std::string_view IDS{"Ids"};
-      constexpr std::string_view PATH{"Path"};
-      constexpr std::string_view MEDIA_TYPE{"MediaType"};
-      constexpr std::string_view MOVIES{"Movies"};
-      constexpr std::string_view SEARCH_TERM{"SearchTerm"};
-      constexpr std::string_view ENTRY_IDS{"EntryIds"};
-   }
-
-   EmbyApi::EmbyApi(const ServerConfig& serverConfig)
-      : ApiBase(serverConfig.server_name, serverConfig.url, serverConfig.api_key, "EmbyApi", log::ANSI_CODE_EMBY)
-      , client_(GetUrl())
-      , mediaPath_(serverConfig.media_path)
-   {
-      constexpr time_t timeoutSec{5};
-      client_.set_connection_timeout(timeoutSec);
-
-      // If the service is valid run any needed tasks
-      if (GetValid()) BuildPathMap();
-   }
-
-   std::optional<std::vector<Task>> EmbyApi::GetTaskList()
-   {
-      std::vector<Task> tasks;
-
-      auto& quickCheck = tasks.emplace_back();
-      quickCheck.name = std::format("EmbyApi({}) - Path Map Quick Check", GetName());
-      quickCheck.cronExpression = "30 */5 * * * *";
-      quickCheck.func = [this]() {this->RunPathMapQuickCheck(); };
-
-      auto& fullUpdate = tasks.emplace_back();
-      fullUpdate.name = std::format("EmbyApi({}) - Path Map Full Update", GetName());
-      fullUpdate.cronExpression = "0 45 3 * * *";
-      fullUpdate.func = [this]() {this->RunPathMapFullUpdate(); };
-
-      return tasks;
-   }
-
-   std::string_view EmbyApi::GetApiBase() const
-   {
-      return API_BASE;
-   }
-
-   std::string_view EmbyApi::GetApiTokenName() const
-   {
-      return API_TOKEN_NAME;
-   }
-
-   bool EmbyApi::GetValid()
-   {
-      auto res = client_.Get(BuildApiPath(API_SYSTEM_INFO), emptyHeaders_);
-      return res.error() == httplib::Error::Success && res.value().status < VALID_HTTP_RESPONSE_MAX;
-   }
-
-   const std::string& EmbyApi::GetMediaPath() const
-   {
-      return mediaPath_;
-   }
-
-   std::optional<std::string> EmbyApi::GetServerReportedName()
-   {
-      auto res = client_.Get(BuildApiPath(API_SYSTEM_INFO), emptyHeaders_);
-
-      if (!IsHttpSuccess(__func__, res))
-      {
-         return std::nullopt;
-      }
-
-      JsonServerResponse serverResponse;
-      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (serverResponse, res.value().body))
-      {
-         LogWarning("{} - JSON Parse Error: {}",
-                    __func__, glz::format_error(ec, res.value().body));
-         return std::nullopt;
-      }
-
-      if (serverResponse.ServerName.empty())
-      {
-         return std::nullopt;
-      }
-      return std::move(serverResponse.ServerName);
-   }
-
-   std::optional<std::string> EmbyApi::GetLibraryId(std::string_view libraryName)
-   {
-      auto res = client_.Get(BuildApiPath(API_MEDIA_FOLDERS), emptyHeaders_);
-
-      if (!IsHttpSuccess(__func__, res)) return std::nullopt;
-
-      std::vector<JsonEmbyLibrary> jsonLibraries;
-      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (jsonLibraries, res.value().body))
-      {
-         LogWarning("{} - JSON Parse Error: {}",
-                    __func__, glz::format_error(ec, res.value().body));
-         return std::nullopt;
-      }
-
-      auto it = std::ranges::find_if(jsonLibraries, [&](const auto& lib) {
-         return lib.Name == libraryName;
-      });
-
-      if (it != jsonLibraries.end())
-      {
-         // Move the ID out of our temporary vector and return it
-         return std::move(it->Id);
-      }
-      return std::nullopt;
-   }
-
-   std::string_view EmbyApi::GetSearchTypeStr(EmbySearchType type)
-   {
-      switch (type)
-      {
-         case EmbySearchType::id:
-            return IDS;
-         case EmbySearchType::path:
-            return PATH;
-         default:
-            return SEARCH_TERM;
-      }
-   }
-
-   std::optional<EmbyItem> EmbyApi::GetItem(EmbySearchType type, std::string_view name, const ApiParams& extraSearchArgs)
-   {
-      ApiParams params = {
-         {"Recursive", "true"},
-         {GetSearchTypeStr(type), name},
-         {"Fields", "Path,SeriesName,RunTimeTicks"}
-      };
-      params.reserve(params.size() + extraSearchArgs.size());
-      params.insert(params.end(), extraSearchArgs.begin(), extraSearchArgs.end());
-
-      auto res{client_.Get(BuildApiParamsPath(API_ITEMS, params), emptyHeaders_)};
-      if (!IsHttpSuccess(__func__, res)) return std::nullopt;
-
-      JsonEmbyItemsResponse response;
-      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (response, res.value().body))
-      {
-         LogWarning("{} - JSON Parse Error: {}", __func__, glz::format_error(ec, res.value().body));
-         return std::nullopt;
-      }
-
-      // Use a lambda to find the specific item based on the search type
-      auto it = std::ranges::find_if(response.Items, [&](const JsonEmbyItem& item) {
-         switch (type)
-         {
-            case EmbySearchType::id:   return item.Id == name;
-            case EmbySearchType::path: return item.Path == name;
-            case EmbySearchType::name: return item.Name == name;
-            default: return false;
-         }
-      });
-
-      if (it != response.Items.end())
-      {
-         auto& match = *it;
-         EmbyItem returnItem;
-
-         // Move flat data
-         returnItem.id = std::move(match.Id);
-         returnItem.type = std::move(match.Type);
-         returnItem.name = std::move(match.Name);
-         returnItem.path = std::move(match.Path);
-         returnItem.runTimeTicks = match.RunTimeTicks;
-
-         // Populate nested series data
-         returnItem.series.name = std::move(match.SeriesName);
-         returnItem.series.seasonNum = match.ParentIndexNumber;
-         returnItem.series.episodeNum = match.IndexNumber;
-
-         return returnItem;
-      }
-
-      LogWarning("{} returned no valid results {}", __func__, log::GetTag("search", name));
-      return std::nullopt;
-   }
-
-   std::optional<EmbyUserData> EmbyApi::GetUser(std::string_view name)
-   {
-      auto res = client_.Get(BuildApiPath(API_USERS), emptyHeaders_);
-
-      if (!IsHttpSuccess(__func__, res)) return std::nullopt;
-
-      // Parse into a vector of our minimal user structs
-      std::vector<JsonEmbyUser> users;
-      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (users, res.value().body))
-      {
-         LogWarning("{} - JSON Parse Error: {}",
-                    __func__, glz::format_error(ec, res.value().body));
-         return std::nullopt;
-      }
-
-      // Use any_of to find a match - stops immediately when found
-      auto iter = std::ranges::find_if(users, [&](const auto& user) {
-         return user.Name == name;
-      });
-
-      if (iter == users.end()) return std::nullopt;
-
-      return EmbyUserData{std::move(iter->Name), std::move(iter->Id)};
-   }
-
-   bool EmbyApi::GetWatchedStatus(std::string_view userId, std::string_view itemId)
-   {
-      const auto apiUrl = BuildApiParamsPath(std::format("{}/{}/Items", API_USERS, userId), {
-         {IDS, itemId},
-         {"IsPlayed", "true"}
-      });
-      auto res = client_.Get(apiUrl, emptyHeaders_);
-      if (!IsHttpSuccess(__func__, res)) return false;
-
-      JsonTotalRecordCount response;
-      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (response, res.value().body))
-      {
-         LogWarning("{} - JSON Parse Error: {}",
-                    __func__, glz::format_error(ec, res.value().body));
-         return false;
-      }
-
-      return response.TotalRecordCount > 0;
-   }
-
-   bool EmbyApi::SetWatchedStatus(std::string_view userId, std::string_view itemId)
-   {
-      const auto apiUrl = BuildApiPath(std::format("{}/{}/PlayedItems/{}", API_USERS, userId, itemId));
-      auto res{client_.Post(apiUrl, jsonHeaders_)};
-      return IsHttpSuccess(__func__, res);
-   }
-
-   std::optional<EmbyPlayState> EmbyApi::GetPlayState(std::string_view userId, std::string_view itemId)
-   {
-      const auto apiUrl = BuildApiParamsPath(std::format("{}/{}/Items", API_USERS, userId), {
-         {IDS, itemId},
-         {"Fields", "Path,UserDataLastPlayedDate,UserDataPlayCount"}
-      });
-
-      auto res = client_.Get(apiUrl, emptyHeaders_);
-      if (!IsHttpSuccess(__func__, res)) return std::nullopt;
-
-      JsonEmbyPlayStates response;
-      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (response, res.value().body))
-      {
-         LogWarning("{} - JSON Parse Error: {}",
-                    __func__, glz::format_error(ec, res.value().body));
-         return std::nullopt;
-      }
-
-      if (response.Items.empty()) return std::nullopt;
-
-      const auto& item = response.Items[0];
-
-      if (item.Type != "Movie" && item.Type != "Episode") return std::nullopt;
-
-      return EmbyPlayState{.path = std::move(item.Path),
-                           .percentage = item.UserData.PlayedPercentage,
-                           .runTimeTicks = item.RunTimeTicks,
-                           .playbackPositionTicks = item.UserData.PlaybackPositionTicks,
-                           .play_count = item.UserData.PlayCount,
-                           .played = item.UserData.Played};
-   }
-
-   bool EmbyApi::SetPlayState(std::string_view userId, std::string_view itemId, int64_t positionTicks, std::string_view dateTimeStr)
-   {
-      const auto apiUrl = BuildApiParamsPath(std::format("{}/{}/Items/{}/UserData", API_USERS, userId, itemId), {
-         {"PlaybackPositionTicks", std::to_string(positionTicks)},
-         {"LastPlayedDate", dateTimeStr}
-      });
-      auto res{client_.Post(apiUrl, jsonHeaders_)};
-      return IsHttpSuccess(__func__, res);
-   }
-
-   bool EmbyApi::GetPlaylistExists(std::string_view name)
-   {
-      return GetItem(EmbySearchType::name, name, {{"IncludeItemTypes", "Playlist"}}).has_value();
-   }
-
-   std::optional<EmbyPlaylist> EmbyApi::GetPlaylist(std::string_view name)
-   {
-      auto item = GetItem(EmbySearchType::name, name, {{"IncludeItemTypes", "Playlist"}});
-      if (!item.has_value()) return std::nullopt;
-
-      auto res = client_.Get(BuildApiPath(std::format("{}/{}/Items", API_PLAYLISTS, item->id)), emptyHeaders_);
-      if (!IsHttpSuccess(__func__, res)) return std::nullopt;
-
-      // Parse the entire "Items" array directly into our struct
-      JsonEmbyPlaylistItemsResponse response;
-      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (response, res.value().body))
-      {
-         LogWarning("{} - JSON Parse Error: {}",
-                    __func__, glz::format_error(ec, res.value().body));
-         return std::nullopt;
-      }
-
-      // Initialize our return object
-      EmbyPlaylist returnPlaylist;
-      returnPlaylist.name = std::move(item->name);
-      returnPlaylist.id = std::move(item->id);
-
-      returnPlaylist.items.reserve(response.Items.size());
-      std::ranges::transform(response.Items, std::back_inserter(returnPlaylist.items), [](auto& item) {
-         return EmbyPlaylistItem{
-             std::move(item.Name),
-             std::move(item.Id),
-             std::move(item.PlaylistItemId)
-         };
-      });
-
-      return returnPlaylist;
-   }
-
-   void EmbyApi::CreatePlaylist(std::string_view name, const std::vector<std::string>& itemIds)
-   {
-      const auto apiUrl = BuildApiParamsPath(API_PLAYLISTS, {
-         {NAME, name},
-         {IDS, BuildCommaSeparatedList(itemIds)},
-         {MEDIA_TYPE, MOVIES}
-      });
-      auto res{client_.Post(apiUrl, jsonHeaders_)};
-      IsHttpSuccess(__func__, res);
-   }
-
-   bool EmbyApi::AddPlaylistItems(std::string_view playlistId, const std::vector<std::string>& addIds)
-   {
-      auto apiUrl = BuildApiParamsPath(std::format("{}/{}/Items", API_PLAYLISTS, playlistId), {
-         {IDS, BuildCommaSeparatedList(addIds)}
-      });
-      auto res{client_.Post(apiUrl, jsonHeaders_)};
-      return IsHttpSuccess(__func__, res);
-   }
-
-   bool EmbyApi::RemovePlaylistItems(std::string_view playlistId, const std::vector<std::string>& removeIds)
-   {
-      const auto apiUrl = BuildApiParamsPath(std::format("{}/{}/Items/Delete", API_PLAYLISTS, playlistId), {
-         {ENTRY_IDS, BuildCommaSeparatedList(removeIds)}
-      });
-      auto res{client_.Post(apiUrl, jsonHeaders_)};
-      return IsHttpSuccess(__func__, res);
-   }
-
-   bool EmbyApi::MovePlaylistItem(std::string_view playlistId, std::string_view itemId, uint32_t index)
-   {
-      auto apiUrl{BuildApiPath(std::format("{}/{}/Items/{}/Move/{}", API_PLAYLISTS, playlistId, itemId, index))};
-      auto res{client_.Post(apiUrl, jsonHeaders_)};
-      return IsHttpSuccess(__func__, res);
-   }
-
-   void EmbyApi::SetLibraryScan(std::string_view libraryId)
-   {
-      httplib::Headers headers = {
-         {"accept", "*/*"}
-      };
-
-      const auto apiUrl = BuildApiParamsPath(std::format("/Items/{}/Refresh", libraryId), {
-         {"Recursive", "true"},
-         {"ImageRefreshMode", "Default"},
-         {"ReplaceAllImages", "false"},
-         {"ReplaceAllMetadata", "false"}
-      });
-
-      auto res = client_.Post(apiUrl, headers);
-      IsHttpSuccess(__func__, res);
-   }
-
-   void EmbyApi::BuildPathMap()
-   {
-      const auto apiUrl = BuildApiParamsPath(API_ITEMS, {
-          {"Recursive", "true"},
-          {"IncludeItemTypes", "Movie,Episode"},
-          {"Fields", "Path,DateModified"},
-          {"IsMissing", "false"}
-      });
-
-      auto res = client_.Get(apiUrl, emptyHeaders_);
-      if (!IsHttpSuccess(__func__, res)) return;
-
-      PathRebuildItems response;
-      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (response, res.value().body))
-      {
-         LogWarning("{} - JSON Parse Error: {}",
-             __func__, glz::format_error(ec, res.value().body)); // Log the start of the string for context
-         return;
-      }
-
-      workingPathMap_.reserve(response.Items.size());
-
-      std::string localMaxTimestamp;
-      for (auto& item : response.Items)
-      {
-         // Check for empty because a missing field in JSON results in an empty string in the struct
-         if (!item.Path.empty() && !item.Id.empty())
-         {
-            // Move strings to avoid allocations
-            workingPathMap_.emplace(std::move(item.Path), std::move(item.Id));
-
-            // Track the newest timestamp
-            if (item.DateModified > localMaxTimestamp)
-            {
-               localMaxTimestamp = std::move(item.DateModified);
-            }
-         }
-      }
-
-      if (!workingPathMap_.empty())
-      {
-         std::lock_guard lock(taskLock_);
-         std::swap(workingPathMap_, pathMap_);
-         lastSyncTimestamp_ = std::move(localMaxTimestamp);
-      }
-
-      workingPathMap_.clear();
-   }
-
-   bool EmbyApi::HasLibraryChanged()
-   {
-      const auto apiUrl = BuildApiParamsPath(API_ITEMS, {
-          {"Recursive", "true"},
-          {"IncludeItemTypes", "Movie,Episode"},
-          {"SortBy", "DateModified"},
-          {"SortOrder", "Descending"},
-          {"Limit", "1"},
-          {"Fields", "DateModified"}
-      });
-
-      auto res = client_.Get(apiUrl, emptyHeaders_);
-      if (!IsHttpSuccess(__func__, res)) return false;
-
-      PathRebuildItems response;
-      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (response, res.value().body))
-      {
-         LogWarning("{} - JSON Parse Error: {}",
-             __func__, glz::format_error(ec, res.value().body)); // Log the start of the string for context
-         return false;
-      }
-
-      return !response.Items.empty()
-         && !response.Items[0].DateModified.empty()
-         && response.Items[0].DateModified > lastSyncTimestamp_;
-   }
-
-   void EmbyApi::RunPathMapQuickCheck()
-   {
-      if (GetPathMapEmpty() || HasLibraryChanged())
-      {
-         BuildPathMap();
-      }
-   }
-
-   void EmbyApi::RunPathMapFullUpdate()
-   {
-      BuildPathMap();
-   }
-
-   bool EmbyApi::GetPathMapEmpty() const
-   {
-      std::lock_guard lock(taskLock_);
-      return pathMap_.empty();
-   }
-
-   std::optional<std::string> EmbyApi::GetIdFromPathMap(const std::string& path)
-   {
-      std::lock_guard lock(taskLock_);
-
-      // Look up the item once
-      if (auto it = pathMap_.find(path); it != pathMap_.end())
-      {
-         return it->second;
-      }
-      return std::nullopt;
-   }
+#include "api-emby.h"
+
+#include "api/api-emby-json-types.h"
+#include "api/api-emby-path-map-file.h"
+#include "api/api-json-string.h"
+#include "api/api-utils.h"
+#include "logger/log-utils.h"
+#include "types.h"
+
+#include <glaze/glaze.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <format>
+#include <mutex>
+#include <numeric>
+#include <ranges>
+
+namespace loomis
+{
+   namespace
+   {
+      const std::string API_BASE{"/emby"};
+      const std::string API_TOKEN_NAME{"api_key"};
+
+      const std::string API_SYSTEM_INFO{"/System/Info"};
+      const std::string API_MEDIA_FOLDERS{"/Library/SelectableMediaFolders"};
+      const std::string API_ITEMS{"/Items"};
+      const std::string API_PLAYLISTS{"/Playlists"};
+      const std::string API_USERS{"/Users"};
+
+      constexpr std::string_view NAME{"Name"};
+      constexpr std::string_view IDS{"Ids"};
+      constexpr std::string_view PATH{"Path"};
+      constexpr std::string_view MEDIA_TYPE{"MediaType"};
+      constexpr std::string_view MOVIES{"Movies"};
+      constexpr std::string_view SEARCH_TERM{"SearchTerm"};
+      constexpr std::string_view ENTRY_IDS{"EntryIds"};
+
+      // Path map rebuilds are paged to bound memory on large libraries
+      constexpr uint32_t PATH_MAP_PAGE_SIZE{5000u};
+      constexpr size_t PATH_MAP_PAGES_IN_FLIGHT{4u};
+
+      // Number of item ids sent in one play state request
+      constexpr size_t PLAY_STATE_BATCH_SIZE{100u};
+
+      constexpr uint32_t WATCH_STATE_PAGE_SIZE{1000u};
+
+      // Response shaping profiles. Each asks only for what its callers read.
+      // Item lists: no image tags, no per user data and no total count
+      const ApiParams PROFILE_ITEM_LIST{
+         {"EnableImages", "false"},
+         {"EnableUserData", "false"},
+         {"EnableTotalRecordCount", "false"}
+      };
+
+      // Item counts: only the total
+      const ApiParams PROFILE_ITEM_COUNT{
+         {"Limit", "0"},
+         {"EnableImages", "false"},
+         {"EnableUserData", "false"},
+         {"EnableTotalRecordCount", "true"}
+      };
+
+      // Play state reads: the user data without image tags or a total count
+      const ApiParams PROFILE_USER_DATA{
+         {"EnableImages", "false"},
+         {"EnableTotalRecordCount", "false"}
+      };
+
+      // Item changed since the last path map sync
+      struct PathDeltaItem
+      {
+         std::string path;
+         std::string id;
+
+         // Created at or after the last sync timestamp. Only the items right at the timestamp can already be in the map.
+         bool created{false};
+      };
+   }
+
+   EmbyApi::EmbyApi(const ServerConfig& serverConfig, const std::filesystem::path& cachePath)
+      : ApiBase(serverConfig, serverConfig.url, serverConfig.api_key, "EmbyApi", log::ANSI_CODE_EMBY)
+      , mediaPath_(serverConfig.media_path)
+   {
+      if (!cachePath.empty()) pathMapFile_ = GetServerCacheFileName(cachePath, "emby-path-map-", GetName(), ".bin");
+
+      if (LoadPathMapFile())
+      {
+         // Start with the saved map and bring it up to date without blocking startup
+         pathMapRevalidateThread_ = std::jthread([this]() { RunPathMapQuickCheck(); });
+      }
+      else if (GetValid())
+      {
+         BuildPathMap();
+      }
+   }
+
+   std::optional<std::vector<Task>> EmbyApi::GetTaskList()
+   {
+      auto tasks = ApiBase::GetTaskList().value_or(std::vector<Task>{});
+
+      auto& quickCheck = tasks.emplace_back();
+      quickCheck.name = std::format("EmbyApi({}) - Path Map Quick Check", GetName());
+      quickCheck.cronExpression = "30 */5 * * * *";
+      quickCheck.func = [this]() {this->RunPathMapQuickCheck(); };
+
+      auto& fullUpdate = tasks.emplace_back();
+      fullUpdate.name = std::format("EmbyApi({}) - Path Map Full Update", GetName());
+      fullUpdate.cronExpression = "0 45 3 * * *";
+      fullUpdate.func = [this]() {this->RunPathMapFullUpdate(); };
+
+      auto& lookupRefresh = tasks.emplace_back();
+      lookupRefresh.name = std::format("EmbyApi({}) - Lookup Cache Refresh", GetName());
+      lookupRefresh.cronExpression = "0 15 * * * *";
+      lookupRefresh.func = [this]() {this->RunLookupCacheRefresh(); };
+
+      return tasks;
+   }
+
+   std::string_view EmbyApi::GetApiBase() const
+   {
+      return API_BASE;
+   }
+
+   std::string_view EmbyApi::GetApiTokenName() const
+   {
+      return API_TOKEN_NAME;
+   }
+
+   bool EmbyApi::ProbeServer()
+   {
+      auto res = Get(BuildApiPath(API_SYSTEM_INFO), emptyHeaders_);
+      return res.error() == httplib::Error::Success && res.value().status < VALID_HTTP_RESPONSE_MAX;
+   }
+
+   const std::string& EmbyApi::GetMediaPath() const
+   {
+      return mediaPath_;
+   }
+
+   std::optional<std::string> EmbyApi::GetServerReportedName()
+   {
+      auto res = Get(BuildApiPath(API_SYSTEM_INFO), emptyHeaders_);
+
+      if (!IsHttpSuccess(__func__, res))
+      {
+         return std::nullopt;
+      }
+
+      JsonServerResponse serverResponse;
+      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (serverResponse, res.value().body))
+      {
+         LogWarning("{} - JSON Parse Error: {}",
+                    __func__, glz::format_error(ec, res.value().body));
+         return std::nullopt;
+      }
+
+      if (serverResponse.ServerName.empty())
+      {
+         return std::nullopt;
+      }
+      return std::move(serverResponse.ServerName);
+   }
+
+   std::optional<std::string> EmbyApi::GetLibraryId(std::string_view libraryName)
+   {
+      return libraryIds_.Find(libraryName);
+   }
+
+   std::optional<ApiLookupCache<std::string>::Map> EmbyApi::LoadLibraryIds()
+   {
+      auto body = GetCached(__func__, BuildApiPath(API_MEDIA_FOLDERS), emptyHeaders_, GetCacheTtl());
+      if (!body) return std::nullopt;
+
+      std::vector<JsonEmbyLibrary> jsonLibraries;
+      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (jsonLibraries, *body))
+      {
+         LogWarning("{} - JSON Parse Error: {}",
+                    __func__, glz::format_error(ec, *body));
+         return std::nullopt;
+      }
+
+      ApiLookupCache<std::string>::Map libraryIds;
+      for (auto& library : jsonLibraries)
+      {
+         libraryIds.emplace(std::move(library.Name), std::move(library.Id));
+      }
+      return libraryIds;
+   }
+
+   void EmbyApi::RunLookupCacheRefresh()
+   {
+      libraryIds_.Refresh();
+      users_.Refresh();
+   }
+
+   std::string_view EmbyApi::GetSearchTypeStr(EmbySearchType type)
+   {
+      switch (type)
+      {
+         case EmbySearchType::id:
+            return IDS;
+         case EmbySearchType::path:
+            return PATH;
+         default:
+            return SEARCH_TERM;
+      }
+   }
+
+   std::optional<EmbyItem> EmbyApi::GetItem(EmbySearchType type, std::string_view name, const ApiParams& extraSearchArgs)
+   {
+      ApiParams params = {
+         {"Recursive", "true"},
+         {GetSearchTypeStr(type), name},
+         {"Fields", "Path,SeriesName,RunTimeTicks"}
+      };
+      params.reserve(params.size() + extraSearchArgs.size());
+      params.insert(params.end(), extraSearchArgs.begin(), extraSearchArgs.end());
+
+      auto res{Get(BuildApiParamsPath(API_ITEMS, params, PROFILE_ITEM_LIST), emptyHeaders_)};
+      if (!IsHttpSuccess(__func__, res)) return std::nullopt;
+
+      JsonEmbyItemsResponse response;
+      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (response, res.value().body))
+      {
+         LogWarning("{} - JSON Parse Error: {}", __func__, glz::format_error(ec, res.value().body));
+         return std::nullopt;
+      }
+
+      // Use a lambda to find the specific item based on the search type
+      auto it = std::ranges::find_if(response.Items, [&](const JsonEmbyItem& item) {
+         switch (type)
+         {
+            case EmbySearchType::id:   return GetJsonStringEqual(item.Id, name);
+            case EmbySearchType::path: return GetJsonStringEqual(item.Path, name);
+            case EmbySearchType::name: return GetJsonStringEqual(item.Name, name);
+            default: return false;
+         }
+      });
+
+      if (it != response.Items.end())
+      {
+         auto& match = *it;
+         EmbyItem returnItem;
+
+         // Only the match is copied out of the reply body
+         returnItem.id = GetJsonString(match.Id);
+         returnItem.type = GetJsonString(match.Type);
+         returnItem.name = GetJsonString(match.Name);
+         returnItem.path = GetJsonString(match.Path);
+         returnItem.runTimeTicks = match.RunTimeTicks;
+
+         // Populate nested series data
+         returnItem.series.name = GetJsonString(match.SeriesName);
+         returnItem.series.seasonNum = match.ParentIndexNumber;
+         returnItem.series.episodeNum = match.IndexNumber;
+
+         return returnItem;
+      }
+
+      LogWarning("{} returned no valid results {}", __func__, log::GetTag("search", name));
+      return std::nullopt;
+   }
+
+   std::optional<EmbyUserData> EmbyApi::GetUser(std::string_view name)
+   {
+      return users_.Find(name);
+   }
+
+   std::optional<ApiLookupCache<EmbyUserData>::Map> EmbyApi::LoadUsers()
+   {
+      auto body = GetCached(__func__, BuildApiPath(API_USERS), emptyHeaders_, GetCacheTtl());
+      if (!body) return std::nullopt;
+
+      // Parse into a vector of our minimal user structs
+      std::vector<JsonEmbyUser> jsonUsers;
+      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (jsonUsers, *body))
+      {
+         LogWarning("{} - JSON Parse Error: {}",
+                    __func__, glz::format_error(ec, *body));
+         return std::nullopt;
+      }
+
+      ApiLookupCache<EmbyUserData>::Map users;
+      users.reserve(jsonUsers.size());
+      for (auto& user : jsonUsers)
+      {
+         users.emplace(user.Name, EmbyUserData{std::move(user.Name), std::move(user.Id)});
+      }
+      return users;
+   }
+
+   bool EmbyApi::GetWatchedStatus(std::string_view userId, std::string_view itemId)
+   {
+      const auto apiUrl = BuildApiParamsPath(std::format("{}/{}/Items", API_USERS, userId), {
+         {IDS, itemId},
+         {"IsPlayed", "true"}
+      }, PROFILE_ITEM_COUNT);
+      auto res = Get(apiUrl, emptyHeaders_);
+      if (!IsHttpSuccess(__func__, res)) return false;
+
+      JsonTotalRecordCount response;
+      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (response, res.value().body))
+      {
+         LogWarning("{} - JSON Parse Error: {}",
+                    __func__, glz::format_error(ec, res.value().body));
+         return false;
+      }
+
+      return response.TotalRecordCount > 0;
+   }
+
+   bool EmbyApi::SetWatchedStatus(std::string_view userId, std::string_view itemId)
+   {
+      const auto apiUrl = BuildApiPath(std::format("{}/{}/PlayedItems/{}", API_USERS, userId, itemId));
+      auto res{Post(apiUrl, jsonHeaders_)};
+      return IsHttpSuccess(__func__, res);
+   }
+
+   std::optional<EmbyPlayState> EmbyApi::GetPlayState(std::string_view userId, std::string_view itemId)
+   {
+      std::string id{itemId};
+      auto playStates = GetPlayStates(userId, std::span<const std::string>(&id, 1));
+
+      auto iter = playStates.find(id);
+      if (iter == playStates.end()) return std::nullopt;
+      return std::move(iter->second);
+   }
+
+   EmbyPlayStates EmbyApi::GetPlayStates(std::string_view userId, std::span<const std::string> itemIds)
+   {
+      // Ids are sent as a comma separated list. Chunk them to keep the urls a sane length.
+      std::vector<std::string> chunkPaths;
+      for (size_t start = 0; start < itemIds.size(); start += PLAY_STATE_BATCH_SIZE)
+      {
+         std::string ids;
+         for (const auto& id : itemIds.subspan(start, std::min(PLAY_STATE_BATCH_SIZE, itemIds.size() - start)))
+         {
+            if (!ids.empty()) ids += ',';
+            ids += id;
+         }
+
+         chunkPaths.emplace_back(BuildApiParamsPath(std::format("{}/{}/Items", API_USERS, userId), {
+            {IDS, ids},
+            {"Fields", "Path,UserDataLastPlayedDate,UserDataPlayCount"}
+         }, PROFILE_USER_DATA));
+      }
+
+      EmbyPlayStates playStates;
+      if (chunkPaths.empty()) return playStates;
+
+      auto addPlayStates = [&](const std::shared_ptr<const EmbyPlayStates>& chunk) {
+         for (const auto& [id, playState] : *chunk) playStates.insert_or_assign(id, playState);
+      };
+
+      // Any extra chunks run on the worker pool and the first on this thread. Called from a pool worker
+      // every chunk runs on that worker so it never waits on the pool it is part of.
+      std::vector<std::future<std::shared_ptr<const EmbyPlayStates>>> requests;
+      for (size_t i = 1; i < chunkPaths.size(); ++i)
+      {
+         requests.emplace_back(RunAsync([this, path = std::move(chunkPaths[i])]() {
+            return GetPlayStatesChunk(path);
+         }));
+      }
+
+      addPlayStates(GetPlayStatesChunk(chunkPaths.front()));
+      for (auto& request : requests) addPlayStates(request.get());
+
+      return playStates;
+   }
+
+   bool EmbyApi::GetRequestIdempotent(std::string_view method, std::string_view path) const
+   {
+      if (ApiBase::GetRequestIdempotent(method, path)) return true;
+
+      // Marking played and setting the play position set state so sending them twice is harmless.
+      // Playlist edits add or move items and are never sent twice.
+      auto apiPath = path.substr(0, path.find('?'));
+      return apiPath.find("/PlayedItems/") != std::string_view::npos || apiPath.ends_with("/UserData");
+   }
+
+   std::shared_ptr<const EmbyPlayStates> EmbyApi::GetPlayStatesChunk(const std::string& path)
+   {
+      // Users syncing the same items at the same time share the request
+      return RunSingleFlight<EmbyPlayStates>(std::format("GET {}", path), [this, &path, name = __func__]() {
+         auto playStates = std::make_shared<EmbyPlayStates>();
+
+         auto res = Get(path, emptyHeaders_);
+         if (!IsHttpSuccess(name, res)) return playStates;
+
+         JsonEmbyPlayStates response;
+         if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (response, res.value().body))
+         {
+            LogWarning("{} - JSON Parse Error: {}",
+                       name, glz::format_error(ec, res.value().body));
+            return playStates;
+         }
+
+         for (auto& item : response.Items)
+         {
+            if (item.Type != "Movie" && item.Type != "Episode") continue;
+
+            playStates->insert_or_assign(std::move(item.Id),
+                                         EmbyPlayState{.path = std::move(item.Path),
+                                                       .percentage = item.UserData.PlayedPercentage,
+                                                       .runTimeTicks = item.RunTimeTicks,
+                                                       .playbackPositionTicks = item.UserData.PlaybackPositionTicks,
+                                                       .play_count = item.UserData.PlayCount,
+                                                       .played = item.UserData.Played});
+         }
+         return playStates;
+      });
+   }
+
+   std::optional<EmbyWatchStates> EmbyApi::GetWatchStates(std::string_view userId, std::string_view minDateLastSaved)
+   {
+      const auto apiPath = std::format("{}/{}/Items", API_USERS, userId);
+      const auto limit = std::to_string(WATCH_STATE_PAGE_SIZE);
+
+      // Played and in progress items are separate filters on the server. Changes since a date are one unfiltered query.
+      const std::vector<ApiParams> filters = minDateLastSaved.empty()
+         ? std::vector<ApiParams>{{{"IsPlayed", "true"}}, {{"Filters", "IsResumable"}}}
+         : std::vector<ApiParams>{{{"MinDateLastSavedForUser", minDateLastSaved}}};
+
+      EmbyWatchStates watchStates;
+      for (const auto& filter : filters)
+      {
+         for (uint32_t startIndex = 0;; startIndex += WATCH_STATE_PAGE_SIZE)
+         {
+            const auto start = std::to_string(startIndex);
+            ApiParams params = {
+               {"Recursive", "true"},
+               {"IncludeItemTypes", "Movie,Episode"},
+               {"StartIndex", start},
+               {"Limit", limit}
+            };
+            params.insert(params.end(), filter.begin(), filter.end());
+
+            auto res = Get(BuildApiParamsPath(apiPath, params, PROFILE_USER_DATA), emptyHeaders_);
+            if (!IsHttpSuccess(__func__, res)) return std::nullopt;
+
+            JsonEmbyPlayStates response;
+            if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (response, res.value().body))
+            {
+               LogWarning("{} - JSON Parse Error: {}",
+                          __func__, glz::format_error(ec, res.value().body));
+               return std::nullopt;
+            }
+
+            for (auto& item : response.Items)
+            {
+               watchStates.insert_or_assign(std::move(item.Id),
+                                            EmbyWatchState{.runTimeTicks = item.RunTimeTicks,
+                                                           .playbackPositionTicks = item.UserData.PlaybackPositionTicks,
+                                                           .percentage = item.UserData.PlayedPercentage,
+                                                           .played = item.UserData.Played});
+            }
+
+            if (response.Items.size() < WATCH_STATE_PAGE_SIZE) break;
+         }
+      }
+      return watchStates;
+   }
+
+   bool EmbyApi::SetPlayState(std::string_view userId, std::string_view itemId, int64_t positionTicks, std::string_view dateTimeStr)
+   {
+      const auto apiUrl = BuildApiParamsPath(std::format("{}/{}/Items/{}/UserData", API_USERS, userId, itemId), {
+         {"PlaybackPositionTicks", std::to_string(positionTicks)},
+         {"LastPlayedDate", dateTimeStr}
+      });
+      auto res{Post(apiUrl, jsonHeaders_)};
+      return IsHttpSuccess(__func__, res);
+   }
+
+   std::future<bool> EmbyApi::GetWatchedStatusAsync(std::string_view userId, std::string_view itemId)
+   {
+      return RunAsync([this, userId = std::string(userId), itemId = std::string(itemId)]() {
+         return GetWatchedStatus(userId, itemId);
+      });
+   }
+
+   std::future<bool> EmbyApi::SetWatchedStatusAsync(std::string_view userId, std::string_view itemId)
+   {
+      return RunAsync([this, userId = std::string(userId), itemId = std::string(itemId)]() {
+         return SetWatchedStatus(userId, itemId);
+      });
+   }
+
+   std::future<std::optional<EmbyPlayState>> EmbyApi::GetPlayStateAsync(std::string_view userId, std::string_view itemId)
+   {
+      return RunAsync([this, userId = std::string(userId), itemId = std::string(itemId)]() {
+         return GetPlayState(userId, itemId);
+      });
+   }
+
+   std::future<bool> EmbyApi::SetPlayStateAsync(std::string_view userId, std::string_view itemId, int64_t positionTicks, std::string_view dateTimeStr)
+   {
+      return RunAsync([this, userId = std::string(userId), itemId = std::string(itemId), positionTicks, dateTimeStr = std::string(dateTimeStr)]() {
+         return SetPlayState(userId, itemId, positionTicks, dateTimeStr);
+      });
+   }
+
+   bool EmbyApi::GetPlaylistExists(std::string_view name)
+   {
+      return GetItem(EmbySearchType::name, name, {{"IncludeItemTypes", "Playlist"}}).has_value();
+   }
+
+   std::optional<EmbyPlaylist> EmbyApi::GetPlaylist(std::string_view name)
+   {
+      auto item = GetItem(EmbySearchType::name, name, {{"IncludeItemTypes", "Playlist"}});
+      if (!item.has_value()) return std::nullopt;
+
+      auto res = Get(BuildApiParamsPath(std::format("{}/{}/Items", API_PLAYLISTS, item->id), {}, PROFILE_ITEM_LIST), emptyHeaders_);
+      if (!IsHttpSuccess(__func__, res)) return std::nullopt;
+
+      // Parse the entire "Items" array directly into our struct
+      JsonEmbyPlaylistItemsResponse response;
+      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (response, res.value().body))
+      {
+         LogWarning("{} - JSON Parse Error: {}",
+                    __func__, glz::format_error(ec, res.value().body));
+         return std::nullopt;
+      }
+
+      // Initialize our return object
+      EmbyPlaylist returnPlaylist;
+      returnPlaylist.name = std::move(item->name);
+      returnPlaylist.id = std::move(item->id);
+
+      returnPlaylist.items.reserve(response.Items.size());
+      std::ranges::transform(response.Items, std::back_inserter(returnPlaylist.items), [](const auto& item) {
+         return EmbyPlaylistItem{
+             GetJsonString(item.Name),
+             GetJsonString(item.Id),
+             GetJsonString(item.PlaylistItemId)
+         };
+      });
+
+      return returnPlaylist;
+   }
+
+   void EmbyApi::CreatePlaylist(std::string_view name, const std::vector<std::string>& itemIds)
+   {
+      const auto apiUrl = BuildApiParamsPath(API_PLAYLISTS, {
+         {NAME, name},
+         {IDS, BuildCommaSeparatedList(itemIds)},
+         {MEDIA_TYPE, MOVIES}
+      });
+      auto res{Post(apiUrl, jsonHeaders_)};
+      IsHttpSuccess(__func__, res);
+   }
+
+   bool EmbyApi::AddPlaylistItems(std::string_view playlistId, const std::vector<std::string>& addIds)
+   {
+      auto apiUrl = BuildApiParamsPath(std::format("{}/{}/Items", API_PLAYLISTS, playlistId), {
+         {IDS, BuildCommaSeparatedList(addIds)}
+      });
+      auto res{Post(apiUrl, jsonHeaders_)};
+      return IsHttpSuccess(__func__, res);
+   }
+
+   bool EmbyApi::RemovePlaylistItems(std::string_view playlistId, const std::vector<std::string>& removeIds)
+   {
+      const auto apiUrl = BuildApiParamsPath(std::format("{}/{}/Items/Delete", API_PLAYLISTS, playlistId), {
+         {ENTRY_IDS, BuildCommaSeparatedList(removeIds)}
+      });
+      auto res{Post(apiUrl, jsonHeaders_)};
+      return IsHttpSuccess(__func__, res);
+   }
+
+   bool EmbyApi::MovePlaylistItem(std::string_view playlistId, std::string_view itemId, uint32_t index)
+   {
+      auto apiUrl{BuildApiPath(std::format("{}/{}/Items/{}/Move/{}", API_PLAYLISTS, playlistId, itemId, index))};
+      auto res{Post(apiUrl, jsonHeaders_)};
+      return IsHttpSuccess(__func__, res);
+   }
+
+   void EmbyApi::SetLibraryScan(std::string_view libraryId)
+   {
+      httplib::Headers headers = {
+         {"accept", "*/*"}
+      };
+
+      const auto apiUrl = BuildApiParamsPath(std::format("/Items/{}/Refresh", libraryId), {
+         {"Recursive", "true"},
+         {"ImageRefreshMode", "Default"},
+         {"ReplaceAllImages", "false"},
+         {"ReplaceAllMetadata", "false"}
+      });
+
+      auto res = Post(apiUrl, headers);
+      IsHttpSuccess(__func__, res);
+   }
+
+   std::string EmbyApi::BuildPathMapQuery(const ApiParams& extraParams, const ApiParams& profile) const
+   {
+      ApiParams params = {
+         {"Recursive", "true"},
+         {"IncludeItemTypes", "Movie,Episode"},
+         {"IsMissing", "false"}
+      };
+      params.reserve(params.size() + extraParams.size());
+      params.insert(params.end(), extraParams.begin(), extraParams.end());
+      return BuildApiParamsPath(API_ITEMS, params, profile);
+   }
+
+   std::optional<uint32_t> EmbyApi::GetPathMapItemCount()
+   {
+      auto res = Get(BuildPathMapQuery({}, PROFILE_ITEM_COUNT), emptyHeaders_);
+      if (!IsHttpSuccess(__func__, res)) return std::nullopt;
+
+      JsonTotalRecordCount response;
+      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (response, res.value().body))
+      {
+         LogWarning("{} - JSON Parse Error: {}",
+                    __func__, glz::format_error(ec, res.value().body));
+         return std::nullopt;
+      }
+
+      return static_cast<uint32_t>(std::max(response.TotalRecordCount, 0));
+   }
+
+   std::optional<EmbyApi::PathMapPage> EmbyApi::GetPathMapPage(uint32_t startIndex)
+   {
+      auto startIndexStr = std::to_string(startIndex);
+      auto limitStr = std::to_string(PATH_MAP_PAGE_SIZE);
+      // Pages need a unique order or items with the same sort value can move between pages.
+      // Creation order also keeps items added during the rebuild on the last pages.
+      auto path = BuildPathMapQuery({
+         {"Fields", "Path,DateLastSaved"},
+         {"SortBy", "DateCreated,Id"},
+         {"StartIndex", startIndexStr},
+         {"Limit", limitStr}
+      }, PROFILE_ITEM_LIST);
+
+      PathMapPage page;
+      page.entries.reserve(PATH_MAP_PAGE_SIZE);
+
+      PathRebuildItem item;
+      JsonArrayStream stream({"Items"}, [&](const std::string& element) {
+         item = {};
+         if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (item, element))
+         {
+            LogWarning("{} - JSON Parse Error: {}",
+                       __func__, glz::format_error(ec, element));
+            return false;
+         }
+
+         // Check for empty because a missing field in JSON results in an empty string in the struct
+         if (!item.Path.empty() && !item.Id.empty())
+         {
+            // Paths and ids are decoded into the arena since the element text is reused for the next item
+            page.entries.emplace_back(page.arena.Add(item.Path), page.arena.Add(item.Id));
+
+            // The delta filters on MinDateLastSaved so the same field is tracked. Timestamps have no escapes so the raw text is the value.
+            if (item.DateLastSaved > page.maxTimestamp) page.maxTimestamp = item.DateLastSaved;
+         }
+         return true;
+      });
+
+      auto res = GetStream(path, emptyHeaders_, stream.GetReceiver());
+      if (!IsJsonStreamSuccess(__func__, res, stream)) return std::nullopt;
+      return page;
+   }
+
+   void EmbyApi::BuildPathMap()
+   {
+      auto itemCount = GetPathMapItemCount();
+      if (!itemCount) return;
+
+      // The entries point into the arenas of the pages they came from so those are kept until the index is built
+      std::vector<JsonStringArena> arenas;
+      EmbyPathIndex::Entries entries;
+      entries.reserve(*itemCount);
+
+      // Page through the library with a few pages in flight. Each page is streamed straight
+      // into its entries so no reply body is ever held in memory.
+      std::deque<std::future<std::optional<PathMapPage>>> pages;
+      uint32_t nextStartIndex{0u};
+      auto queueNextPage = [&]() {
+         pages.emplace_back(RunAsync([this, startIndex = nextStartIndex]() { return GetPathMapPage(startIndex); }));
+         nextStartIndex += PATH_MAP_PAGE_SIZE;
+      };
+
+      while (nextStartIndex < *itemCount && pages.size() < PATH_MAP_PAGES_IN_FLIGHT) queueNextPage();
+
+      bool pagesValid{true};
+      std::string localMaxTimestamp;
+      while (!pages.empty())
+      {
+         auto page = pages.front().get();
+         pages.pop_front();
+
+         if (!page)
+         {
+            pagesValid = false;
+            break;
+         }
+
+         if (nextStartIndex < *itemCount) queueNextPage();
+
+         entries.insert(entries.end(), page->entries.begin(), page->entries.end());
+         arenas.emplace_back(std::move(page->arena));
+
+         if (page->maxTimestamp > localMaxTimestamp) localMaxTimestamp = std::move(page->maxTimestamp);
+      }
+
+      // A partial map would cause false misses so only publish a complete rebuild
+      if (!pagesValid || entries.empty()) return;
+
+      auto mapMemoryEstimate = EmbyPathIndex::EstimatePathMapMemory(entries);
+      auto pathIndex = EmbyPathIndex::Build(std::move(entries));
+
+      LogTrace("Path map rebuilt {} {} {} {}",
+               log::GetTag("items", pathIndex.Size()),
+               log::GetTag("index_bytes", pathIndex.GetMemoryUsage()),
+               log::GetTag("arena_bytes", std::accumulate(arenas.begin(), arenas.end(), size_t{0u}, [](size_t total, const auto& arena) { return total + arena.GetMemoryUsage(); })),
+               log::GetTag("map_bytes_estimate", mapMemoryEstimate));
+
+      if (!pathMapFile_.empty())
+      {
+         EmbyPathMapFile pathMapFile{
+            .index = pathIndex,
+            .lastSyncTimestamp = localMaxTimestamp,
+            .itemCount = *itemCount
+         };
+         if (!SaveEmbyPathMapFile(pathMapFile_, pathMapFile))
+         {
+            LogWarning("{} - Failed to save path map {}", __func__, log::GetTag("file", pathMapFile_.string()));
+         }
+      }
+
+      pathMap_.store(std::make_shared<const EmbyPathMapSnapshot>(EmbyPathMapSnapshot{
+         .index = std::move(pathIndex),
+         .delta = {},
+         .lastSyncTimestamp = std::move(localMaxTimestamp),
+         .itemCount = *itemCount
+      }));
+   }
+
+   bool EmbyApi::LoadPathMapFile()
+   {
+      if (pathMapFile_.empty()) return false;
+
+      auto pathMapFile = LoadEmbyPathMapFile(pathMapFile_);
+      if (!pathMapFile || pathMapFile->index.Empty()) return false;
+
+      LogTrace("Path map loaded {} {}",
+               log::GetTag("items", pathMapFile->index.Size()),
+               log::GetTag("timestamp", pathMapFile->lastSyncTimestamp));
+
+      pathMap_.store(std::make_shared<const EmbyPathMapSnapshot>(EmbyPathMapSnapshot{
+         .index = std::move(pathMapFile->index),
+         .delta = {},
+         .lastSyncTimestamp = std::move(pathMapFile->lastSyncTimestamp),
+         .itemCount = pathMapFile->itemCount
+      }));
+      return true;
+   }
+
+   bool EmbyApi::ApplyPathMapDelta()
+   {
+      auto current = pathMap_.load();
+
+      // Without a timestamp the delta would be the whole library
+      if (current->lastSyncTimestamp.empty()) return false;
+
+      auto itemCountFuture = RunAsync([this]() { return GetPathMapItemCount(); });
+
+      // Changed items are decoded as they arrive. Only the path, id, creation and the newest timestamp are kept.
+      std::vector<PathDeltaItem> changedItems;
+      std::string maxTimestamp;
+      PathRebuildItem item;
+      JsonArrayStream stream({"Items"}, [&](const std::string& element) {
+         item = {};
+         if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (item, element))
+         {
+            LogWarning("{} - JSON Parse Error: {}",
+                       __func__, glz::format_error(ec, element));
+            return false;
+         }
+
+         if (!item.Path.empty() && !item.Id.empty())
+         {
+            // The compare is inclusive so an item created right at the timestamp is never missed
+            changedItems.emplace_back(PathDeltaItem{
+               .path = GetJsonString(item.Path),
+               .id = GetJsonString(item.Id),
+               .created = !item.DateCreated.empty() && item.DateCreated >= current->lastSyncTimestamp
+            });
+            if (item.DateLastSaved > maxTimestamp) maxTimestamp = item.DateLastSaved;
+         }
+         return true;
+      });
+
+      auto res = GetStream(BuildPathMapQuery({
+         {"Fields", "Path,DateLastSaved,DateCreated"},
+         {"MinDateLastSaved", current->lastSyncTimestamp}
+      }, PROFILE_ITEM_LIST), emptyHeaders_, stream.GetReceiver());
+      auto itemCount = itemCountFuture.get();
+
+      // Server is not responding correctly. Keep the current map and check again next time.
+      if (!IsJsonStreamSuccess(__func__, res, stream) || !itemCount) return true;
+
+      // Nothing changed so keep the current snapshot
+      if (changedItems.empty()) return current->itemCount == *itemCount;
+
+      // Writers are serialized so the current snapshot can not change while the update is built
+      auto updated = std::make_shared<EmbyPathMapSnapshot>(*current);
+
+      uint32_t addedItems{0u};
+      uint32_t movedItems{0u};
+      for (auto& changed : changedItems)
+      {
+         // Items already in the map under this path were only updated or sent again at the timestamp.
+         // An older item under a path the map does not know was moved and its old path is still in the map.
+         auto mappedId = updated->Find(changed.path);
+         if (changed.created && mappedId != changed.id) ++addedItems;
+         else if (!changed.created && !mappedId) ++movedItems;
+
+         // The index is read only so patched items are held in the delta map until the next rebuild
+         updated->delta.insert_or_assign(std::move(changed.path), std::move(changed.id));
+      }
+
+      if (maxTimestamp > updated->lastSyncTimestamp) updated->lastSyncTimestamp = std::move(maxTimestamp);
+      updated->itemCount += addedItems;
+      pathMap_.store(updated);
+
+      LogTrace("Path map patched {} {} {}",
+               log::GetTag("changed", changedItems.size()),
+               log::GetTag("added", addedItems),
+               log::GetTag("moved", movedItems));
+
+      // Deleted items never show up in the delta. Every item created since the last sync is counted as added
+      // so the server count only matches the map when nothing was deleted. Moved items leave their old path
+      // behind so they need a rebuild as well.
+      return movedItems == 0u && updated->itemCount == *itemCount;
+   }
+
+   void EmbyApi::RunPathMapQuickCheck()
+   {
+      std::lock_guard updateLock(pathMapUpdateLock_);
+      if (GetPathMapEmpty() || !ApplyPathMapDelta())
+      {
+         BuildPathMap();
+      }
+   }
+
+   void EmbyApi::RunPathMapFullUpdate()
+   {
+      std::lock_guard updateLock(pathMapUpdateLock_);
+      BuildPathMap();
+   }
+
+   bool EmbyApi::GetPathMapEmpty() const
+   {
+      return pathMap_.load()->Empty();
+   }
+
+   EmbyPathMapStats EmbyApi::GetPathMapStats() const
+   {
+      auto pathMap = pathMap_.load();
+
+      EmbyPathIndex::Entries deltaEntries(pathMap->delta.begin(), pathMap->delta.end());
+      return EmbyPathMapStats{
+         .indexItems = pathMap->index.Size(),
+         .indexBytes = pathMap->index.GetMemoryUsage(),
+         .deltaItems = pathMap->delta.size(),
+         .deltaBytes = EmbyPathIndex::EstimatePathMapMemory(deltaEntries)
+      };
+   }
+
+   std::optional<std::string> EmbyApi::GetIdFromPathMap(const std::string& path) const
+   {
+      return pathMap_.load()->Find(path);
+   }
+
+   std::vector<std::optional<std::string>> EmbyApi::GetIdsFromPathMap(std::span<const std::string> paths) const
+   {
+      auto pathMap = pathMap_.load();
+
+      std::vector<std::optional<std::string>> ids;
+      ids.reserve(paths.size());
+      for (const auto& path : paths)
+      {
+         ids.emplace_back(pathMap->Find(path));
+      }
+      return ids;
+   }
 }
\ No newline at end of file
@@ -1,80 +1,148 @@
-#pragma once
-
-#include "api/api-base.h"
-#include "api/api-emby-types.h"
-#include "config-reader/config-reader-types.h"
-
-#include <httplib.h>
-
-#include <chrono>
-#include <cstdint>
-#include <list>
-#include <mutex>
-#include <optional>
-#include <string>
-#include <vector>
-
-namespace loomis
-{
-   class EmbyApi : public ApiBase
-   {
-   public:
-      EmbyApi(const ServerConfig& serverConfig);
-      virtual ~EmbyApi() = default;
-
-      [[nodiscard]] std::optional<std::vector<Task>> GetTaskList() override;
-
-      // Returns true if the server is reachable and the API key is valid
-      [[nodiscard]] bool GetValid() override;
-      [[nodiscard]] const std::string& GetMediaPath() const;
-      [[nodiscard]] std::optional<std::string> GetServerReportedName() override;
-      [[nodiscard]] std::optional<std::string> GetLibraryId(std::string_view libraryName);
-
-      std::optional<EmbyItem> GetItem(EmbySearchType type, std::string_view name, const ApiParams& extraSearchArgs = {});
-
-      [[nodiscard]] std::optional<EmbyUserData> GetUser(std::string_view name);
-
-      [[nodiscard]] bool GetWatchedStatus(std::string_view userId, std::string_view itemId);
-      bool SetWatchedStatus(std::string_view userId, std::string_view itemId);
-
-      [[nodiscard]] std::optional<EmbyPlayState> GetPlayState(std::string_view userId, std::string_view itemId);
-      bool SetPlayState(std::string_view userId, std::string_view itemId, int64_t positionTicks, std::string_view dateTimeStr);
-
-      [[nodiscard]] bool GetPlaylistExists(std::string_view name);
-      [[nodiscard]] std::optional<EmbyPlaylist> GetPlaylist(std::string_view name);
-      void CreatePlaylist(std::string_view name, const std::vector<std::string>& itemIds);
-      bool AddPlaylistItems(std::string_view playlistId, const std::vector<std::string>& addIds);
-      bool RemovePlaylistItems(std::string_view playlistId, const std::vector<std::string>& removeIds);
-      bool MovePlaylistItem(std::string_view playlistId, std::string_view itemId, uint32_t index);
-
-      // Tell Emby to scan the passed in library
-      void SetLibraryScan(std::string_view libraryId);
-
-      [[nodiscard]] bool GetPathMapEmpty() const;
-      [[nodiscard]] std::optional<std::string> GetIdFromPathMap(const std::string& path);
-
-   private:
-      std::string_view GetApiBase() const override;
-      std::string_view GetApiTokenName() const override;
-
-      void BuildPathMap();
-      void RunPathMapQuickCheck();
-      void RunPathMapFullUpdate();
-
-      bool HasLibraryChanged();
-
-      std::string_view GetSearchTypeStr(EmbySearchType type);
-
-      httplib::Client client_;
-      httplib::Headers emptyHeaders_;
-      httplib::Headers jsonHeaders_{{{"accept", "application/json"}}};
-
-      std::string mediaPath_;
-
-      std::string lastSyncTimestamp_;
-      EmbyPathMap pathMap_;
-      EmbyPathMap workingPathMap_;
-
-      mutable std::mutex taskLock_;
-   };
+#pragma once
+
+#include "api/api-base.h"
+#include "api/api-emby-path-index.h"
+#include "api/api-emby-types.h"
+#include "api/api-json-string.h"
+#include "api/api-lookup-cache.h"
+#include "config-reader/config-reader-types.h"
+
+#include <httplib.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace loomis
+{
+   class EmbyApi : public ApiBase
+   {
+   public:
+      EmbyApi(const ServerConfig& serverConfig, const std::filesystem::path& cachePath = {});
+
+      // Ensure the worker pool is stopped before the members its work uses are destroyed
+      ~EmbyApi() override
+      {
+         Shutdown();
+      }
+
+      [[nodiscard]] std::optional<std::vector<Task>> GetTaskList() override;
+
+      [[nodiscard]] const std::string& GetMediaPath() const;
+      [[nodiscard]] std::optional<std::string> GetServerReportedName() override;
+      [[nodiscard]] std::optional<std::string> GetLibraryId(std::string_view libraryName);
+
+      std::optional<EmbyItem> GetItem(EmbySearchType type, std::string_view name, const ApiParams& extraSearchArgs = {});
+
+      [[nodiscard]] std::optional<EmbyUserData> GetUser(std::string_view name);
+
+      [[nodiscard]] bool GetWatchedStatus(std::string_view userId, std::string_view itemId);
+      bool SetWatchedStatus(std::string_view userId, std::string_view itemId);
+
+      [[nodiscard]] std::optional<EmbyPlayState> GetPlayState(std::string_view userId, std::string_view itemId);
+
+      // Fetches the play state of many items with a few requests. Items that are not a movie or episode are left out.
+      [[nodiscard]] EmbyPlayStates GetPlayStates(std::string_view userId, std::span<const std::string> itemIds);
+
+      // Pages through every played or in progress item of the user. With a date every item whose user data was saved
+      // since then is returned instead, unplayed ones included, so marking unplayed or clearing a resume point shows up.
+      // Returns nullopt if any page fails so a partial table is never used.
+      [[nodiscard]] std::optional<EmbyWatchStates> GetWatchStates(std::string_view userId, std::string_view minDateLastSaved = {});
+      bool SetPlayState(std::string_view userId, std::string_view itemId, int64_t positionTicks, std::string_view dateTimeStr);
+
+      // Async variants run on the api worker pool
+      [[nodiscard]] std::future<bool> GetWatchedStatusAsync(std::string_view userId, std::string_view itemId);
+      [[nodiscard]] std::future<bool> SetWatchedStatusAsync(std::string_view userId, std::string_view itemId);
+      [[nodiscard]] std::future<std::optional<EmbyPlayState>> GetPlayStateAsync(std::string_view userId, std::string_view itemId);
+      [[nodiscard]] std::future<bool> SetPlayStateAsync(std::string_view userId, std::string_view itemId, int64_t positionTicks, std::string_view dateTimeStr);
+
+      [[nodiscard]] bool GetPlaylistExists(std::string_view name);
+      [[nodiscard]] std::optional<EmbyPlaylist> GetPlaylist(std::string_view name);
+      void CreatePlaylist(std::string_view name, const std::vector<std::string>& itemIds);
+      bool AddPlaylistItems(std::string_view playlistId, const std::vector<std::string>& addIds);
+      bool RemovePlaylistItems(std::string_view playlistId, const std::vector<std::string>& removeIds);
+      bool MovePlaylistItem(std::string_view playlistId, std::string_view itemId, uint32_t index);
+
+      // Tell Emby to scan the passed in library
+      void SetLibraryScan(std::string_view libraryId);
+
+      [[nodiscard]] bool GetPathMapEmpty() const;
+      [[nodiscard]] EmbyPathMapStats GetPathMapStats() const;
+      [[nodiscard]] std::optional<std::string> GetIdFromPathMap(const std::string& path) const;
+
+      // Resolves all paths against the same path map snapshot. Results are in the same order as the paths.
+      [[nodiscard]] std::vector<std::optional<std::string>> GetIdsFromPathMap(std::span<const std::string> paths) const;
+
+   private:
+      [[nodiscard]] bool ProbeServer() override;
+      [[nodiscard]] bool GetRequestIdempotent(std::string_view method, std::string_view path) const override;
+
+      // One chunk of a play state batch. Shared with any caller asking for the same chunk at the same time.
+      [[nodiscard]] std::shared_ptr<const EmbyPlayStates> GetPlayStatesChunk(const std::string& path);
+      std::string_view GetApiBase() const override;
+      std::string_view GetApiTokenName() const override;
+
+      [[nodiscard]] std::string BuildPathMapQuery(const ApiParams& extraParams, const ApiParams& profile) const;
+      [[nodiscard]] std::optional<uint32_t> GetPathMapItemCount();
+
+      // Items of one path map page. The entries point into the arena of the page.
+      struct PathMapPage
+      {
+         JsonStringArena arena;
+         EmbyPathIndex::Entries entries;
+         std::string maxTimestamp;
+      };
+
+      // Streams one page of the library into a page. Items are decoded as they arrive so the reply is never buffered.
+      [[nodiscard]] std::optional<PathMapPage> GetPathMapPage(uint32_t startIndex);
+      void BuildPathMap();
+      void RunPathMapQuickCheck();
+
+      // Loads the path map saved by the last rebuild. Returns true if the map is ready to use.
+      [[nodiscard]] bool LoadPathMapFile();
+      void RunPathMapFullUpdate();
+
+      // Patches the path map with items saved since the last sync.
+      // Returns false if the map could not be patched and needs a full rebuild.
+      [[nodiscard]] bool ApplyPathMapDelta();
+
+      [[nodiscard]] std::optional<ApiLookupCache<std::string>::Map> LoadLibraryIds();
+      [[nodiscard]] std::optional<ApiLookupCache<EmbyUserData>::Map> LoadUsers();
+      void RunLookupCacheRefresh();
+
+      std::string_view GetSearchTypeStr(EmbySearchType type);
+
+      httplib::Headers emptyHeaders_;
+      httplib::Headers jsonHeaders_{{{"accept", "application/json"}}};
+
+      std::string mediaPath_;
+
+      // Library name -> id
+      ApiLookupCache<std::string> libraryIds_{[this]() { return LoadLibraryIds(); }};
+
+      // User name -> user. Shared by every configured user of this server and reloaded once the cache ttl passes.
+      ApiLookupCache<EmbyUserData> users_{[this]() { return LoadUsers(); }};
+
+      // Readers load the current snapshot without locking. Writers build a new snapshot and swap it in.
+      std::atomic<std::shared_ptr<const EmbyPathMapSnapshot>> pathMap_{std::make_shared<const EmbyPathMapSnapshot>()};
+
+      // Serializes path map writers between the cron tasks and the startup revalidation
+      std::mutex pathMapUpdateLock_;
+
+      // Empty if the path map is not persisted
+      std::filesystem::path pathMapFile_;
+
+      // Declared last so it is joined before the members it uses are destroyed
+      std::jthread pathMapRevalidateThread_;
+   };
 }
\ No newline at end of file
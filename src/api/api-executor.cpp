@@ -0,0 +1,84 @@
+#include "api-executor.h"
+
+#include <algorithm>
+
+namespace loomis
+{
+   namespace
+   {
+      // Executor whose worker is running on this thread
+      thread_local const ApiExecutor* currentExecutor{nullptr};
+   }
+
+   ApiExecutor::ApiExecutor(size_t threadCount)
+      : threadCount_(std::max<size_t>(threadCount, 1u))
+   {
+   }
+
+   ApiExecutor::~ApiExecutor()
+   {
+      Shutdown();
+   }
+
+   void ApiExecutor::Shutdown()
+   {
+      std::vector<std::jthread> threads;
+      {
+         std::lock_guard lock(lock_);
+         stopped_ = true;
+         threads.swap(threads_);
+      }
+
+      for (auto& thread : threads) thread.request_stop();
+      cv_.notify_all();
+
+      // jthread joins on destruction. Clear here so workers finish before the queue is destroyed.
+      threads.clear();
+   }
+
+   void ApiExecutor::Enqueue(std::function<void()> work)
+   {
+      {
+         std::unique_lock lock(lock_);
+         // Run on the calling thread after shutdown or when a worker would otherwise wait on its own pool
+         if (stopped_ || currentExecutor == this)
+         {
+            lock.unlock();
+            work();
+            return;
+         }
+
+         if (threads_.empty())
+         {
+            threads_.reserve(threadCount_);
+            for (size_t i = 0; i < threadCount_; ++i)
+            {
+               threads_.emplace_back([this](std::stop_token st) { Work(st); });
+            }
+         }
+
+         queue_.emplace_back(std::move(work));
+      }
+      cv_.notify_one();
+   }
+
+   void ApiExecutor::Work(std::stop_token stopToken)
+   {
+      currentExecutor = this;
+      while (!stopToken.stop_requested())
+      {
+         std::function<void()> work;
+         {
+            std::unique_lock lock(lock_);
+            cv_.wait(lock, stopToken, [this] { return !queue_.empty(); });
+            if (queue_.empty()) continue;
+
+            work = std::move(queue_.front());
+            queue_.pop_front();
+         }
+
+         // Exceptions are captured by the packaged task and delivered through the future
+         work();
+      }
+   }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace loomis
+{
+   // Small worker pool used to keep several blocking api requests in flight at once.
+   // Worker threads are only started the first time work is submitted.
+   // Work submitted from one of the executor's own workers runs on that worker so queued work never
+   // waits on work queued behind it.
+   class ApiExecutor
+   {
+   public:
+      explicit ApiExecutor(size_t threadCount);
+      ~ApiExecutor();
+
+      ApiExecutor(const ApiExecutor&) = delete;
+      ApiExecutor& operator=(const ApiExecutor&) = delete;
+
+      template <typename F>
+      [[nodiscard]] auto Submit(F&& func) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+      {
+         using ResultT = std::invoke_result_t<std::decay_t<F>>;
+
+         // packaged_task is move only but the queue requires copyable functions
+         auto task = std::make_shared<std::packaged_task<ResultT()>>(std::forward<F>(func));
+         auto future = task->get_future();
+         Enqueue([task]() { (*task)(); });
+         return future;
+      }
+
+      // Stops and joins the workers. Queued work that has not started is dropped.
+      // Work submitted after this runs on the calling thread.
+      void Shutdown();
+
+   private:
+      void Enqueue(std::function<void()> work);
+      void Work(std::stop_token stopToken);
+
+      size_t threadCount_{1u};
+      bool stopped_{false};
+      std::vector<std::jthread> threads_;
+
+      std::deque<std::function<void()>> queue_;
+      std::mutex lock_;
+      std::condition_variable_any cv_;
+   };
+}
@@ -0,0 +1,46 @@
+#include "api-health-monitor.h"
+
+#include <chrono>
+
+namespace loomis
+{
+   void ApiHealthMonitor::Start(std::vector<ApiBase*> apis)
+   {
+      if (runThread_ || apis.empty()) return;
+
+      apis_ = std::move(apis);
+      runThread_ = std::make_unique<std::jthread>([this](std::stop_token st) { Work(st); });
+   }
+
+   void ApiHealthMonitor::Work(std::stop_token stopToken)
+   {
+      while (!stopToken.stop_requested())
+      {
+         auto nextWaitPoint = std::chrono::steady_clock::now() + std::chrono::hours(1);
+         for (auto* api : apis_)
+         {
+            if (stopToken.stop_requested()) return;
+
+            if (api->GetNextHealthProbe() <= std::chrono::steady_clock::now()) api->RunHealthProbe();
+
+            if (auto nextProbe = api->GetNextHealthProbe(); nextProbe < nextWaitPoint) nextWaitPoint = nextProbe;
+         }
+
+         std::unique_lock<std::mutex> lock(cvLock_);
+         cv_.wait_until(lock, stopToken, nextWaitPoint, [&] {
+            return stopToken.stop_requested();
+         });
+      }
+   }
+
+   void ApiHealthMonitor::Shutdown()
+   {
+      if (!runThread_) return;
+
+      runThread_->request_stop();
+      cv_.notify_all();
+
+      if (runThread_->joinable()) runThread_->join();
+      runThread_.reset();
+   }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "api/api-base.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace loomis
+{
+   // Probes every server on its own schedule from one background thread so callers only read the cached status.
+   // Servers that are up are probed every minute and servers that are down are probed less often the longer they stay down.
+   class ApiHealthMonitor
+   {
+   public:
+      ApiHealthMonitor() = default;
+
+      // Stop before the apis it probes are destroyed
+      ~ApiHealthMonitor()
+      {
+         Shutdown();
+      }
+
+      void Start(std::vector<ApiBase*> apis);
+      void Shutdown();
+
+   private:
+      void Work(std::stop_token stopToken);
+
+      std::vector<ApiBase*> apis_;
+
+      std::mutex cvLock_;
+      std::condition_variable_any cv_;
+      std::unique_ptr<std::jthread> runThread_;
+   };
+}
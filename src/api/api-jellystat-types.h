@@ -1,53 +1,103 @@
-#pragma once
-
-#include <glaze/glaze.hpp>
-
-#include <chrono>
-#include <cstdint>
-#include <optional>
-#include <string>
-#include <vector>
-
-namespace loomis
-{
-   struct JellystatHistoryItem
-   {
-      std::string name;
-      std::string id;
-      std::string user;
-      std::string watchTime;
-      std::optional<std::string> seriesName;
-      std::optional<std::string> episodeId;
-
-      std::string GetFullName() const
-      {
-         return seriesName ? (*seriesName + " - " + name) : name;
-      }
-
-      struct glaze
-      {
-         // Glaze knows how to handle chrono types automatically
-         static constexpr auto value = glz::object(
-            "NowPlayingItemName", &JellystatHistoryItem::name,
-            "NowPlayingItemId", &JellystatHistoryItem::id,
-            "UserName", &JellystatHistoryItem::user,
-            "ActivityDateInserted", &JellystatHistoryItem::watchTime,
-            "SeriesName", &JellystatHistoryItem::seriesName,
-            "EpisodeId", &JellystatHistoryItem::episodeId
-         );
-      };
-   };
-
-   struct JellystatHistoryItems
-   {
-      std::vector<JellystatHistoryItem> items;
-
-      struct glaze
-      {
-         // Glaze knows how to handle chrono types automatically
-         static constexpr auto value = glz::object(
-            "results", &JellystatHistoryItems::items
-         );
-      };
-   };
+#pragma once
+
+#include <glaze/glaze.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace loomis
+{
+   // Newest history row already handled. Insert times are ISO 8601 so they order as strings
+   // and the activity id tells apart rows inserted at the same time.
+   struct JellystatHistoryWatermark
+   {
+      std::string watchTime;
+      std::string activityId;
+   };
+
+   struct JellystatHistoryItem
+   {
+      std::string activityId;
+      std::string name;
+      std::string id;
+      std::string user;
+      std::string watchTime;
+      std::optional<std::string> seriesName;
+      std::optional<std::string> episodeId;
+
+      std::string GetFullName() const
+      {
+         return seriesName ? (*seriesName + " - " + name) : name;
+      }
+
+      struct glaze
+      {
+         // Glaze knows how to handle chrono types automatically
+         static constexpr auto value = glz::object(
+            "Id", &JellystatHistoryItem::activityId,
+            "NowPlayingItemName", &JellystatHistoryItem::name,
+            "NowPlayingItemId", &JellystatHistoryItem::id,
+            "UserName", &JellystatHistoryItem::user,
+            "ActivityDateInserted", &JellystatHistoryItem::watchTime,
+            "SeriesName", &JellystatHistoryItem::seriesName,
+            "EpisodeId", &JellystatHistoryItem::episodeId
+         );
+      };
+   };
+
+   struct JellystatHistoryItems
+   {
+      std::vector<JellystatHistoryItem> items;
+
+      // Newest row read. Stays at the requested watermark when there were no new rows.
+      std::optional<JellystatHistoryWatermark> watermark;
+
+      struct glaze
+      {
+         // Glaze knows how to handle chrono types automatically
+         static constexpr auto value = glz::object(
+            "results", &JellystatHistoryItems::items
+         );
+      };
+   };
+
+   struct JellystatHistoryFilter
+   {
+      std::string field;
+      std::string min;
+
+      struct glaze
+      {
+         static constexpr auto value = glz::object(
+            "field", &JellystatHistoryFilter::field,
+            "min", &JellystatHistoryFilter::min
+         );
+      };
+   };
+
+   // Body of a paged history request. Pages start at 1.
+   struct JellystatHistoryRequest
+   {
+      std::string userId;
+      int32_t size{0};
+      int32_t page{1};
+      std::string sort;
+      bool desc{true};
+      std::vector<JellystatHistoryFilter> filters;
+
+      struct glaze
+      {
+         static constexpr auto value = glz::object(
+            "userid", &JellystatHistoryRequest::userId,
+            "size", &JellystatHistoryRequest::size,
+            "page", &JellystatHistoryRequest::page,
+            "sort", &JellystatHistoryRequest::sort,
+            "desc", &JellystatHistoryRequest::desc,
+            "filters", &JellystatHistoryRequest::filters
+         );
+      };
+   };
 }
\ No newline at end of file
@@ -1,85 +1,158 @@
-#include "api-jellystat.h"
-
-#include "logger/log-utils.h"
-
-#include <glaze/glaze.hpp>
-
-#include <format>
-#include <ranges>
-
-namespace loomis
-{
-   namespace
-   {
-      const std::string API_BASE{"/api"};
-      const std::string API_GET_CONFIG{"/getconfig"};
-      const std::string API_GET_USER_HISTORY{"/getUserHistory"};
-
-      const std::string APPLICATION_JSON{"application/json"};
-   }
-
-   JellystatApi::JellystatApi(const ServerConfig& serverConfig)
-      : ApiBase(serverConfig.server_name, serverConfig.tracker_url, serverConfig.tracker_api_key, "JellystatApi", log::ANSI_CODE_JELLYSTAT)
-      , client_(GetUrl())
-   {
-      headers_ = {
-         {"x-api-token", GetApiKey()},
-         {"Content-Type", APPLICATION_JSON}
-      };
-
-      constexpr time_t timeoutSec{5};
-      client_.set_connection_timeout(timeoutSec);
-   }
-
-   std::string_view JellystatApi::GetApiBase() const
-   {
-      return API_BASE;
-   }
-
-   std::string_view JellystatApi::GetApiTokenName() const
-   {
-      // Jellystat api key is sent via header
-      return "";
-   }
-
-   std::string JellystatApi::ParamsToJson(const std::list<std::pair<std::string_view, std::string_view>> params)
-   {
-      // Copy into a standard map so Glaze recognizes the structure
-      std::map<std::string_view, std::string_view> m;
-      for (const auto& [key, value] : params)
-      {
-         m[key] = value;
-      }
-
-      return glz::write_json(m).value_or("{}");
-   }
-
-   bool JellystatApi::GetValid()
-   {
-      auto res = client_.Get(BuildApiPath(API_GET_CONFIG), headers_);
-      return res.error() == httplib::Error::Success && res.value().status < VALID_HTTP_RESPONSE_MAX;
-   }
-
-   std::optional<std::string> JellystatApi::GetServerReportedName()
-   {
-      // Jellystat api does not support server name
-      return std::nullopt;
-   }
-
-   std::optional<JellystatHistoryItems> JellystatApi::GetWatchHistoryForUser(std::string_view userId)
-   {
-      auto payload = ParamsToJson({{ "userid", userId }});
-      auto res = client_.Post(BuildApiPath(API_GET_USER_HISTORY), headers_, payload, APPLICATION_JSON);
-      if (!IsHttpSuccess(__func__, res)) return std::nullopt;
-
-      JellystatHistoryItems serverResponse;
-      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (serverResponse, res.value().body))
-      {
-         LogWarning("{} - JSON Parse Error: {}",
-                    __func__, glz::format_error(ec, res.value().body));
-         return std::nullopt;
-      }
-
-      return serverResponse;
-   }
+#include "api-jellystat.h"
+
+#include "api/api-utils.h"
+#include "logger/log-utils.h"
+
+#include <glaze/glaze.hpp>
+
+#include <format>
+#include <ranges>
+
+namespace loomis
+{
+   namespace
+   {
+      const std::string API_BASE{"/api"};
+      const std::string API_GET_CONFIG{"/getconfig"};
+      const std::string API_GET_USER_HISTORY{"/getUserHistory"};
+
+      const std::string APPLICATION_JSON{"application/json"};
+
+      const std::string HISTORY_SORT_FIELD{"ActivityDateInserted"};
+      constexpr int32_t HISTORY_PAGE_SIZE{100};
+
+      bool GetAfterWatermark(const JellystatHistoryItem& item, const std::optional<JellystatHistoryWatermark>& watermark)
+      {
+         if (!watermark) return true;
+         return item.watchTime != watermark->watchTime ? item.watchTime > watermark->watchTime : item.activityId > watermark->activityId;
+      }
+   }
+
+   JellystatApi::JellystatApi(const ServerConfig& serverConfig, const std::filesystem::path& cachePath)
+      : ApiBase(serverConfig, serverConfig.tracker_url, serverConfig.tracker_api_key, "JellystatApi", log::ANSI_CODE_JELLYSTAT)
+      , historyWatermarks_(cachePath.empty() ? std::filesystem::path{} : GetServerCacheFileName(cachePath, "jellystat-history-", serverConfig.server_name, ".json"))
+   {
+      headers_ = {
+         {"x-api-token", GetApiKey()},
+         {"Content-Type", APPLICATION_JSON}
+      };
+   }
+
+   std::string_view JellystatApi::GetApiBase() const
+   {
+      return API_BASE;
+   }
+
+   std::string_view JellystatApi::GetApiTokenName() const
+   {
+      // Jellystat api key is sent via header
+      return "";
+   }
+
+   bool JellystatApi::ProbeServer()
+   {
+      auto res = Get(BuildApiPath(API_GET_CONFIG), headers_);
+      return res.error() == httplib::Error::Success && res.value().status < VALID_HTTP_RESPONSE_MAX;
+   }
+
+   bool JellystatApi::GetRequestIdempotent(std::string_view, std::string_view) const
+   {
+      // Every call made is a read even when sent as a POST
+      return true;
+   }
+
+   std::optional<std::string> JellystatApi::GetServerReportedName()
+   {
+      // Jellystat api does not support server name
+      return std::nullopt;
+   }
+
+   std::optional<JellystatApi::HistoryPageCount> JellystatApi::GetWatchHistoryPage(const JellystatHistoryRequest& request,
+                                                                                 std::string_view minWatchTime,
+                                                                                 const std::optional<JellystatHistoryWatermark>& watermark,
+                                                                                 JellystatHistoryItems& history)
+   {
+      auto payload = glz::write_json(request).value_or("{}");
+
+      // Rows come newest first so the first row that is too old or already handled ends the read.
+      // The server filters on the time too but older servers ignore it.
+      HistoryPageCount count;
+      JellystatHistoryItem item;
+      JsonArrayStream stream({"results"}, [&](const std::string& element) {
+         item = {};
+         if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (item, element))
+         {
+            LogWarning("{} - JSON Parse Error: {}",
+                       __func__, glz::format_error(ec, element));
+            return false;
+         }
+
+         ++count.rows;
+         if (count.done) return true;
+         if (item.watchTime < minWatchTime || !GetAfterWatermark(item, watermark))
+         {
+            count.done = true;
+            return true;
+         }
+
+         if (GetAfterWatermark(item, history.watermark))
+         {
+            history.watermark = JellystatHistoryWatermark{.watchTime = item.watchTime, .activityId = item.activityId};
+         }
+         history.items.emplace_back(std::move(item));
+         return true;
+      });
+
+      auto res = PostStream(BuildApiPath(API_GET_USER_HISTORY), headers_, payload, APPLICATION_JSON, stream.GetReceiver());
+      if (!IsJsonStreamSuccess(__func__, res, stream)) return std::nullopt;
+
+      return count;
+   }
+
+   std::optional<JellystatHistoryItems> JellystatApi::GetWatchHistoryForUser(std::string_view userId,
+                                                                             std::string_view minWatchTime,
+                                                                             const std::optional<JellystatHistoryWatermark>& watermark)
+   {
+      JellystatHistoryRequest request{
+         .userId = std::string(userId),
+         .size = HISTORY_PAGE_SIZE,
+         .page = 1,
+         .sort = HISTORY_SORT_FIELD,
+         .desc = true,
+         .filters = {{.field = HISTORY_SORT_FIELD, .min = std::string(minWatchTime)}}
+      };
+
+      JellystatHistoryItems history;
+      history.watermark = watermark;
+      for (;; ++request.page)
+      {
+         auto count = GetWatchHistoryPage(request, minWatchTime, watermark, history);
+         if (!count) return std::nullopt;
+         if (count->done || count->rows < static_cast<size_t>(HISTORY_PAGE_SIZE)) break;
+      }
+
+      return history;
+   }
+
+   std::optional<JellystatHistoryWatermark> JellystatApi::GetHistoryWatermark(std::string_view key) const
+   {
+      return historyWatermarks_.Find(key);
+   }
+
+   void JellystatApi::SetHistoryWatermark(std::string_view key, const JellystatHistoryWatermark& watermark)
+   {
+      if (!historyWatermarks_.Set(key, watermark))
+      {
+         LogWarning("{} - Failed to save the history watermark {}", __func__, log::GetTag("key", key));
+      }
+   }
+
+   std::future<std::optional<JellystatHistoryItems>> JellystatApi::GetWatchHistoryForUserAsync(std::string_view userId,
+                                                                                               std::string_view minWatchTime,
+                                                                                               const std::optional<JellystatHistoryWatermark>& watermark)
+   {
+      return RunAsync([this, userId = std::string(userId), minWatchTime = std::string(minWatchTime), watermark]() {
+         return GetWatchHistoryForUser(userId, minWatchTime, watermark);
+      });
+   }
 }
\ No newline at end of file
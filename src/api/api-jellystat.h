@@ -1,36 +1,67 @@
-#pragma once
-
-#include "api/api-base.h"
-#include "api/api-jellystat-types.h"
-#include "config-reader/config-reader-types.h"
-
-#include <httplib.h>
-
-#include <list>
-#include <optional>
-#include <string>
-
-namespace loomis
-{
-   class JellystatApi : public ApiBase
-   {
-   public:
-      JellystatApi(const ServerConfig& serverConfig);
-      virtual ~JellystatApi() = default;
-
-      // Returns true if the server is reachable and the API key is valid
-      [[nodiscard]] bool GetValid() override;
-      [[nodiscard]] std::optional<std::string> GetServerReportedName() override;
-
-      [[nodiscard]] std::optional<JellystatHistoryItems> GetWatchHistoryForUser(std::string_view userId);
-
-   private:
-      std::string_view GetApiBase() const override;
-      std::string_view GetApiTokenName() const override;
-
-      std::string ParamsToJson(const std::list<std::pair<std::string_view, std::string_view>> params);
-
-      httplib::Client client_;
-      httplib::Headers headers_;
-   };
+#pragma once
+
+#include "api/api-base.h"
+#include "api/api-jellystat-types.h"
+#include "api/api-watermark-store.h"
+#include "config-reader/config-reader-types.h"
+
+#include <httplib.h>
+
+#include <filesystem>
+#include <future>
+#include <optional>
+#include <string>
+
+namespace loomis
+{
+   class JellystatApi : public ApiBase
+   {
+   public:
+      JellystatApi(const ServerConfig& serverConfig, const std::filesystem::path& cachePath = {});
+
+      // Ensure the worker pool is stopped before the members its work uses are destroyed
+      ~JellystatApi() override
+      {
+         Shutdown();
+      }
+
+      [[nodiscard]] std::optional<std::string> GetServerReportedName() override;
+
+      // Pages through the history of the user inserted since the time, newest first. With a watermark only the rows
+      // after it are returned. Paging stops at the first row that is too old or already handled.
+      [[nodiscard]] std::optional<JellystatHistoryItems> GetWatchHistoryForUser(std::string_view userId,
+                                                                                std::string_view minWatchTime,
+                                                                                const std::optional<JellystatHistoryWatermark>& watermark = std::nullopt);
+
+      // Watermarks are saved in the cache folder so a restart does not process the same rows again
+      [[nodiscard]] std::optional<JellystatHistoryWatermark> GetHistoryWatermark(std::string_view key) const;
+      void SetHistoryWatermark(std::string_view key, const JellystatHistoryWatermark& watermark);
+
+      // Async variant runs on the api worker pool
+      [[nodiscard]] std::future<std::optional<JellystatHistoryItems>> GetWatchHistoryForUserAsync(std::string_view userId,
+                                                                                                  std::string_view minWatchTime,
+                                                                                                  const std::optional<JellystatHistoryWatermark>& watermark = std::nullopt);
+
+   private:
+      [[nodiscard]] bool ProbeServer() override;
+      [[nodiscard]] bool GetRequestIdempotent(std::string_view method, std::string_view path) const override;
+      std::string_view GetApiBase() const override;
+      std::string_view GetApiTokenName() const override;
+
+      struct HistoryPageCount
+      {
+         size_t rows{0u};
+         bool done{false};
+      };
+
+      // Adds the rows of one page that are newer than the time and the watermark to the history
+      [[nodiscard]] std::optional<HistoryPageCount> GetWatchHistoryPage(const JellystatHistoryRequest& request,
+                                                                        std::string_view minWatchTime,
+                                                                        const std::optional<JellystatHistoryWatermark>& watermark,
+                                                                        JellystatHistoryItems& history);
+
+      httplib::Headers headers_;
+
+      ApiWatermarkStore<JellystatHistoryWatermark> historyWatermarks_;
+   };
 }
\ No newline at end of file
@@ -0,0 +1,249 @@
+#include "api-json-stream.h"
+
+namespace loomis
+{
+   namespace
+   {
+      bool IsJsonWhitespace(char c)
+      {
+         return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+      }
+   }
+
+   JsonArrayStream::JsonArrayStream(std::vector<std::string> keyPath, ElementSink sink)
+      : keyPath_(std::move(keyPath))
+      , sink_(std::move(sink))
+   {
+   }
+
+   bool JsonArrayStream::Feed(const char* data, size_t size)
+   {
+      for (size_t i = 0; i < size && !failed_; ++i)
+      {
+         if (inArray_)
+         {
+            ScanArrayChar(data[i]);
+         }
+         else
+         {
+            ScanChar(data[i]);
+         }
+      }
+      return !failed_;
+   }
+
+   httplib::ContentReceiver JsonArrayStream::GetReceiver()
+   {
+      return [this](const char* data, size_t size) {
+         return Feed(data, size);
+      };
+   }
+
+   bool JsonArrayStream::GetComplete() const
+   {
+      return complete_ && !failed_;
+   }
+
+   bool JsonArrayStream::GetFailed() const
+   {
+      return failed_;
+   }
+
+   const std::string& JsonArrayStream::GetError() const
+   {
+      return error_;
+   }
+
+   std::string JsonArrayStream::GetKeyPathStr() const
+   {
+      std::string keyPathStr;
+      for (const auto& key : keyPath_)
+      {
+         if (!keyPathStr.empty()) keyPathStr += '.';
+         keyPathStr += key;
+      }
+      return keyPathStr;
+   }
+
+   void JsonArrayStream::ScanChar(char c)
+   {
+      if (inString_)
+      {
+         if (escape_)
+         {
+            escape_ = false;
+         }
+         else if (c == '\\')
+         {
+            escape_ = true;
+         }
+         else if (c == '"')
+         {
+            inString_ = false;
+            if (readingKey_)
+            {
+               keys_.back() = key_;
+               readingKey_ = false;
+            }
+            return;
+         }
+
+         // Keys are compared in their raw form. The keys searched for have no escapes.
+         if (readingKey_) key_ += c;
+         return;
+      }
+
+      switch (c)
+      {
+         case '"':
+            inString_ = true;
+            readingKey_ = expectKey_;
+            expectKey_ = false;
+            key_.clear();
+            break;
+         case '{':
+            OpenContainer(c);
+            break;
+         case '[':
+            if (!complete_ && GetAtKeyPath())
+            {
+               inArray_ = true;
+               elementDepth_ = 0u;
+               element_.clear();
+            }
+            else
+            {
+               OpenContainer(c);
+            }
+            break;
+         case '}':
+         case ']':
+            CloseContainer();
+            break;
+         case ',':
+            expectKey_ = !containers_.empty() && containers_.back() == '{';
+            break;
+         default:
+            // Separators and scalar values outside the array are skipped
+            break;
+      }
+   }
+
+   void JsonArrayStream::ScanArrayChar(char c)
+   {
+      if (inString_)
+      {
+         element_ += c;
+         if (escape_)
+         {
+            escape_ = false;
+         }
+         else if (c == '\\')
+         {
+            escape_ = true;
+         }
+         else if (c == '"')
+         {
+            inString_ = false;
+         }
+         return;
+      }
+
+      if (elementDepth_ == 0u)
+      {
+         if (IsJsonWhitespace(c)) return;
+
+         if (c == ',')
+         {
+            EmitElement();
+            return;
+         }
+
+         if (c == ']')
+         {
+            if (EmitElement())
+            {
+               inArray_ = false;
+               complete_ = true;
+            }
+            return;
+         }
+      }
+
+      element_ += c;
+      switch (c)
+      {
+         case '"':
+            inString_ = true;
+            break;
+         case '{':
+         case '[':
+            ++elementDepth_;
+            break;
+         case '}':
+         case ']':
+            if (elementDepth_ == 0u)
+            {
+               Fail("unbalanced brackets in array element");
+               return;
+            }
+            --elementDepth_;
+            break;
+         default:
+            break;
+      }
+   }
+
+   void JsonArrayStream::OpenContainer(char type)
+   {
+      containers_.push_back(type);
+      keys_.emplace_back();
+      expectKey_ = (type == '{');
+   }
+
+   void JsonArrayStream::CloseContainer()
+   {
+      if (containers_.empty())
+      {
+         Fail("unbalanced brackets");
+         return;
+      }
+
+      containers_.pop_back();
+      keys_.pop_back();
+      expectKey_ = false;
+   }
+
+   bool JsonArrayStream::GetAtKeyPath() const
+   {
+      if (containers_.size() != keyPath_.size()) return false;
+
+      // Every container on the way has to be an object holding the next key
+      for (size_t i = 0; i < keyPath_.size(); ++i)
+      {
+         if (containers_[i] != '{' || keys_[i] != keyPath_[i]) return false;
+      }
+      return true;
+   }
+
+   bool JsonArrayStream::EmitElement()
+   {
+      // Only an empty array has no element before the closing bracket
+      if (element_.empty()) return true;
+
+      // Scalars end at the separator so trailing whitespace is kept out of the element
+      while (!element_.empty() && IsJsonWhitespace(element_.back())) element_.pop_back();
+
+      bool accepted = sink_(element_);
+      element_.clear();
+
+      if (!accepted) Fail("element rejected");
+      return accepted;
+   }
+
+   void JsonArrayStream::Fail(std::string error)
+   {
+      failed_ = true;
+      error_ = std::move(error);
+   }
+}
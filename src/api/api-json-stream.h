@@ -0,0 +1,72 @@
+#pragma once
+
+#include <httplib.h>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace loomis
+{
+   // Splits one array out of a JSON reply while the reply is still arriving so each element can be decoded
+   // on its own. Only the element being read is held in memory, never the whole reply.
+   //
+   // The array is found by the chain of object keys leading to it, e.g. {"response", "data", "data"} for
+   // {"response": {"data": {"data": [...]}}}. An empty chain means the reply itself is the array.
+   // The rest of the reply is only scanned for structure and is not validated.
+   class JsonArrayStream
+   {
+   public:
+      // Called with the JSON text of each element. Return false to stop the transfer.
+      using ElementSink = std::function<bool(const std::string& element)>;
+
+      JsonArrayStream(std::vector<std::string> keyPath, ElementSink sink);
+
+      // Feeds the next chunk of the reply. Returns false when the transfer should stop.
+      bool Feed(const char* data, size_t size);
+
+      // Content receiver for a streaming request that feeds this stream
+      [[nodiscard]] httplib::ContentReceiver GetReceiver();
+
+      // The whole array was read
+      [[nodiscard]] bool GetComplete() const;
+
+      // The reply was malformed or the sink stopped the transfer
+      [[nodiscard]] bool GetFailed() const;
+      [[nodiscard]] const std::string& GetError() const;
+
+      [[nodiscard]] std::string GetKeyPathStr() const;
+
+   private:
+      void ScanChar(char c);
+      void ScanArrayChar(char c);
+      void OpenContainer(char type);
+      void CloseContainer();
+      [[nodiscard]] bool GetAtKeyPath() const;
+      bool EmitElement();
+      void Fail(std::string error);
+
+      std::vector<std::string> keyPath_;
+      ElementSink sink_;
+
+      // Containers around the current position and the current key of each object among them
+      std::vector<char> containers_;
+      std::vector<std::string> keys_;
+
+      bool expectKey_{false};
+      bool readingKey_{false};
+      bool inString_{false};
+      bool escape_{false};
+      std::string key_;
+
+      // Element of the target array being collected
+      bool inArray_{false};
+      size_t elementDepth_{0u};
+      std::string element_;
+
+      bool complete_{false};
+      bool failed_{false};
+      std::string error_;
+   };
+}
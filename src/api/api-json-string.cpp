@@ -0,0 +1,166 @@
+#include "api-json-string.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace loomis
+{
+   namespace
+   {
+      // A path map page decodes to well under 1 MB and every page arena is kept until the index is built.
+      // Small blocks keep the unused tail of the last block of each page small.
+      constexpr size_t ARENA_BLOCK_SIZE{64u * 1024u};
+
+      int GetHexValue(char c)
+      {
+         if (c >= '0' && c <= '9') return c - '0';
+         if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+         if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+         return -1;
+      }
+
+      // Reads the 4 hex digits of a \u escape starting at pos
+      bool ReadCodeUnit(std::string_view raw, size_t pos, uint32_t& value)
+      {
+         if (pos + 4 > raw.size()) return false;
+
+         value = 0;
+         for (size_t i = pos; i < pos + 4; ++i)
+         {
+            auto digit = GetHexValue(raw[i]);
+            if (digit < 0) return false;
+            value = (value << 4) | static_cast<uint32_t>(digit);
+         }
+         return true;
+      }
+
+      size_t AppendUtf8(char* out, uint32_t codePoint)
+      {
+         if (codePoint < 0x80)
+         {
+            out[0] = static_cast<char>(codePoint);
+            return 1;
+         }
+         if (codePoint < 0x800)
+         {
+            out[0] = static_cast<char>(0xC0 | (codePoint >> 6));
+            out[1] = static_cast<char>(0x80 | (codePoint & 0x3F));
+            return 2;
+         }
+         if (codePoint < 0x10000)
+         {
+            out[0] = static_cast<char>(0xE0 | (codePoint >> 12));
+            out[1] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out[2] = static_cast<char>(0x80 | (codePoint & 0x3F));
+            return 3;
+         }
+         out[0] = static_cast<char>(0xF0 | (codePoint >> 18));
+         out[1] = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+         out[2] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+         out[3] = static_cast<char>(0x80 | (codePoint & 0x3F));
+         return 4;
+      }
+
+      // Decodes raw into out which must hold raw.size() characters. A decoded string is never longer
+      // than its escaped form. Returns the decoded length.
+      size_t DecodeJsonString(std::string_view raw, char* out)
+      {
+         size_t length{0};
+         for (size_t i = 0; i < raw.size(); ++i)
+         {
+            if (raw[i] != '\\' || i + 1 >= raw.size())
+            {
+               out[length++] = raw[i];
+               continue;
+            }
+
+            char escape = raw[++i];
+            switch (escape)
+            {
+               case 'b': out[length++] = '\b'; break;
+               case 'f': out[length++] = '\f'; break;
+               case 'n': out[length++] = '\n'; break;
+               case 'r': out[length++] = '\r'; break;
+               case 't': out[length++] = '\t'; break;
+               case 'u':
+               {
+                  uint32_t codePoint{0};
+                  if (!ReadCodeUnit(raw, i + 1, codePoint))
+                  {
+                     // Malformed escape. Keep the text as sent.
+                     out[length++] = '\\';
+                     out[length++] = escape;
+                     break;
+                  }
+                  i += 4;
+
+                  // Characters outside the basic plane are sent as a surrogate pair
+                  uint32_t lowSurrogate{0};
+                  if (codePoint >= 0xD800 && codePoint <= 0xDBFF &&
+                      i + 2 < raw.size() && raw[i + 1] == '\\' && raw[i + 2] == 'u' &&
+                      ReadCodeUnit(raw, i + 3, lowSurrogate) && lowSurrogate >= 0xDC00 && lowSurrogate <= 0xDFFF)
+                  {
+                     codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+                     i += 6;
+                  }
+                  length += AppendUtf8(out + length, codePoint);
+                  break;
+               }
+               default:
+                  // \" \\ and \/ stand for the character itself
+                  out[length++] = escape;
+                  break;
+            }
+         }
+         return length;
+      }
+   }
+
+   std::string GetJsonString(std::string_view raw)
+   {
+      if (raw.find('\\') == std::string_view::npos) return std::string{raw};
+
+      std::string decoded(raw.size(), '\0');
+      decoded.resize(DecodeJsonString(raw, decoded.data()));
+      return decoded;
+   }
+
+   bool GetJsonStringEqual(std::string_view raw, std::string_view value)
+   {
+      if (raw.find('\\') == std::string_view::npos) return raw == value;
+      return GetJsonString(raw) == value;
+   }
+
+   std::string_view JsonStringArena::Add(std::string_view raw)
+   {
+      if (raw.empty()) return {};
+
+      if (blocks_.empty() || blockSize_ - blockUsed_ < raw.size())
+      {
+         // Strings larger than a block get a block of their own
+         blockSize_ = std::max(ARENA_BLOCK_SIZE, raw.size());
+         blocks_.emplace_back(std::make_unique_for_overwrite<char[]>(blockSize_));
+         blockUsed_ = 0;
+         memoryUsage_ += blockSize_;
+      }
+
+      char* out = blocks_.back().get() + blockUsed_;
+      size_t length{raw.size()};
+      if (raw.find('\\') == std::string_view::npos)
+      {
+         std::copy(raw.begin(), raw.end(), out);
+      }
+      else
+      {
+         length = DecodeJsonString(raw, out);
+      }
+
+      blockUsed_ += length;
+      return {out, length};
+   }
+
+   size_t JsonStringArena::GetMemoryUsage() const
+   {
+      return memoryUsage_;
+   }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace loomis
+{
+   // JSON strings decoded into std::string_view point at the raw text in the reply body.
+   // Escape sequences are left as they are so these helpers decode them when the string is used.
+
+   // Returns the decoded copy of a raw JSON string
+   [[nodiscard]] std::string GetJsonString(std::string_view raw);
+
+   // Compares a raw JSON string to a decoded value without a copy unless the raw string has escapes
+   [[nodiscard]] bool GetJsonStringEqual(std::string_view raw, std::string_view value);
+
+   // Append only storage for decoded strings that have to outlive the reply body.
+   // Strings are packed into blocks so keeping many of them costs a few allocations in total.
+   class JsonStringArena
+   {
+   public:
+      JsonStringArena() = default;
+
+      JsonStringArena(const JsonStringArena&) = delete;
+      JsonStringArena& operator=(const JsonStringArena&) = delete;
+
+      // Moving keeps the blocks so views handed out stay valid
+      JsonStringArena(JsonStringArena&&) noexcept = default;
+      JsonStringArena& operator=(JsonStringArena&&) noexcept = default;
+
+      // Decodes the raw JSON string into the arena. The view stays valid for the life of the arena.
+      [[nodiscard]] std::string_view Add(std::string_view raw);
+
+      [[nodiscard]] size_t GetMemoryUsage() const;
+
+   private:
+      std::vector<std::unique_ptr<char[]>> blocks_;
+      size_t blockSize_{0u};
+      size_t blockUsed_{0u};
+      size_t memoryUsage_{0u};
+   };
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace loomis
+{
+   // Thread safe name -> value cache filled by a loader that downloads the whole list from a server.
+   // A miss reloads the list since the name may have been added since the last load.
+   // The loaders read through the response cache so its ttl decides how fresh a reload is.
+   template <typename ValueT>
+   class ApiLookupCache
+   {
+   public:
+      using Map = std::unordered_map<std::string, ValueT>;
+      using Loader = std::function<std::optional<Map>()>;
+
+      explicit ApiLookupCache(Loader loader,
+                              std::chrono::seconds minMissReload = std::chrono::seconds(60))
+         : loader_(std::move(loader))
+         , minMissReload_(minMissReload)
+      {
+      }
+
+      [[nodiscard]] std::optional<ValueT> Find(std::string_view name)
+      {
+         const std::string key{name};
+         auto value = FindLoaded(key);
+         if (!GetLoadDue(!value.has_value())) return value;
+
+         std::lock_guard refreshLock(refreshLock_);
+
+         // Another caller may have loaded the list while this one waited
+         if (GetLoadDue(!FindLoaded(key).has_value())) Load();
+         return FindLoaded(key);
+      }
+
+      // Reloads the whole list. The current entries are kept if the load fails.
+      bool Refresh()
+      {
+         std::lock_guard refreshLock(refreshLock_);
+         return Load();
+      }
+
+      void Clear()
+      {
+         std::lock_guard lock(lock_);
+         entries_.clear();
+         lastLoad_.reset();
+      }
+
+   private:
+      [[nodiscard]] std::optional<ValueT> FindLoaded(const std::string& key) const
+      {
+         std::lock_guard lock(lock_);
+         if (auto iter = entries_.find(key); iter != entries_.end()) return iter->second;
+         return std::nullopt;
+      }
+
+      [[nodiscard]] bool GetLoadDue(bool miss) const
+      {
+         std::lock_guard lock(lock_);
+         if (!lastLoad_) return true;
+
+         auto age = std::chrono::steady_clock::now() - *lastLoad_;
+
+         // Names that are not on the server would reload on every call so misses only reload once in a while
+         return miss && age >= minMissReload_;
+      }
+
+      bool Load()
+      {
+         auto entries = loader_();
+
+         std::lock_guard lock(lock_);
+
+         // Failed loads count too so an unreachable server is not asked on every miss
+         lastLoad_ = std::chrono::steady_clock::now();
+         if (!entries) return false;
+
+         entries_ = std::move(*entries);
+         return true;
+      }
+
+      Loader loader_;
+      std::chrono::seconds minMissReload_;
+
+      Map entries_;
+      std::optional<std::chrono::steady_clock::time_point> lastLoad_;
+      mutable std::mutex lock_;
+
+      // Only one load runs at a time
+      std::mutex refreshLock_;
+   };
+}
@@ -1,76 +1,85 @@
-#pragma once
-
-#include "api/api-base.h"
-#include "api/api-emby.h"
-#include "api/api-jellystat.h"
-#include "api/api-plex.h"
-#include "api/api-tautulli.h"
-#include "config-reader/config-reader.h"
-#include "cron-scheduler.h"
-#include "types.h"
-
-#include <memory>
-#include <ranges>
-#include <vector>
-
-namespace loomis
-{
-   class ApiManager
-   {
-   public:
-      ApiManager(std::shared_ptr<ConfigReader> configReader);
-      virtual ~ApiManager() = default;
-
-      void AddTasks(CronScheduler& cronScheduler);
-
-      [[nodiscard]] ApiBase* GetApi(ApiType type, std::string_view name) const;
-      [[nodiscard]] PlexApi* GetPlexApi(std::string_view name) const;
-      [[nodiscard]] EmbyApi* GetEmbyApi(std::string_view name) const;
-      [[nodiscard]] TautulliApi* GetTautulliApi(std::string_view name) const;
-      [[nodiscard]] JellystatApi* GetJellystatApi(std::string_view name) const;
-
-   private:
-      void SetupPlexApis(const std::vector<ServerConfig>& serverConfigs);
-      void SetupEmbyApis(const std::vector<ServerConfig>& serverConfigs);
-
-      void LogServerConnectionSuccess(std::string_view serverName, ApiBase* api);
-      void LogServerConnectionError(std::string_view serverName, ApiBase* api);
-
-      template <typename ApiT, typename ContainerT>
-      ApiT* InitializeApi(ContainerT& container, const ServerConfig& config, std::string_view logName)
-      {
-         auto& api = container.emplace_back(std::make_unique<ApiT>(config));
-         api->GetValid() ? LogServerConnectionSuccess(logName, api.get()) : LogServerConnectionError(logName, api.get());
-         return api.get();
-      }
-
-      template <typename ContainerT>
-      void InitializeTasks(CronScheduler& cronScheduler, ContainerT& container)
-      {
-         for (auto& api : container)
-         {
-            auto taskList = api->GetTaskList();
-            if (taskList)
-            {
-               for (const auto& task : *taskList) cronScheduler.Add(task);
-            }
-         }
-      }
-
-      // In header (private):
-      template <typename T>
-      [[nodiscard]] T* FindApi(const std::vector<std::unique_ptr<T>>& container, std::string_view name) const
-      {
-         auto it = std::ranges::find_if(container, [name](const auto& api) {
-            return api->GetName() == name;
-         });
-         return it != container.end() ? it->get() : nullptr;
-      }
-
-      std::vector<std::unique_ptr<PlexApi>> plexApis_;
-      std::vector<std::unique_ptr<EmbyApi>> embyApis_;
-      std::vector<std::unique_ptr<TautulliApi>> tautulliApis_;
-      std::vector<std::unique_ptr<JellystatApi>> jellystatApis_;
-
-   };
+#pragma once
+
+#include "api/api-base.h"
+#include "api/api-emby.h"
+#include "api/api-health-monitor.h"
+#include "api/api-jellystat.h"
+#include "api/api-plex.h"
+#include "api/api-tautulli.h"
+#include "config-reader/config-reader.h"
+#include "cron-scheduler.h"
+#include "types.h"
+
+#include <filesystem>
+#include <memory>
+#include <ranges>
+#include <utility>
+#include <vector>
+
+namespace loomis
+{
+   class ApiManager
+   {
+   public:
+      ApiManager(std::shared_ptr<ConfigReader> configReader);
+      virtual ~ApiManager() = default;
+
+      void AddTasks(CronScheduler& cronScheduler);
+
+      [[nodiscard]] ApiBase* GetApi(ApiType type, std::string_view name) const;
+
+      // Every configured api in setup order
+      [[nodiscard]] std::vector<ApiBase*> GetApis() const;
+      [[nodiscard]] PlexApi* GetPlexApi(std::string_view name) const;
+      [[nodiscard]] EmbyApi* GetEmbyApi(std::string_view name) const;
+      [[nodiscard]] TautulliApi* GetTautulliApi(std::string_view name) const;
+      [[nodiscard]] JellystatApi* GetJellystatApi(std::string_view name) const;
+
+   private:
+      void SetupPlexApis(const std::vector<ServerConfig>& serverConfigs, const std::filesystem::path& cachePath);
+      void SetupEmbyApis(const std::vector<ServerConfig>& serverConfigs, const std::filesystem::path& cachePath);
+
+      void LogServerConnectionSuccess(std::string_view serverName, ApiBase* api);
+      void LogServerConnectionError(std::string_view serverName, ApiBase* api);
+
+      template <typename ApiT, typename ContainerT, typename... Args>
+      ApiT* InitializeApi(ContainerT& container, const ServerConfig& config, std::string_view logName, Args&&... args)
+      {
+         auto& api = container.emplace_back(std::make_unique<ApiT>(config, std::forward<Args>(args)...));
+         api->GetValid() ? LogServerConnectionSuccess(logName, api.get()) : LogServerConnectionError(logName, api.get());
+         return api.get();
+      }
+
+      template <typename ContainerT>
+      void InitializeTasks(CronScheduler& cronScheduler, ContainerT& container)
+      {
+         for (auto& api : container)
+         {
+            auto taskList = api->GetTaskList();
+            if (taskList)
+            {
+               for (const auto& task : *taskList) cronScheduler.Add(task);
+            }
+         }
+      }
+
+      // In header (private):
+      template <typename T>
+      [[nodiscard]] T* FindApi(const std::vector<std::unique_ptr<T>>& container, std::string_view name) const
+      {
+         auto it = std::ranges::find_if(container, [name](const auto& api) {
+            return api->GetName() == name;
+         });
+         return it != container.end() ? it->get() : nullptr;
+      }
+
+      std::vector<std::unique_ptr<PlexApi>> plexApis_;
+      std::vector<std::unique_ptr<EmbyApi>> embyApis_;
+      std::vector<std::unique_ptr<TautulliApi>> tautulliApis_;
+      std::vector<std::unique_ptr<JellystatApi>> jellystatApis_;
+
+      // Declared after the apis so it stops before they are destroyed
+      ApiHealthMonitor healthMonitor_;
+
+   };
 }
\ No newline at end of file
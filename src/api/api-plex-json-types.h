@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace loomis
+{
+   // Plex replies with the same MediaContainer layout for every endpoint. Only the fields used are listed.
+   struct JsonPlexPart
+   {
+      std::string file;
+   };
+
+   struct JsonPlexMedia
+   {
+      std::vector<JsonPlexPart> Part;
+   };
+
+   struct JsonPlexMetadata
+   {
+      std::string ratingKey;
+      std::string key;
+      std::string type;
+      std::string title;
+      std::string grandparentTitle;
+      std::string librarySectionTitle;
+      int64_t duration{0};
+      int64_t addedAt{0};
+      int64_t updatedAt{0};
+      int32_t viewCount{0};
+      std::optional<int64_t> viewOffset;
+      std::vector<JsonPlexMedia> Media;
+   };
+
+   struct JsonPlexDirectory
+   {
+      std::string key;
+      std::string title;
+      std::string type;
+   };
+
+   struct JsonPlexHub
+   {
+      std::string type;
+      std::vector<JsonPlexMetadata> Metadata;
+   };
+
+   struct JsonPlexServer
+   {
+      std::string name;
+   };
+
+   struct JsonPlexMediaContainer
+   {
+      std::optional<uint32_t> totalSize;
+      std::vector<JsonPlexMetadata> Metadata;
+      std::vector<JsonPlexDirectory> Directory;
+      std::vector<JsonPlexHub> Hub;
+      std::vector<JsonPlexServer> Server;
+   };
+
+   struct JsonPlexResponse
+   {
+      JsonPlexMediaContainer MediaContainer;
+   };
+}
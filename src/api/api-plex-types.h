@@ -1,58 +1,106 @@
-#pragma once
-
-#include <string>
-#include <vector>
-
-namespace loomis
-{
-   enum class PlexSearchTypes
-   {
-      movie = 1,
-      show = 2,
-      season = 3,
-      episode = 4,
-      trailer = 5,
-      comic = 6,
-      person = 7,
-      artist = 8,
-      album = 9,
-      track = 10,
-      picture = 11,
-      clip = 12,
-      photo = 13,
-      photoalbum = 14,
-      playlist = 15,
-      playlistFolder = 16,
-      collection = 18,
-      optimizedVersion = 42,
-      userPlaylistItem = 1001,
-   };
-
-   struct PlexCollectionItem
-   {
-      std::string title;
-      std::vector<std::string> paths;
-   };
-
-   struct PlexCollection
-   {
-      std::string name;
-      std::vector<PlexCollectionItem> items;
-   };
-
-   struct PlexSearchResult
-   {
-      std::string ratingKey;
-      std::string path;
-      std::string title;
-      std::string libraryName;
-      int64_t durationMs{0};
-      int32_t playbackPercentage{0};
-      bool watched{false};
-   };
-
-   struct PlexSearchResults
-   {
-      std::vector<PlexSearchResult> items;
-   };
-}
\ No newline at end of file
+#pragma once
+
+#include "api/api-emby-path-index.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace loomis
+{
+   enum class PlexSearchTypes
+   {
+      movie = 1,
+      show = 2,
+      season = 3,
+      episode = 4,
+      trailer = 5,
+      comic = 6,
+      person = 7,
+      artist = 8,
+      album = 9,
+      track = 10,
+      picture = 11,
+      clip = 12,
+      photo = 13,
+      photoalbum = 14,
+      playlist = 15,
+      playlistFolder = 16,
+      collection = 18,
+      optimizedVersion = 42,
+      userPlaylistItem = 1001,
+   };
+
+   struct PlexCollectionItem
+   {
+      std::string title;
+      std::vector<std::string> paths;
+   };
+
+   struct PlexCollection
+   {
+      std::string name;
+      std::vector<PlexCollectionItem> items;
+   };
+
+   struct PlexSearchResult
+   {
+      std::string ratingKey;
+      std::string path;
+      std::string title;
+      std::string libraryName;
+      int64_t durationMs{0};
+      int32_t playbackPercentage{0};
+      bool watched{false};
+   };
+
+   struct PlexSearchResults
+   {
+      std::vector<PlexSearchResult> items;
+   };
+
+   // Watch state of an item for the user of the api token
+   struct PlexPlayState
+   {
+      int64_t durationMs{0};
+      int32_t playbackPercentage{0};
+      bool watched{false};
+   };
+
+   // Rating key -> play state
+   using PlexPlayStates = std::unordered_map<std::string, PlexPlayState>;
+
+   // Media file path -> rating key. Items with several parts or versions have an entry per file.
+   using PlexPathMap = std::unordered_map<std::string, std::string>;
+
+   // Published path map. Snapshots are never changed once published, updates publish a new one.
+   // Rating keys are numeric ids so the rebuild is held in the same flat path index as the Emby map.
+   struct PlexPathMapSnapshot
+   {
+      // Full rebuild shared between the snapshots patched from it
+      EmbyPathIndex index;
+
+      // Items patched in by quick checks since the last full rebuild
+      PlexPathMap delta;
+
+      // Newest updatedAt epoch seen by the map
+      int64_t lastUpdatedAt{0};
+
+      // Number of items the map has seen. Compared to the server count to detect deletes.
+      uint32_t itemCount{0u};
+
+      [[nodiscard]] std::optional<std::string> Find(const std::string& path) const
+      {
+         if (auto iter = delta.find(path); iter != delta.end()) return iter->second;
+         return index.Find(path);
+      }
+
+      [[nodiscard]] bool Empty() const
+      {
+         return index.Empty() && delta.empty();
+      }
+   };
+}
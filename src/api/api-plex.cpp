@@ -1,338 +1,894 @@
-#include "api-plex.h"
-
-#include "api/api-utils.h"
-#include "logger/logger.h"
-#include "logger/log-utils.h"
-#include "types.h"
-
-#include <cmath>
-#include <format>
-#include <ranges>
-
-namespace loomis
-{
-   namespace
-   {
-      const std::string API_BASE{""};
-      const std::string API_TOKEN_NAME("X-Plex-Token");
-
-      const std::string API_SERVERS{"/servers"};
-      const std::string API_LIBRARIES{"/library/sections/"};
-      const std::string API_LIBRARY_DATA{"/library/metadata/"};
-      const std::string API_SEARCH{"/hubs/search"};
-
-      constexpr std::string_view ELEM_MEDIA_CONTAINER{"MediaContainer"};
-      constexpr std::string_view ELEM_MEDIA{"Media"};
-      constexpr std::string_view ELEM_VIDEO{"Video"};
-
-      constexpr std::string_view ATTR_NAME{"name"};
-      constexpr std::string_view ATTR_KEY{"key"};
-      constexpr std::string_view ATTR_TITLE{"title"};
-      constexpr std::string_view ATTR_FILE{"file"};
-   }
-
-   PlexApi::PlexApi(const ServerConfig& serverConfig)
-      : ApiBase(serverConfig.server_name, serverConfig.url, serverConfig.api_key, "PlexApi", log::ANSI_CODE_PLEX)
-      , client_(GetUrl())
-      , mediaPath_(serverConfig.media_path)
-   {
-      constexpr time_t timeoutSec{5};
-      client_.set_connection_timeout(timeoutSec);
-   }
-
-   std::string_view PlexApi::GetApiBase() const
-   {
-      return API_BASE;
-   }
-
-   std::string_view PlexApi::GetApiTokenName() const
-   {
-      return API_TOKEN_NAME;
-   }
-
-   bool PlexApi::GetValid()
-   {
-      auto res = client_.Get(BuildApiPath(API_SERVERS), headers_);
-      return res.error() == httplib::Error::Success && res.value().status < VALID_HTTP_RESPONSE_MAX;
-   }
-
-   const std::string& PlexApi::GetMediaPath() const
-   {
-      return mediaPath_;
-   }
-
-   std::optional<PlexSearchResults> PlexApi::SearchItem(std::string_view name)
-   {
-      const auto apiUrl = BuildApiParamsPath(API_SEARCH, {
-         {"query", name}
-      });
-      auto res = client_.Get(apiUrl, headers_);
-
-      if (!IsHttpSuccess(__func__, res)) return std::nullopt;
-
-      pugi::xml_document doc;
-      if (doc.load_buffer(res->body.data(), res->body.size()).status != pugi::status_ok)
-      {
-         LogWarning("{} - Malformed XML reply received", std::string(__func__));
-         return std::nullopt;
-      }
-
-      PlexSearchResults returnResults;
-
-      // Faster XPath by providing the direct path
-      pugi::xpath_node_set videos = doc.select_nodes("/MediaContainer/Hub[@type='episode' or @type='movie']/Video");
-
-      for (pugi::xpath_node node : videos)
-      {
-         pugi::xml_node video = node.node();
-         auto& item = returnResults.items.emplace_back();
-
-         item.libraryName = video.attribute("librarySectionTitle").as_string();
-
-         // Get the correct title for both Movies and Episodes
-         if (video.attribute("grandparentTitle").empty())
-         {
-            item.title = video.attribute("title").as_string();
-         }
-         else
-         {
-            item.title = video.attribute("grandparentTitle").as_string();
-            item.title += " - ";
-            item.title += video.attribute("title").as_string();
-         }
-
-         item.ratingKey = video.attribute("ratingKey").as_string();
-         item.durationMs = video.attribute("duration").as_llong();
-         item.watched = !video.attribute("viewCount").empty() && video.attribute("viewOffset").empty();
-
-         if (item.watched)
-         {
-            item.playbackPercentage = 100;
-         }
-         else if (item.durationMs > 0)
-         {
-            auto offset = static_cast<double>(video.attribute("viewOffset").as_llong(0));
-            auto duration = static_cast<double>(item.durationMs);
-            item.playbackPercentage = std::lround((offset / duration) * 100.0);
-         }
-         else
-         {
-            item.playbackPercentage = 0;
-         }
-
-         if (pugi::xml_node part = video.child("Media").child("Part"))
-         {
-            item.path = part.attribute("file").as_string();
-         }
-      }
-
-      return returnResults;
-   }
-
-   std::optional<std::string> PlexApi::GetServerReportedName()
-   {
-      auto res = client_.Get(BuildApiPath(API_SERVERS), headers_);
-
-      if (!IsHttpSuccess(__func__, res)) return std::nullopt;
-
-      pugi::xml_document doc;
-      if (doc.load_buffer(res->body.data(), res->body.size()).status != pugi::status_ok)
-      {
-         LogWarning("{} - Malformed XML reply received", std::string(__func__));
-         return std::nullopt;
-      }
-
-      pugi::xpath_node serverNode = doc.select_node("//Server[@name]");
-
-      if (!serverNode)
-      {
-         LogWarning("{} - No Server element with a name attribute found", __func__);
-         return std::nullopt;
-      }
-
-      return serverNode.node().attribute(ATTR_NAME).as_string();
-   }
-
-   std::optional<std::string> PlexApi::GetLibraryId(std::string_view libraryName)
-   {
-      auto res = client_.Get(BuildApiPath(API_LIBRARIES), headers_);
-
-      if (!IsHttpSuccess(__func__, res)) return std::nullopt;
-
-      pugi::xml_document doc;
-      if (doc.load_buffer(res->body.data(), res->body.size()).status != pugi::status_ok)
-      {
-         return std::nullopt;
-      }
-
-      std::string query = std::format("//{}[@{}='{}']", "Directory", ATTR_TITLE, libraryName);
-      pugi::xpath_node libraryNode = doc.select_node(query.c_str());
-
-      if (!libraryNode)
-      {
-         return std::nullopt;
-      }
-
-      std::string key = libraryNode.node().attribute(ATTR_KEY).as_string();
-
-      return key.empty() ? std::nullopt : std::make_optional(key);
-   }
-
-   std::optional<PlexSearchResults> PlexApi::GetItemInfo(std::string_view name)
-   {
-      return SearchItem(name);
-   }
-
-   std::unordered_map<int32_t, std::string> PlexApi::GetItemsPaths(const std::vector<int32_t>& ids)
-   {
-      auto res = client_.Get(BuildApiPath(API_LIBRARY_DATA + BuildCommaSeparatedList(ids)), headers_);
-      if (!IsHttpSuccess(__func__, res)) return {};
-
-      pugi::xml_document doc;
-      auto parse_result = doc.load_buffer(res->body.data(), res->body.size());
-
-      if (parse_result.status != pugi::status_ok) return {};
-
-      auto container = doc.child(ELEM_MEDIA_CONTAINER);
-      if (!container) return {};
-
-      std::unordered_map<int32_t, std::string> results;
-      results.reserve(ids.size());
-
-      for (auto videoNode : container.children(ELEM_VIDEO.data()))
-      {
-         int32_t ratingKey = videoNode.attribute("ratingKey").as_int();
-         std::string filePath = videoNode.child("Media").child("Part").attribute("file").as_string();
-
-         if (ratingKey != 0 && !filePath.empty())
-         {
-            // Use move to transfer the string into the map efficiently
-            results.emplace(ratingKey, std::move(filePath));
-         }
-      }
-
-      return results;
-   }
-
-   void PlexApi::SetLibraryScan(std::string_view libraryId)
-   {
-      auto apiUrl = BuildApiPath(std::format("{}{}/refresh", API_LIBRARIES, libraryId));
-      auto res = client_.Get(apiUrl, headers_);
-      IsHttpSuccess(__func__, res);
-   }
-
-   pugi::xml_node PlexApi::GetCollectionNode(std::string_view library, std::string_view collection)
-   {
-      auto libraryId = GetLibraryId(library);
-      if (!libraryId) return {}; // Returns a "null" node
-
-      std::string apiUrl = BuildApiPath(std::format("{}{}/all", API_LIBRARIES, *libraryId));
-      apiUrl += std::format("&type={}&title={}",
-                            static_cast<int>(PlexSearchTypes::collection),
-                            collection);
-
-      auto res = client_.Get(apiUrl, headers_);
-
-      if (!IsHttpSuccess(__func__, res)) return {};
-
-      if (collectionDoc_.load_buffer(res->body.data(), res->body.size()).status != pugi::status_ok)
-      {
-         return {};
-      }
-
-      std::string query = std::format("//{}[@{}='{}']", "Directory", ATTR_TITLE, collection);
-      pugi::xpath_node match = collectionDoc_.select_node(query.c_str());
-
-      return match.node();
-   }
-
-   bool PlexApi::GetCollectionValid(std::string_view library, std::string_view collection)
-   {
-      return !GetCollectionNode(library, collection).empty();
-   }
-
-   std::optional<PlexCollection> PlexApi::GetCollection(std::string_view library, std::string_view collectionName)
-   {
-      auto node = GetCollectionNode(library, collectionName);
-      if (node.empty()) return std::nullopt;
-
-      auto key = node.attribute(ATTR_KEY).as_string();
-      if (std::string_view(key).empty()) return std::nullopt;
-
-      auto res = client_.Get(BuildApiPath(key), headers_);
-      if (!IsHttpSuccess(__func__, res)) return std::nullopt;
-
-      pugi::xml_document doc;
-      if (doc.load_buffer(res->body.data(), res->body.size()).status != pugi::status_ok) return std::nullopt;
-
-      auto container = doc.child(ELEM_MEDIA_CONTAINER);
-      if (!container) return std::nullopt;
-
-      PlexCollection collection;
-      collection.name = collectionName;
-
-      for (auto itemNode : container.children())
-      {
-         // Skip items without media info
-         auto mediaNode = itemNode.child(ELEM_MEDIA);
-         if (!mediaNode) continue;
-
-         auto& item = collection.items.emplace_back();
-         item.title = itemNode.attribute(ATTR_TITLE).as_string();
-
-         // 4. Extract paths from Media -> Part hierarchy
-         for (auto partNode : itemNode.select_nodes("Media/Part"))
-         {
-            if (auto path = partNode.node().attribute("file").as_string(); *path)
-            {
-               item.paths.emplace_back(path);
-            }
-         }
-      }
-
-      return collection;
-   }
-
-   bool PlexApi::SetPlayed(std::string_view ratingKey, int64_t locationMs)
-   {
-      const auto apiUrl = BuildApiParamsPath("/:/progress", {
-         {"identifier", "com.plexapp.plugins.library"},
-         {"key", ratingKey},
-         {"time", std::to_string(locationMs)},
-         {"state", "stopped"} // 'stopped' commits the time to the database
-      });
-
-      auto res = client_.Get(apiUrl, headers_);
-      if (!IsHttpSuccess(__func__, res))
-      {
-         auto d = std::chrono::milliseconds(locationMs);
-         std::chrono::hh_mm_ss timeSplit{std::chrono::duration_cast<std::chrono::seconds>(d)};
-         LogError("{} - Failed to mark {} to play location {}:{}:{}",
-                  __func__,
-                  log::GetTag("ratingKey", ratingKey),
-                  timeSplit.hours().count(),
-                  timeSplit.minutes().count(),
-                  timeSplit.seconds().count());
-         return false;
-      }
-
-      return true;
-   }
-
-   bool PlexApi::SetWatched(std::string_view ratingKey)
-   {
-      const auto apiUrl = BuildApiParamsPath("/:/scrobble", {
-         {"identifier", "com.plexapp.plugins.library"},
-         {"key", ratingKey}
-      });
-
-      auto res = client_.Get(apiUrl, headers_);
-      if (!IsHttpSuccess(__func__, res))
-      {
-         LogError("{} - Failed to mark {} as watched", __func__, log::GetTag("ratingKey", ratingKey));
-         return false;
-      }
-
-      return true;
-   }
-}
\ No newline at end of file
+#include "api-plex.h"
+
+#include "api/api-emby-path-map-file.h"
+#include "api/api-plex-json-types.h"
+#include "api/api-utils.h"
+#include "logger/logger.h"
+#include "logger/log-utils.h"
+#include "types.h"
+
+#include <glaze/glaze.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <deque>
+#include <format>
+#include <ranges>
+
+namespace loomis
+{
+   namespace
+   {
+      const std::string API_BASE{""};
+      const std::string API_TOKEN_NAME("X-Plex-Token");
+
+      const std::string API_SERVERS{"/servers"};
+      const std::string API_LIBRARIES{"/library/sections/"};
+      const std::string API_LIBRARY_DATA{"/library/metadata/"};
+      const std::string API_SEARCH{"/hubs/search"};
+
+      constexpr std::string_view ELEM_MEDIA_CONTAINER{"MediaContainer"};
+      constexpr std::string_view ELEM_MEDIA{"Media"};
+      constexpr std::string_view ELEM_PART{"Part"};
+      constexpr std::string_view ELEM_DIRECTORY{"Directory"};
+      constexpr std::string_view ELEM_HUB{"Hub"};
+      constexpr std::string_view ELEM_SERVER{"Server"};
+
+      constexpr std::string_view ATTR_NAME{"name"};
+      constexpr std::string_view ATTR_KEY{"key"};
+      constexpr std::string_view ATTR_RATING_KEY{"ratingKey"};
+      constexpr std::string_view ATTR_TYPE{"type"};
+      constexpr std::string_view ATTR_TITLE{"title"};
+      constexpr std::string_view ATTR_FILE{"file"};
+      constexpr std::string_view ATTR_VIEW_OFFSET{"viewOffset"};
+
+      constexpr int HTTP_NOT_FOUND{404};
+
+      // Plex changes state through GET requests on these paths so they must not be sent twice
+      constexpr std::string_view PATH_STATE_CHANGE{"/:/"};
+      constexpr std::string_view PATH_REFRESH{"/refresh"};
+
+      // Path map rebuilds are paged to bound memory on large libraries
+      constexpr uint32_t PATH_MAP_PAGE_SIZE{2000u};
+      constexpr size_t PATH_MAP_PAGES_IN_FLIGHT{4u};
+
+      constexpr std::string_view CONTAINER_START{"X-Plex-Container-Start"};
+      constexpr std::string_view CONTAINER_SIZE{"X-Plex-Container-Size"};
+
+      // Response shaping profiles. Each asks only for what its callers read.
+      // Item lists: no guids, no filter and sort meta and no summaries
+      const ApiParams PROFILE_ITEM_LIST{
+         {"includeGuids", "0"},
+         {"includeMeta", "0"},
+         {"excludeFields", "summary"}
+      };
+
+      // Item counts: only the container totals
+      const ApiParams PROFILE_ITEM_COUNT{
+         {"includeGuids", "0"},
+         {"includeMeta", "0"}
+      };
+
+      // Emitted as updatedAt>=<epoch> which Plex reads as a greater or equal filter
+      constexpr std::string_view UPDATED_AT_FILTER{"updatedAt>"};
+
+      std::string GetCollectionCacheKey(std::string_view library, std::string_view collection)
+      {
+         return std::format("{}/{}", library, collection);
+      }
+
+      PlexPlayState ToPlayState(const JsonPlexMetadata& video)
+      {
+         PlexPlayState playState{.durationMs = video.duration, .playbackPercentage = 0, .watched = video.viewCount > 0 && !video.viewOffset};
+         if (playState.watched)
+         {
+            playState.playbackPercentage = 100;
+         }
+         else if (playState.durationMs > 0)
+         {
+            auto offset = static_cast<double>(video.viewOffset.value_or(0));
+            auto duration = static_cast<double>(playState.durationMs);
+            playState.playbackPercentage = static_cast<int32_t>(std::lround((offset / duration) * 100.0));
+         }
+         return playState;
+      }
+
+      // Plex answers in XML when the Accept header is not honored
+      bool GetXmlBody(std::string_view body)
+      {
+         auto start = body.find_first_not_of(" \t\r\n");
+         return start != std::string_view::npos && body[start] == '<';
+      }
+
+      JsonPlexMetadata ReadXmlMetadata(pugi::xml_node node)
+      {
+         JsonPlexMetadata metadata{
+            .ratingKey = node.attribute(ATTR_RATING_KEY.data()).as_string(),
+            .key = node.attribute(ATTR_KEY.data()).as_string(),
+            .type = node.attribute(ATTR_TYPE.data()).as_string(),
+            .title = node.attribute(ATTR_TITLE.data()).as_string(),
+            .grandparentTitle = node.attribute("grandparentTitle").as_string(),
+            .librarySectionTitle = node.attribute("librarySectionTitle").as_string(),
+            .duration = node.attribute("duration").as_llong(),
+            .addedAt = node.attribute("addedAt").as_llong(),
+            .updatedAt = node.attribute("updatedAt").as_llong(),
+            .viewCount = node.attribute("viewCount").as_int(),
+            .viewOffset = std::nullopt,
+            .Media = {}
+         };
+
+         if (auto viewOffset = node.attribute(ATTR_VIEW_OFFSET.data()); !viewOffset.empty())
+         {
+            metadata.viewOffset = viewOffset.as_llong();
+         }
+
+         for (auto mediaNode : node.children(ELEM_MEDIA.data()))
+         {
+            auto& media = metadata.Media.emplace_back();
+            for (auto partNode : mediaNode.children(ELEM_PART.data()))
+            {
+               media.Part.emplace_back(JsonPlexPart{partNode.attribute(ATTR_FILE.data()).as_string()});
+            }
+         }
+         return metadata;
+      }
+
+      // Fills the same structs the JSON reply is read into. Any element with a rating key is an item,
+      // which is what the JSON reply lists under Metadata.
+      JsonPlexMediaContainer ReadXmlContainer(pugi::xml_node containerNode)
+      {
+         JsonPlexMediaContainer container;
+         if (auto totalSize = containerNode.attribute("totalSize"); !totalSize.empty())
+         {
+            container.totalSize = totalSize.as_uint();
+         }
+
+         for (auto node : containerNode.children())
+         {
+            std::string_view name = node.name();
+            if (name == ELEM_HUB)
+            {
+               auto& hub = container.Hub.emplace_back();
+               hub.type = node.attribute(ATTR_TYPE.data()).as_string();
+               for (auto hubNode : node.children())
+               {
+                  if (!hubNode.attribute(ATTR_RATING_KEY.data()).empty()) hub.Metadata.emplace_back(ReadXmlMetadata(hubNode));
+               }
+            }
+            else if (name == ELEM_SERVER)
+            {
+               container.Server.emplace_back(JsonPlexServer{node.attribute(ATTR_NAME.data()).as_string()});
+            }
+            else if (!node.attribute(ATTR_RATING_KEY.data()).empty())
+            {
+               container.Metadata.emplace_back(ReadXmlMetadata(node));
+            }
+            else if (name == ELEM_DIRECTORY)
+            {
+               container.Directory.emplace_back(JsonPlexDirectory{
+                  .key = node.attribute(ATTR_KEY.data()).as_string(),
+                  .title = node.attribute(ATTR_TITLE.data()).as_string(),
+                  .type = node.attribute(ATTR_TYPE.data()).as_string()
+               });
+            }
+         }
+         return container;
+      }
+
+      std::string GetFirstPartFile(const JsonPlexMetadata& metadata)
+      {
+         for (const auto& media : metadata.Media)
+         {
+            for (const auto& part : media.Part)
+            {
+               if (!part.file.empty()) return part.file;
+            }
+         }
+         return {};
+      }
+   }
+
+   PlexApi::PlexApi(const ServerConfig& serverConfig, const std::filesystem::path& cachePath)
+      : ApiBase(serverConfig, serverConfig.url, serverConfig.api_key, "PlexApi", log::ANSI_CODE_PLEX)
+      , mediaPath_(serverConfig.media_path)
+   {
+      // JSON replies are smaller and decode straight into typed structs
+      headers_.insert({"Accept", "application/json"});
+
+      if (!cachePath.empty()) pathMapFile_ = GetServerCacheFileName(cachePath, "plex-path-map-", GetName(), ".bin");
+
+      // Start with the saved map if there is one and bring it up to date, or build it, without blocking startup
+      if (!LoadPathMapFile()) LogTrace("No saved path map. Building it in the background.");
+      pathMapRevalidateThread_ = std::jthread([this]() { RunPathMapQuickCheck(); });
+   }
+
+   std::optional<std::vector<Task>> PlexApi::GetTaskList()
+   {
+      auto tasks = ApiBase::GetTaskList().value_or(std::vector<Task>{});
+
+      auto& quickCheck = tasks.emplace_back();
+      quickCheck.name = std::format("PlexApi({}) - Path Map Quick Check", GetName());
+      quickCheck.cronExpression = "45 */5 * * * *";
+      quickCheck.func = [this]() {this->RunPathMapQuickCheck(); };
+
+      auto& fullUpdate = tasks.emplace_back();
+      fullUpdate.name = std::format("PlexApi({}) - Path Map Full Update", GetName());
+      fullUpdate.cronExpression = "0 40 3 * * *";
+      fullUpdate.func = [this]() {this->RunPathMapFullUpdate(); };
+
+      auto& lookupRefresh = tasks.emplace_back();
+      lookupRefresh.name = std::format("PlexApi({}) - Lookup Cache Refresh", GetName());
+      lookupRefresh.cronExpression = "0 15 * * * *";
+      lookupRefresh.func = [this]() {this->RunLookupCacheRefresh(); };
+
+      return tasks;
+   }
+
+   std::string_view PlexApi::GetApiBase() const
+   {
+      return API_BASE;
+   }
+
+   std::string_view PlexApi::GetApiTokenName() const
+   {
+      return API_TOKEN_NAME;
+   }
+
+   bool PlexApi::GetRequestIdempotent(std::string_view method, std::string_view path) const
+   {
+      auto route = path.substr(0, path.find('?'));
+      if (route.find(PATH_STATE_CHANGE) != std::string_view::npos || route.find(PATH_REFRESH) != std::string_view::npos) return false;
+      return ApiBase::GetRequestIdempotent(method, path);
+   }
+
+   bool PlexApi::ProbeServer()
+   {
+      auto res = Get(BuildApiPath(API_SERVERS), headers_);
+      return res.error() == httplib::Error::Success && res.value().status < VALID_HTTP_RESPONSE_MAX;
+   }
+
+   const std::string& PlexApi::GetMediaPath() const
+   {
+      return mediaPath_;
+   }
+
+   std::optional<JsonPlexMediaContainer> PlexApi::ParseMediaContainer(std::string_view name, const std::string& body)
+   {
+      if (GetXmlBody(body))
+      {
+         pugi::xml_document doc;
+         if (doc.load_buffer(body.data(), body.size()).status != pugi::status_ok)
+         {
+            LogWarning("{} - Malformed XML reply received", name);
+            return std::nullopt;
+         }
+         return ReadXmlContainer(doc.child(ELEM_MEDIA_CONTAINER.data()));
+      }
+
+      JsonPlexResponse response;
+      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (response, body))
+      {
+         LogWarning("{} - JSON Parse Error: {}",
+                    name, glz::format_error(ec, body));
+         return std::nullopt;
+      }
+      return std::move(response.MediaContainer);
+   }
+
+   std::optional<PlexSearchResults> PlexApi::SearchItem(std::string_view name)
+   {
+      const auto apiUrl = BuildApiParamsPath(API_SEARCH, {
+         {"query", name}
+      }, PROFILE_ITEM_LIST);
+      auto res = Get(apiUrl, headers_);
+
+      if (!IsHttpSuccess(__func__, res)) return std::nullopt;
+
+      auto container = ParseMediaContainer(__func__, res->body);
+      if (!container) return std::nullopt;
+
+      PlexSearchResults returnResults;
+      for (auto& hub : container->Hub)
+      {
+         if (hub.type != "episode" && hub.type != "movie") continue;
+
+         for (auto& video : hub.Metadata)
+         {
+            auto& item = returnResults.items.emplace_back();
+
+            item.libraryName = std::move(video.librarySectionTitle);
+
+            // Get the correct title for both Movies and Episodes
+            if (video.grandparentTitle.empty())
+            {
+               item.title = std::move(video.title);
+            }
+            else
+            {
+               item.title = std::format("{} - {}", video.grandparentTitle, video.title);
+            }
+
+            item.ratingKey = std::move(video.ratingKey);
+            item.durationMs = video.duration;
+            auto playState = ToPlayState(video);
+            item.watched = playState.watched;
+            item.playbackPercentage = playState.playbackPercentage;
+
+            item.path = GetFirstPartFile(video);
+         }
+      }
+
+      return returnResults;
+   }
+
+   std::optional<std::string> PlexApi::GetServerReportedName()
+   {
+      auto res = Get(BuildApiPath(API_SERVERS), headers_);
+
+      if (!IsHttpSuccess(__func__, res)) return std::nullopt;
+
+      auto container = ParseMediaContainer(__func__, res->body);
+      if (!container) return std::nullopt;
+
+      auto server = std::ranges::find_if(container->Server, [](const auto& server) { return !server.name.empty(); });
+      if (server == container->Server.end())
+      {
+         LogWarning("{} - No Server element with a name attribute found", __func__);
+         return std::nullopt;
+      }
+
+      return std::move(server->name);
+   }
+
+   std::optional<std::string> PlexApi::GetLibraryId(std::string_view libraryName)
+   {
+      return libraryIds_.Find(libraryName);
+   }
+
+   std::optional<ApiLookupCache<std::string>::Map> PlexApi::LoadLibraryIds()
+   {
+      auto body = GetCached(__func__, BuildApiPath(API_LIBRARIES), headers_, GetCacheTtl());
+      if (!body) return std::nullopt;
+
+      auto container = ParseMediaContainer(__func__, *body);
+      if (!container) return std::nullopt;
+
+      ApiLookupCache<std::string>::Map libraryIds;
+      for (auto& library : container->Directory)
+      {
+         if (!library.title.empty() && !library.key.empty()) libraryIds.emplace(std::move(library.title), std::move(library.key));
+      }
+      return libraryIds;
+   }
+
+   void PlexApi::RunLookupCacheRefresh()
+   {
+      libraryIds_.Refresh();
+
+      // Collection keys are looked up again on next use
+      std::lock_guard lock(collectionKeysLock_);
+      collectionKeys_.clear();
+   }
+
+   std::optional<PlexSearchResults> PlexApi::GetItemInfo(std::string_view name)
+   {
+      return SearchItem(name);
+   }
+
+   std::optional<std::unordered_map<int32_t, std::string>> PlexApi::GetItemsPaths(const std::vector<int32_t>& ids)
+   {
+      auto res = Get(BuildApiParamsPath(API_LIBRARY_DATA + BuildCommaSeparatedList(ids), {}, PROFILE_ITEM_LIST), headers_);
+      if (!IsHttpSuccess(__func__, res)) return std::nullopt;
+
+      auto container = ParseMediaContainer(__func__, res->body);
+      if (!container) return std::nullopt;
+
+      std::unordered_map<int32_t, std::string> results;
+      results.reserve(ids.size());
+
+      for (const auto& video : container->Metadata)
+      {
+         int32_t ratingKey{0};
+         std::from_chars(video.ratingKey.data(), video.ratingKey.data() + video.ratingKey.size(), ratingKey);
+         std::string filePath = GetFirstPartFile(video);
+
+         if (ratingKey != 0 && !filePath.empty())
+         {
+            // Use move to transfer the string into the map efficiently
+            results.emplace(ratingKey, std::move(filePath));
+         }
+      }
+
+      return results;
+   }
+
+   std::optional<PlexPlayStates> PlexApi::GetPlayStates(const std::vector<std::string>& ratingKeys)
+   {
+      if (ratingKeys.empty()) return PlexPlayStates{};
+
+      auto res = Get(BuildApiParamsPath(API_LIBRARY_DATA + BuildCommaSeparatedList(ratingKeys), {}, PROFILE_ITEM_LIST), headers_);
+      if (!IsHttpSuccess(__func__, res)) return std::nullopt;
+
+      auto container = ParseMediaContainer(__func__, res->body);
+      if (!container) return std::nullopt;
+
+      PlexPlayStates playStates;
+      playStates.reserve(container->Metadata.size());
+      for (const auto& video : container->Metadata)
+      {
+         if (!video.ratingKey.empty()) playStates.emplace(video.ratingKey, ToPlayState(video));
+      }
+      return playStates;
+   }
+
+   std::future<std::optional<PlexSearchResults>> PlexApi::GetItemInfoAsync(std::string_view name)
+   {
+      return RunAsync([this, name = std::string(name)]() {
+         return GetItemInfo(name);
+      });
+   }
+
+   std::future<std::optional<std::unordered_map<int32_t, std::string>>> PlexApi::GetItemsPathsAsync(std::vector<int32_t> ids)
+   {
+      return RunAsync([this, ids = std::move(ids)]() {
+         return GetItemsPaths(ids);
+      });
+   }
+
+   void PlexApi::SetLibraryScan(std::string_view libraryId)
+   {
+      auto apiUrl = BuildApiPath(std::format("{}{}/refresh", API_LIBRARIES, libraryId));
+      auto res = Get(apiUrl, headers_);
+      IsHttpSuccess(__func__, res);
+   }
+
+   std::optional<std::string> PlexApi::GetCollectionKey(std::string_view library, std::string_view collection)
+   {
+      auto cacheKey = GetCollectionCacheKey(library, collection);
+      {
+         std::lock_guard lock(collectionKeysLock_);
+         if (auto iter = collectionKeys_.find(cacheKey); iter != collectionKeys_.end()) return iter->second;
+      }
+
+      auto libraryId = GetLibraryId(library);
+      if (!libraryId) return std::nullopt;
+
+      std::string apiUrl = BuildApiPath(std::format("{}{}/all", API_LIBRARIES, *libraryId));
+      apiUrl += std::format("&type={}&title={}",
+                            static_cast<int>(PlexSearchTypes::collection),
+                            collection);
+
+      auto res = Get(apiUrl, headers_);
+
+      if (!IsHttpSuccess(__func__, res)) return std::nullopt;
+
+      auto container = ParseMediaContainer(__func__, res->body);
+      if (!container) return std::nullopt;
+
+      auto match = std::ranges::find_if(container->Metadata, [&](const auto& item) {
+         return item.title == collection && !item.key.empty();
+      });
+      if (match == container->Metadata.end()) return std::nullopt;
+
+      std::string key = std::move(match->key);
+
+      std::lock_guard lock(collectionKeysLock_);
+      collectionKeys_.insert_or_assign(std::move(cacheKey), key);
+      return key;
+   }
+
+   void PlexApi::RemoveCollectionKey(std::string_view library, std::string_view collection)
+   {
+      std::lock_guard lock(collectionKeysLock_);
+      collectionKeys_.erase(GetCollectionCacheKey(library, collection));
+   }
+
+   bool PlexApi::GetCollectionValid(std::string_view library, std::string_view collection)
+   {
+      return GetCollectionKey(library, collection).has_value();
+   }
+
+   std::optional<PlexCollection> PlexApi::GetCollection(std::string_view library, std::string_view collectionName)
+   {
+      auto key = GetCollectionKey(library, collectionName);
+      if (!key) return std::nullopt;
+
+      auto res = Get(BuildApiParamsPath(*key, {}, PROFILE_ITEM_LIST), headers_);
+      if (res && res->status == HTTP_NOT_FOUND)
+      {
+         // The collection was deleted or recreated with a new key since the key was cached
+         RemoveCollectionKey(library, collectionName);
+         key = GetCollectionKey(library, collectionName);
+         if (!key) return std::nullopt;
+
+         res = Get(BuildApiParamsPath(*key, {}, PROFILE_ITEM_LIST), headers_);
+      }
+
+      if (!IsHttpSuccess(__func__, res)) return std::nullopt;
+
+      auto container = ParseMediaContainer(__func__, res->body);
+      if (!container) return std::nullopt;
+
+      PlexCollection collection;
+      collection.name = collectionName;
+
+      for (auto& metadata : container->Metadata)
+      {
+         // Skip items without media info
+         if (metadata.Media.empty()) continue;
+
+         auto& item = collection.items.emplace_back();
+         item.title = std::move(metadata.title);
+
+         for (auto& media : metadata.Media)
+         {
+            for (auto& part : media.Part)
+            {
+               if (!part.file.empty()) item.paths.emplace_back(std::move(part.file));
+            }
+         }
+      }
+
+      return collection;
+   }
+
+   bool PlexApi::SetPlayed(std::string_view ratingKey, int64_t locationMs)
+   {
+      const auto apiUrl = BuildApiParamsPath("/:/progress", {
+         {"identifier", "com.plexapp.plugins.library"},
+         {"key", ratingKey},
+         {"time", std::to_string(locationMs)},
+         {"state", "stopped"} // 'stopped' commits the time to the database
+      });
+
+      auto res = Get(apiUrl, headers_);
+      if (!IsHttpSuccess(__func__, res))
+      {
+         auto d = std::chrono::milliseconds(locationMs);
+         std::chrono::hh_mm_ss timeSplit{std::chrono::duration_cast<std::chrono::seconds>(d)};
+         LogError("{} - Failed to mark {} to play location {}:{}:{}",
+                  __func__,
+                  log::GetTag("ratingKey", ratingKey),
+                  timeSplit.hours().count(),
+                  timeSplit.minutes().count(),
+                  timeSplit.seconds().count());
+         return false;
+      }
+
+      return true;
+   }
+
+   bool PlexApi::SetWatched(std::string_view ratingKey)
+   {
+      const auto apiUrl = BuildApiParamsPath("/:/scrobble", {
+         {"identifier", "com.plexapp.plugins.library"},
+         {"key", ratingKey}
+      });
+
+      auto res = Get(apiUrl, headers_);
+      if (!IsHttpSuccess(__func__, res))
+      {
+         LogError("{} - Failed to mark {} as watched", __func__, log::GetTag("ratingKey", ratingKey));
+         return false;
+      }
+
+      return true;
+   }
+
+   std::future<bool> PlexApi::SetPlayedAsync(std::string_view ratingKey, int64_t locationMs)
+   {
+      return RunAsync([this, ratingKey = std::string(ratingKey), locationMs]() {
+         return SetPlayed(ratingKey, locationMs);
+      });
+   }
+
+   std::future<bool> PlexApi::SetWatchedAsync(std::string_view ratingKey)
+   {
+      return RunAsync([this, ratingKey = std::string(ratingKey)]() {
+         return SetWatched(ratingKey);
+      });
+   }
+
+   std::optional<std::vector<PlexApi::PathMapSection>> PlexApi::GetPathMapSections()
+   {
+      // Shares the cached section list with the library id lookups
+      auto body = GetCached(__func__, BuildApiPath(API_LIBRARIES), headers_, GetCacheTtl());
+      if (!body) return std::nullopt;
+
+      auto container = ParseMediaContainer(__func__, *body);
+      if (!container) return std::nullopt;
+
+      std::vector<PathMapSection> sections;
+      for (auto& library : container->Directory)
+      {
+         if (library.key.empty()) continue;
+
+         // Only movie and show sections hold items that are synced
+         if (library.type == "movie")
+         {
+            sections.emplace_back(PathMapSection{std::move(library.key), PlexSearchTypes::movie});
+         }
+         else if (library.type == "show")
+         {
+            sections.emplace_back(PathMapSection{std::move(library.key), PlexSearchTypes::episode});
+         }
+      }
+      return sections;
+   }
+
+   std::string PlexApi::BuildPathMapQuery(const PathMapSection& section, const ApiParams& extraParams, const ApiParams& profile) const
+   {
+      auto typeStr = std::to_string(static_cast<int>(section.itemType));
+      ApiParams params = {
+         {"type", typeStr}
+      };
+      params.reserve(params.size() + extraParams.size());
+      params.insert(params.end(), extraParams.begin(), extraParams.end());
+      return BuildApiParamsPath(std::format("{}{}/all", API_LIBRARIES, section.key), params, profile);
+   }
+
+   std::optional<uint32_t> PlexApi::GetPathMapItemCount(const PathMapSection& section)
+   {
+      auto res = Get(BuildPathMapQuery(section, {
+         {CONTAINER_START, "0"},
+         {CONTAINER_SIZE, "0"}
+      }, PROFILE_ITEM_COUNT), headers_);
+      if (!IsHttpSuccess(__func__, res)) return std::nullopt;
+
+      auto container = ParseMediaContainer(__func__, res->body);
+      if (!container) return std::nullopt;
+      return container->totalSize;
+   }
+
+   std::future<httplib::Result> PlexApi::GetPathMapPageAsync(const PathMapSection& section, uint32_t start)
+   {
+      auto startStr = std::to_string(start);
+      auto sizeStr = std::to_string(PATH_MAP_PAGE_SIZE);
+      // Pages need a unique order or items can move between pages while the rebuild reads them.
+      // Ids grow as items are added so new items land on the last pages.
+      return GetAsync(BuildPathMapQuery(section, {
+         {"sort", "id"},
+         {CONTAINER_START, startStr},
+         {CONTAINER_SIZE, sizeStr}
+      }, PROFILE_ITEM_LIST), headers_);
+   }
+
+   std::optional<std::vector<PlexApi::PathMapVideo>> PlexApi::ParsePathMapVideos(const std::string& body)
+   {
+      auto container = ParseMediaContainer(__func__, body);
+      if (!container) return std::nullopt;
+
+      std::vector<PathMapVideo> videos;
+      videos.reserve(container->Metadata.size());
+      for (auto& metadata : container->Metadata)
+      {
+         if (metadata.ratingKey.empty()) continue;
+
+         PathMapVideo video;
+         video.ratingKey = std::move(metadata.ratingKey);
+         video.addedAt = metadata.addedAt;
+         video.updatedAt = metadata.updatedAt;
+
+         for (auto& media : metadata.Media)
+         {
+            for (auto& part : media.Part)
+            {
+               if (!part.file.empty()) video.paths.emplace_back(std::move(part.file));
+            }
+         }
+
+         if (!video.paths.empty()) videos.emplace_back(std::move(video));
+      }
+      return videos;
+   }
+
+   void PlexApi::BuildPathMap()
+   {
+      auto sections = GetPathMapSections();
+      if (!sections) return;
+
+      // Path, rating key pairs held until the index is built
+      std::vector<std::pair<std::string, std::string>> items;
+      int64_t lastUpdatedAt{0};
+      uint32_t itemCount{0u};
+      for (const auto& section : *sections)
+      {
+         // A partial map would cause false misses so only publish a complete rebuild
+         auto sectionCount = GetPathMapItemCount(section);
+         if (!sectionCount) return;
+
+         itemCount += *sectionCount;
+         items.reserve(itemCount);
+
+         // Page through the section with a few pages in flight. Each page is inserted and
+         // released as it arrives so only a window of the section is held in memory.
+         std::deque<std::future<httplib::Result>> pages;
+         uint32_t nextStart{0u};
+         auto queueNextPage = [&]() {
+            pages.emplace_back(GetPathMapPageAsync(section, nextStart));
+            nextStart += PATH_MAP_PAGE_SIZE;
+         };
+
+         while (nextStart < *sectionCount && pages.size() < PATH_MAP_PAGES_IN_FLIGHT) queueNextPage();
+
+         while (!pages.empty())
+         {
+            auto res = pages.front().get();
+            pages.pop_front();
+
+            if (!IsHttpSuccess(__func__, res)) return;
+
+            auto videos = ParsePathMapVideos(res->body);
+            if (!videos) return;
+
+            if (nextStart < *sectionCount) queueNextPage();
+
+            for (auto& video : *videos)
+            {
+               lastUpdatedAt = std::max(lastUpdatedAt, video.updatedAt);
+               for (auto& path : video.paths)
+               {
+                  items.emplace_back(std::move(path), video.ratingKey);
+               }
+            }
+         }
+      }
+
+      if (items.empty()) return;
+
+      EmbyPathIndex::Entries entries;
+      entries.reserve(items.size());
+      for (const auto& [path, ratingKey] : items) entries.emplace_back(path, ratingKey);
+      auto pathIndex = EmbyPathIndex::Build(std::move(entries));
+
+      LogTrace("Path map rebuilt {} {} {}",
+               log::GetTag("paths", pathIndex.Size()),
+               log::GetTag("items", itemCount),
+               log::GetTag("index_bytes", pathIndex.GetMemoryUsage()));
+
+      if (!pathMapFile_.empty())
+      {
+         EmbyPathMapFile pathMapFile{
+            .index = pathIndex,
+            .lastSyncTimestamp = std::to_string(lastUpdatedAt),
+            .itemCount = itemCount
+         };
+         if (!SaveEmbyPathMapFile(pathMapFile_, pathMapFile))
+         {
+            LogWarning("{} - Failed to save path map {}", __func__, log::GetTag("file", pathMapFile_.string()));
+         }
+      }
+
+      pathMap_.store(std::make_shared<const PlexPathMapSnapshot>(PlexPathMapSnapshot{
+         .index = std::move(pathIndex),
+         .delta = {},
+         .lastUpdatedAt = lastUpdatedAt,
+         .itemCount = itemCount
+      }));
+   }
+
+   bool PlexApi::LoadPathMapFile()
+   {
+      if (pathMapFile_.empty()) return false;
+
+      auto pathMapFile = LoadEmbyPathMapFile(pathMapFile_);
+      if (!pathMapFile || pathMapFile->index.Empty()) return false;
+
+      // The timestamp is the newest updatedAt epoch
+      const auto& timestamp = pathMapFile->lastSyncTimestamp;
+      int64_t lastUpdatedAt{0};
+      if (std::from_chars(timestamp.data(), timestamp.data() + timestamp.size(), lastUpdatedAt).ec != std::errc{}) return false;
+
+      LogTrace("Path map loaded {} {}",
+               log::GetTag("paths", pathMapFile->index.Size()),
+               log::GetTag("updated_at", lastUpdatedAt));
+
+      pathMap_.store(std::make_shared<const PlexPathMapSnapshot>(PlexPathMapSnapshot{
+         .index = std::move(pathMapFile->index),
+         .delta = {},
+         .lastUpdatedAt = lastUpdatedAt,
+         .itemCount = pathMapFile->itemCount
+      }));
+      return true;
+   }
+
+   bool PlexApi::ApplyPathMapDelta()
+   {
+      auto current = pathMap_.load();
+
+      // Without a timestamp the delta would be the whole library
+      if (current->lastUpdatedAt == 0) return false;
+
+      // Server is not responding correctly. Keep the current map and check again next time.
+      auto sections = GetPathMapSections();
+      if (!sections) return true;
+
+      auto updatedAtStr = std::to_string(current->lastUpdatedAt);
+
+      // Writers are serialized so the current snapshot can not change while the update is built
+      auto updated = std::make_shared<PlexPathMapSnapshot>(*current);
+
+      uint32_t serverItemCount{0u};
+      size_t changedItems{0u};
+      uint32_t addedItems{0u};
+      uint32_t movedItems{0u};
+      for (const auto& section : *sections)
+      {
+         auto itemCountFuture = RunAsync([this, section]() { return GetPathMapItemCount(section); });
+         auto res = Get(BuildPathMapQuery(section, {
+            {UPDATED_AT_FILTER, updatedAtStr}
+         }, PROFILE_ITEM_LIST), headers_);
+         auto itemCount = itemCountFuture.get();
+
+         if (!IsHttpSuccess(__func__, res) || !itemCount) return true;
+         serverItemCount += *itemCount;
+
+         auto videos = ParsePathMapVideos(res->body);
+         if (!videos) return true;
+
+         for (auto& video : *videos)
+         {
+            // The filter is inclusive so items at the last timestamp are sent again
+            bool mapped = std::ranges::all_of(video.paths, [&](const auto& path) { return updated->Find(path) == video.ratingKey; });
+            if (mapped && video.updatedAt <= current->lastUpdatedAt) continue;
+
+            // Items added at or after the timestamp are new unless the map already has them. An older item
+            // with a file the map does not know was moved or got a new file and its old path may still be in the map.
+            bool added = video.addedAt >= current->lastUpdatedAt;
+            if (added && !mapped) ++addedItems;
+            else if (!added && std::ranges::any_of(video.paths, [&](const auto& path) { return !updated->Find(path); })) ++movedItems;
+
+            // The rebuild is shared with older snapshots so patched items are held in the delta map
+            for (auto& path : video.paths)
+            {
+               updated->delta.insert_or_assign(std::move(path), video.ratingKey);
+            }
+
+            updated->lastUpdatedAt = std::max(updated->lastUpdatedAt, video.updatedAt);
+            ++changedItems;
+         }
+      }
+
+      // Nothing changed so keep the current snapshot
+      if (changedItems == 0u) return current->itemCount == serverItemCount;
+
+      updated->itemCount += addedItems;
+      pathMap_.store(updated);
+
+      LogTrace("Path map patched {} {} {}",
+               log::GetTag("changed", changedItems),
+               log::GetTag("added", addedItems),
+               log::GetTag("moved", movedItems));
+
+      // Deleted items never show up in the delta. Every item added since the last sync is counted
+      // so the server count only matches the map when nothing was deleted. Moved items leave their old path
+      // behind so they need a rebuild as well.
+      return movedItems == 0u && updated->itemCount == serverItemCount;
+   }
+
+   void PlexApi::RunPathMapQuickCheck()
+   {
+      std::lock_guard updateLock(pathMapUpdateLock_);
+      if (GetPathMapEmpty() || !ApplyPathMapDelta())
+      {
+         BuildPathMap();
+      }
+   }
+
+   void PlexApi::RunPathMapFullUpdate()
+   {
+      std::lock_guard updateLock(pathMapUpdateLock_);
+      BuildPathMap();
+   }
+
+   bool PlexApi::GetPathMapEmpty() const
+   {
+      return pathMap_.load()->Empty();
+   }
+
+   std::optional<std::string> PlexApi::GetRatingKeyFromPathMap(const std::string& path) const
+   {
+      return pathMap_.load()->Find(path);
+   }
+}
@@ -1,59 +1,146 @@
-#pragma once
-
-#include "api/api-base.h"
-#include "api/api-plex-types.h"
-#include "config-reader/config-reader-types.h"
-
-#include <httplib.h>
-#include <pugixml.hpp>
-
-#include <cstdint>
-#include <list>
-#include <optional>
-#include <string>
-#include <unordered_map>
-
-namespace loomis
-{
-   class PlexApi : public ApiBase
-   {
-   public:
-      PlexApi(const ServerConfig& serverConfig);
-      virtual ~PlexApi() = default;
-
-      // Returns true if the server is reachable and the API key is valid
-      [[nodiscard]] bool GetValid() override;
-      [[nodiscard]] const std::string& GetMediaPath() const;
-      [[nodiscard]] std::optional<std::string> GetServerReportedName() override;
-      [[nodiscard]] std::optional<std::string> GetLibraryId(std::string_view libraryName);
-      [[nodiscard]] std::optional<PlexSearchResults> GetItemInfo(std::string_view name);
-      [[nodiscard]] std::unordered_map<int32_t, std::string> GetItemsPaths(const std::vector<int32_t>& ids);
-
-      // Returns if the collection in the library is valid on this server
-      [[nodiscard]] bool GetCollectionValid(std::string_view library, std::string_view collection);
-
-      // Returns the collection information for the collection in the library
-      [[nodiscard]] std::optional<PlexCollection> GetCollection(std::string_view library, std::string_view collectionName);
-
-      // Tell Plex to scan the passed in library
-      void SetLibraryScan(std::string_view libraryId);
-
-      bool SetPlayed(std::string_view ratingKey, int64_t locationMs);
-      bool SetWatched(std::string_view ratingKey);
-
-   private:
-      std::string_view GetApiBase() const override;
-      std::string_view GetApiTokenName() const override;
-
-      pugi::xml_node GetCollectionNode(std::string_view library, std::string_view collection);
-
-      std::optional<PlexSearchResults> SearchItem(std::string_view name);
-
-      httplib::Client client_;
-      httplib::Headers headers_;
-
-      std::string mediaPath_;
-
-      pugi::xml_document collectionDoc_;
-   };
+#pragma once
+
+#include "api/api-base.h"
+#include "api/api-lookup-cache.h"
+#include "api/api-plex-types.h"
+#include "config-reader/config-reader-types.h"
+
+#include <httplib.h>
+#include <pugixml.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace loomis
+{
+   struct JsonPlexMediaContainer;
+
+   class PlexApi : public ApiBase
+   {
+   public:
+      PlexApi(const ServerConfig& serverConfig, const std::filesystem::path& cachePath = {});
+
+      // Ensure the worker pool is stopped before the members its work uses are destroyed
+      ~PlexApi() override
+      {
+         Shutdown();
+      }
+
+      [[nodiscard]] std::optional<std::vector<Task>> GetTaskList() override;
+
+      [[nodiscard]] const std::string& GetMediaPath() const;
+      [[nodiscard]] std::optional<std::string> GetServerReportedName() override;
+      [[nodiscard]] std::optional<std::string> GetLibraryId(std::string_view libraryName);
+      [[nodiscard]] std::optional<PlexSearchResults> GetItemInfo(std::string_view name);
+      // Returns nullopt if the server could not be asked so a failure is never mistaken for items without paths
+      [[nodiscard]] std::optional<std::unordered_map<int32_t, std::string>> GetItemsPaths(const std::vector<int32_t>& ids);
+
+      // Returns the current play state of the items in one request. Items the server did not return are left out.
+      [[nodiscard]] std::optional<PlexPlayStates> GetPlayStates(const std::vector<std::string>& ratingKeys);
+
+      // Path map lookups are answered from the local map without asking the server
+      [[nodiscard]] bool GetPathMapEmpty() const;
+      [[nodiscard]] std::optional<std::string> GetRatingKeyFromPathMap(const std::string& path) const;
+
+      // Returns if the collection in the library is valid on this server
+      [[nodiscard]] bool GetCollectionValid(std::string_view library, std::string_view collection);
+
+      // Returns the collection information for the collection in the library
+      [[nodiscard]] std::optional<PlexCollection> GetCollection(std::string_view library, std::string_view collectionName);
+
+      // Tell Plex to scan the passed in library
+      void SetLibraryScan(std::string_view libraryId);
+
+      bool SetPlayed(std::string_view ratingKey, int64_t locationMs);
+      bool SetWatched(std::string_view ratingKey);
+
+      // Async variants run on the api worker pool
+      [[nodiscard]] std::future<std::optional<PlexSearchResults>> GetItemInfoAsync(std::string_view name);
+      [[nodiscard]] std::future<std::optional<std::unordered_map<int32_t, std::string>>> GetItemsPathsAsync(std::vector<int32_t> ids);
+      [[nodiscard]] std::future<bool> SetPlayedAsync(std::string_view ratingKey, int64_t locationMs);
+      [[nodiscard]] std::future<bool> SetWatchedAsync(std::string_view ratingKey);
+
+   private:
+      [[nodiscard]] bool ProbeServer() override;
+      std::string_view GetApiBase() const override;
+      std::string_view GetApiTokenName() const override;
+
+      // Scrobble, progress and library refresh are GET requests that change state
+      [[nodiscard]] bool GetRequestIdempotent(std::string_view method, std::string_view path) const override;
+
+      // Returns the key used to request the collection items. Keys are cached until the next refresh.
+      [[nodiscard]] std::optional<std::string> GetCollectionKey(std::string_view library, std::string_view collection);
+      void RemoveCollectionKey(std::string_view library, std::string_view collection);
+
+      [[nodiscard]] std::optional<ApiLookupCache<std::string>::Map> LoadLibraryIds();
+      void RunLookupCacheRefresh();
+
+      // Reads a JSON reply, or the XML one a server that ignores the Accept header sends, into the same structs
+      [[nodiscard]] std::optional<JsonPlexMediaContainer> ParseMediaContainer(std::string_view name, const std::string& body);
+
+      std::optional<PlexSearchResults> SearchItem(std::string_view name);
+
+      // Library section holding items for the path map
+      struct PathMapSection
+      {
+         std::string key;
+         PlexSearchTypes itemType{PlexSearchTypes::movie};
+      };
+
+      struct PathMapVideo
+      {
+         std::string ratingKey;
+         std::vector<std::string> paths;
+         int64_t addedAt{0};
+         int64_t updatedAt{0};
+      };
+
+      [[nodiscard]] std::optional<std::vector<PathMapSection>> GetPathMapSections();
+      [[nodiscard]] std::string BuildPathMapQuery(const PathMapSection& section, const ApiParams& extraParams, const ApiParams& profile) const;
+      [[nodiscard]] std::optional<uint32_t> GetPathMapItemCount(const PathMapSection& section);
+      [[nodiscard]] std::future<httplib::Result> GetPathMapPageAsync(const PathMapSection& section, uint32_t start);
+      [[nodiscard]] std::optional<std::vector<PathMapVideo>> ParsePathMapVideos(const std::string& body);
+      void BuildPathMap();
+      void RunPathMapQuickCheck();
+      void RunPathMapFullUpdate();
+
+      // Loads the path map saved by the last rebuild. Returns true if the map is ready to use.
+      [[nodiscard]] bool LoadPathMapFile();
+
+      // Patches the map with the items updated since the last sync.
+      // Returns false if the map no longer matches the server and has to be rebuilt.
+      [[nodiscard]] bool ApplyPathMapDelta();
+
+      httplib::Headers headers_;
+
+      std::string mediaPath_;
+
+      // Library name -> section key
+      ApiLookupCache<std::string> libraryIds_{[this]() { return LoadLibraryIds(); }};
+
+      // library/collection -> collection key
+      std::unordered_map<std::string, std::string> collectionKeys_;
+      std::mutex collectionKeysLock_;
+
+      // Readers load the current snapshot and writers swap in a new one so lookups never wait on an update
+      std::atomic<std::shared_ptr<const PlexPathMapSnapshot>> pathMap_{std::make_shared<const PlexPathMapSnapshot>()};
+
+      // Serializes path map writers between the cron tasks and the startup revalidation
+      std::mutex pathMapUpdateLock_;
+
+      // Empty if the path map is not persisted
+      std::filesystem::path pathMapFile_;
+
+      // Declared last so it is joined before the members it uses are destroyed
+      std::jthread pathMapRevalidateThread_;
+   };
 }
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "api-rate-limiter.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace loomis
+{
+   ApiRateLimiter::ApiRateLimiter(double requestsPerSecond)
+      : rate_(requestsPerSecond)
+      , burst_(std::max(1.0, requestsPerSecond))
+      , tokens_(burst_)
+      , lastRefill_(std::chrono::steady_clock::now())
+   {
+   }
+
+   void ApiRateLimiter::Acquire()
+   {
+      if (rate_ <= 0.0) return;
+
+      std::chrono::duration<double> wait{0.0};
+      {
+         std::lock_guard lock(lock_);
+
+         auto now = std::chrono::steady_clock::now();
+         std::chrono::duration<double> elapsed = now - lastRefill_;
+         tokens_ = std::min(burst_, tokens_ + (elapsed.count() * rate_));
+         lastRefill_ = now;
+
+         // Going below zero reserves a token that refills after the callers already waiting
+         tokens_ -= 1.0;
+         if (tokens_ < 0.0) wait = std::chrono::duration<double>(-tokens_ / rate_);
+      }
+
+      if (wait.count() <= 0.0) return;
+
+      auto waitTime = std::chrono::duration_cast<std::chrono::milliseconds>(wait);
+      waitTimeMs_.fetch_add(static_cast<uint64_t>(waitTime.count()), std::memory_order_relaxed);
+      std::this_thread::sleep_for(wait);
+   }
+
+   bool ApiRateLimiter::GetEnabled() const
+   {
+      return rate_ > 0.0;
+   }
+
+   std::chrono::milliseconds ApiRateLimiter::GetWaitTime() const
+   {
+      return std::chrono::milliseconds(waitTimeMs_.load(std::memory_order_relaxed));
+   }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace loomis
+{
+   // Token bucket that paces requests to one server. Up to a second of requests may be sent at once,
+   // after that callers wait for their turn. A rate of zero or less turns the limit off.
+   class ApiRateLimiter
+   {
+   public:
+      explicit ApiRateLimiter(double requestsPerSecond);
+
+      // Waits until the next request may be sent. Each call reserves its token before waiting
+      // so callers are let through in the order they arrived.
+      void Acquire();
+
+      [[nodiscard]] bool GetEnabled() const;
+
+      // Total time callers spent waiting for a token
+      [[nodiscard]] std::chrono::milliseconds GetWaitTime() const;
+
+   private:
+      double rate_{0.0};
+      double burst_{1.0};
+      double tokens_{1.0};
+      std::chrono::steady_clock::time_point lastRefill_;
+      std::mutex lock_;
+
+      std::atomic<uint64_t> waitTimeMs_{0u};
+   };
+}
@@ -0,0 +1,174 @@
+#include "api-request-metrics.h"
+
+#include "types.h"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cmath>
+
+namespace loomis
+{
+   namespace
+   {
+      // Ids in unusual paths could still make endless endpoints so the rest share one entry
+      constexpr size_t MAX_ENDPOINTS{256u};
+      const std::string OTHER_ENDPOINT{"other"};
+
+      const std::string ID_SEGMENT{"{id}"};
+      constexpr size_t MIN_HEX_ID_LENGTH{16u};
+
+      bool GetIdSegment(std::string_view segment)
+      {
+         if (segment.empty()) return false;
+
+         if (std::ranges::all_of(segment, [](unsigned char c) { return std::isdigit(c) != 0; })) return true;
+
+         return segment.size() >= MIN_HEX_ID_LENGTH &&
+                std::ranges::all_of(segment, [](unsigned char c) { return std::isxdigit(c) != 0 || c == '-'; });
+      }
+   }
+
+   size_t ApiLatencyHistogram::GetBucket(uint64_t value)
+   {
+      if (value < SUB_BUCKETS) return static_cast<size_t>(value);
+
+      auto exponent = static_cast<uint32_t>(std::bit_width(value)) - 1u;
+      if (exponent >= MAX_EXPONENT) return BUCKET_COUNT - 1u;
+
+      auto shift = exponent - SUB_BUCKET_BITS;
+      auto subBucket = (value >> shift) & (SUB_BUCKETS - 1u);
+      return SUB_BUCKETS + (shift * SUB_BUCKETS) + static_cast<size_t>(subBucket);
+   }
+
+   uint64_t ApiLatencyHistogram::GetBucketMax(size_t bucket)
+   {
+      if (bucket < SUB_BUCKETS) return bucket;
+
+      auto shift = static_cast<uint32_t>((bucket - SUB_BUCKETS) / SUB_BUCKETS);
+      auto subBucket = static_cast<uint64_t>((bucket - SUB_BUCKETS) % SUB_BUCKETS);
+      return ((SUB_BUCKETS + subBucket + 1u) << shift) - 1u;
+   }
+
+   void ApiLatencyHistogram::Record(std::chrono::microseconds latency)
+   {
+      auto value = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+      ++buckets_[GetBucket(value)];
+      ++count_;
+      sum_ += value;
+      max_ = std::max(max_, value);
+   }
+
+   std::chrono::microseconds ApiLatencyHistogram::GetPercentile(double percentile) const
+   {
+      if (count_ == 0u) return std::chrono::microseconds{0};
+
+      auto target = static_cast<uint64_t>(std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 * static_cast<double>(count_)));
+      target = std::max<uint64_t>(target, 1u);
+
+      uint64_t seen{0u};
+      for (size_t bucket = 0; bucket < buckets_.size(); ++bucket)
+      {
+         seen += buckets_[bucket];
+         if (seen >= target)
+         {
+            // The bucket bound can be above anything actually recorded
+            return std::chrono::microseconds(static_cast<int64_t>(std::min(GetBucketMax(bucket), max_)));
+         }
+      }
+      return std::chrono::microseconds(static_cast<int64_t>(max_));
+   }
+
+   uint64_t ApiLatencyHistogram::GetCount() const
+   {
+      return count_;
+   }
+
+   std::chrono::microseconds ApiLatencyHistogram::GetSum() const
+   {
+      return std::chrono::microseconds(static_cast<int64_t>(sum_));
+   }
+
+   std::chrono::microseconds ApiLatencyHistogram::GetMax() const
+   {
+      return std::chrono::microseconds(static_cast<int64_t>(max_));
+   }
+
+   ApiRequestMetrics::Endpoint& ApiRequestMetrics::GetEndpoint(const std::string& endpoint)
+   {
+      if (auto iter = endpoints_.find(endpoint); iter != endpoints_.end()) return iter->second;
+      if (endpoints_.size() >= MAX_ENDPOINTS) return endpoints_[OTHER_ENDPOINT];
+      return endpoints_[endpoint];
+   }
+
+   void ApiRequestMetrics::Record(const std::string& endpoint,
+                                  std::chrono::microseconds latency,
+                                  const httplib::Result& result,
+                                  size_t bytesSent,
+                                  size_t bytesReceived)
+   {
+      bool failed = result.error() != httplib::Error::Success || result->status >= VALID_HTTP_RESPONSE_MAX;
+
+      std::lock_guard lock(lock_);
+      auto& stats = GetEndpoint(endpoint);
+      ++stats.requests;
+      if (failed) ++stats.errors;
+      stats.bytesSent += bytesSent;
+      stats.bytesReceived += bytesReceived;
+      stats.latency.Record(latency);
+   }
+
+   void ApiRequestMetrics::RecordRetry(const std::string& endpoint)
+   {
+      std::lock_guard lock(lock_);
+      ++GetEndpoint(endpoint).retries;
+   }
+
+   std::vector<ApiEndpointStats> ApiRequestMetrics::GetSnapshot() const
+   {
+      std::vector<ApiEndpointStats> snapshot;
+      {
+         std::lock_guard lock(lock_);
+         snapshot.reserve(endpoints_.size());
+         for (const auto& [endpoint, stats] : endpoints_)
+         {
+            snapshot.emplace_back(ApiEndpointStats{
+               .endpoint = endpoint,
+               .requests = stats.requests,
+               .errors = stats.errors,
+               .retries = stats.retries,
+               .bytesSent = stats.bytesSent,
+               .bytesReceived = stats.bytesReceived,
+               .latencySum = stats.latency.GetSum(),
+               .p50 = stats.latency.GetPercentile(50.0),
+               .p90 = stats.latency.GetPercentile(90.0),
+               .p99 = stats.latency.GetPercentile(99.0),
+               .max = stats.latency.GetMax()
+            });
+         }
+      }
+
+      std::ranges::sort(snapshot, std::ranges::greater{}, &ApiEndpointStats::latencySum);
+      return snapshot;
+   }
+
+   std::string GetEndpointTemplate(std::string_view path)
+   {
+      path = path.substr(0, path.find('?'));
+
+      std::string endpoint;
+      endpoint.reserve(path.size());
+      size_t start{0u};
+      while (start <= path.size())
+      {
+         auto end = path.find('/', start);
+         if (end == std::string_view::npos) end = path.size();
+
+         auto segment = path.substr(start, end - start);
+         endpoint += GetIdSegment(segment) ? std::string_view(ID_SEGMENT) : segment;
+         if (end < path.size()) endpoint += '/';
+         start = end + 1u;
+      }
+      return endpoint;
+   }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <httplib.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace loomis
+{
+   // Log-linear latency histogram in the style of HdrHistogram. Every power of two is split in 8 buckets
+   // so a reported value is never more than 12.5% above the recorded one at any scale.
+   class ApiLatencyHistogram
+   {
+   public:
+      void Record(std::chrono::microseconds latency);
+
+      // Returns the highest value in the bucket holding the percentile. 0 when nothing was recorded.
+      [[nodiscard]] std::chrono::microseconds GetPercentile(double percentile) const;
+
+      [[nodiscard]] uint64_t GetCount() const;
+      [[nodiscard]] std::chrono::microseconds GetSum() const;
+      [[nodiscard]] std::chrono::microseconds GetMax() const;
+
+   private:
+      static constexpr uint32_t SUB_BUCKET_BITS{3u};
+      static constexpr uint32_t SUB_BUCKETS{1u << SUB_BUCKET_BITS};
+
+      // Values from 2^36us (about 19 hours) up share the last bucket
+      static constexpr uint32_t MAX_EXPONENT{36u};
+      static constexpr size_t BUCKET_COUNT{SUB_BUCKETS + ((MAX_EXPONENT - SUB_BUCKET_BITS) * SUB_BUCKETS)};
+
+      [[nodiscard]] static size_t GetBucket(uint64_t value);
+      [[nodiscard]] static uint64_t GetBucketMax(size_t bucket);
+
+      std::array<uint64_t, BUCKET_COUNT> buckets_{};
+      uint64_t count_{0u};
+      uint64_t sum_{0u};
+      uint64_t max_{0u};
+   };
+
+   // Traffic and latency of one endpoint of a server
+   struct ApiEndpointStats
+   {
+      // Method and path template, GET /Users/{id}/Items
+      std::string endpoint;
+
+      uint64_t requests{0u};
+
+      // Requests that did not reach the server or got an error status back
+      uint64_t errors{0u};
+      uint64_t retries{0u};
+
+      // Request and reply body bytes. Replies are counted after any decompression.
+      uint64_t bytesSent{0u};
+      uint64_t bytesReceived{0u};
+
+      std::chrono::microseconds latencySum{0};
+      std::chrono::microseconds p50{0};
+      std::chrono::microseconds p90{0};
+      std::chrono::microseconds p99{0};
+      std::chrono::microseconds max{0};
+   };
+
+   // Thread safe per endpoint request counters of one server
+   class ApiRequestMetrics
+   {
+   public:
+      ApiRequestMetrics() = default;
+
+      void Record(const std::string& endpoint,
+                  std::chrono::microseconds latency,
+                  const httplib::Result& result,
+                  size_t bytesSent,
+                  size_t bytesReceived);
+      void RecordRetry(const std::string& endpoint);
+
+      // Endpoints ordered by the total time spent on them, slowest first
+      [[nodiscard]] std::vector<ApiEndpointStats> GetSnapshot() const;
+
+   private:
+      struct Endpoint
+      {
+         uint64_t requests{0u};
+         uint64_t errors{0u};
+         uint64_t retries{0u};
+         uint64_t bytesSent{0u};
+         uint64_t bytesReceived{0u};
+         ApiLatencyHistogram latency;
+      };
+
+      // Only called with the lock held
+      Endpoint& GetEndpoint(const std::string& endpoint);
+
+      std::map<std::string, Endpoint, std::less<>> endpoints_;
+      mutable std::mutex lock_;
+   };
+
+   // Reduces a request path to its endpoint. The query is dropped and path segments that are ids
+   // (all digits or 16+ hex digits and dashes) become {id} so every item of a library shares one endpoint.
+   [[nodiscard]] std::string GetEndpointTemplate(std::string_view path);
+}
@@ -0,0 +1,32 @@
+#include "api-response-cache.h"
+
+namespace loomis
+{
+   std::optional<ApiCacheEntry> ApiResponseCache::Find(const std::string& key) const
+   {
+      std::lock_guard lock(lock_);
+      if (auto it = entries_.find(key); it != entries_.end())
+      {
+         return it->second;
+      }
+      return std::nullopt;
+   }
+
+   void ApiResponseCache::Store(const std::string& key, ApiCacheEntry entry)
+   {
+      std::lock_guard lock(lock_);
+      entries_.insert_or_assign(key, std::move(entry));
+   }
+
+   void ApiResponseCache::Clear()
+   {
+      std::lock_guard lock(lock_);
+      entries_.clear();
+   }
+
+   size_t ApiResponseCache::Size() const
+   {
+      std::lock_guard lock(lock_);
+      return entries_.size();
+   }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace loomis
+{
+   struct ApiCacheEntry
+   {
+      std::shared_ptr<const std::string> body;
+      std::string etag;
+      std::string lastModified;
+      std::chrono::steady_clock::time_point expires;
+
+      // True if the server supplied a validator the entry can be revalidated with
+      [[nodiscard]] bool CanRevalidate() const
+      {
+         return !etag.empty() || !lastModified.empty();
+      }
+   };
+
+   // Thread safe cache of GET response bodies keyed by request url
+   class ApiResponseCache
+   {
+   public:
+      ApiResponseCache() = default;
+
+      [[nodiscard]] std::optional<ApiCacheEntry> Find(const std::string& key) const;
+      void Store(const std::string& key, ApiCacheEntry entry);
+      void Clear();
+
+      [[nodiscard]] size_t Size() const;
+
+   private:
+      std::unordered_map<std::string, ApiCacheEntry> entries_;
+      mutable std::mutex lock_;
+   };
+}
@@ -0,0 +1,90 @@
+#include "api-retry-policy.h"
+
+#include <algorithm>
+#include <charconv>
+#include <random>
+#include <string>
+
+namespace loomis
+{
+   namespace
+   {
+      const std::string HEADER_RETRY_AFTER{"Retry-After"};
+
+      thread_local std::optional<std::chrono::steady_clock::time_point> runDeadline;
+
+      bool GetRetryableStatus(int status)
+      {
+         return status == httplib::StatusCode::TooManyRequests_429 ||
+            status == httplib::StatusCode::BadGateway_502 ||
+            status == httplib::StatusCode::ServiceUnavailable_503 ||
+            status == httplib::StatusCode::GatewayTimeout_504;
+      }
+   }
+
+   bool GetRetryable(const httplib::Result& result, bool idempotent)
+   {
+      switch (result.error())
+      {
+         case httplib::Error::Success:
+            // A server that is busy or restarting answers before doing any work
+            return GetRetryableStatus(result->status);
+         case httplib::Error::Connection:
+         case httplib::Error::ConnectionTimeout:
+            return true;
+         case httplib::Error::Read:
+         case httplib::Error::Write:
+            // The server may have acted on the request before the connection dropped
+            return idempotent;
+         default:
+            return false;
+      }
+   }
+
+   std::chrono::milliseconds GetRetryDelay(const ApiRetryPolicy& policy, const httplib::Result& result, uint32_t retry)
+   {
+      // Only the delta seconds form is used. An http date is rare from these servers.
+      if (result.error() == httplib::Error::Success && result->has_header(HEADER_RETRY_AFTER))
+      {
+         auto retryAfter = result->get_header_value(HEADER_RETRY_AFTER);
+         int64_t seconds{0};
+         if (std::from_chars(retryAfter.data(), retryAfter.data() + retryAfter.size(), seconds).ec == std::errc{} && seconds >= 0)
+         {
+            return std::min<std::chrono::milliseconds>(std::chrono::seconds(seconds), policy.maxDelay);
+         }
+      }
+
+      constexpr uint32_t maxShift{16u};
+      auto ceiling = std::min(policy.baseDelay * (int64_t{1} << std::min(retry - 1u, maxShift)), policy.maxDelay);
+
+      thread_local std::mt19937 generator{std::random_device{}()};
+      std::uniform_int_distribution<int64_t> distribution(0, ceiling.count());
+      return std::chrono::milliseconds(distribution(generator));
+   }
+
+   std::optional<std::chrono::steady_clock::time_point> ApiDeadline::Get()
+   {
+      return runDeadline;
+   }
+
+   bool ApiDeadline::GetAllows(std::chrono::milliseconds delay)
+   {
+      return !runDeadline || std::chrono::steady_clock::now() + delay < *runDeadline;
+   }
+
+   ApiDeadlineScope::ApiDeadlineScope(std::optional<std::chrono::steady_clock::time_point> deadline)
+      : previous_(runDeadline)
+   {
+      runDeadline = deadline;
+   }
+
+   ApiDeadlineScope::ApiDeadlineScope(std::chrono::steady_clock::duration budget)
+      : ApiDeadlineScope(std::optional{std::chrono::steady_clock::now() + budget})
+   {
+   }
+
+   ApiDeadlineScope::~ApiDeadlineScope()
+   {
+      runDeadline = previous_;
+   }
+}
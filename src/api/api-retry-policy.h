@@ -0,0 +1,52 @@
+#pragma once
+
+#include <httplib.h>
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace loomis
+{
+   // Requests that fail with a transient error are sent again after an exponential backoff with full jitter
+   struct ApiRetryPolicy
+   {
+      // Includes the first attempt
+      uint32_t maxAttempts{3u};
+      std::chrono::milliseconds baseDelay{500};
+      std::chrono::milliseconds maxDelay{8000};
+   };
+
+   // Returns if the request is worth sending again. Requests that are not idempotent are only sent again
+   // when the connection failed so the server never saw them.
+   [[nodiscard]] bool GetRetryable(const httplib::Result& result, bool idempotent);
+
+   // Random delay up to base * 2^(retry - 1) capped at the max. A Retry-After from the server is used instead when present.
+   [[nodiscard]] std::chrono::milliseconds GetRetryDelay(const ApiRetryPolicy& policy, const httplib::Result& result, uint32_t retry);
+
+   // Deadline of the service run on this thread. Retries that would wait past it are not made.
+   // Work queued with ApiBase::RunAsync carries the deadline of the thread that queued it.
+   class ApiDeadline
+   {
+   public:
+      [[nodiscard]] static std::optional<std::chrono::steady_clock::time_point> Get();
+
+      // Returns true if there is no deadline or waiting the delay still leaves time before it
+      [[nodiscard]] static bool GetAllows(std::chrono::milliseconds delay);
+   };
+
+   // Sets the deadline of the current thread until the scope ends
+   class ApiDeadlineScope
+   {
+   public:
+      explicit ApiDeadlineScope(std::optional<std::chrono::steady_clock::time_point> deadline);
+      explicit ApiDeadlineScope(std::chrono::steady_clock::duration budget);
+      ~ApiDeadlineScope();
+
+      ApiDeadlineScope(const ApiDeadlineScope&) = delete;
+      ApiDeadlineScope& operator=(const ApiDeadlineScope&) = delete;
+
+   private:
+      std::optional<std::chrono::steady_clock::time_point> previous_;
+   };
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace loomis
+{
+   // Runs one call per key at a time. A caller asking for a key that is already in flight waits for that call
+   // and shares its result instead of sending the same request again.
+   // The first caller runs the function on its own thread so a flight is never queued behind its waiters.
+   // Waiting callers do block their thread, pool workers included, so the function must not wait on work
+   // queued to a worker pool.
+   template <typename ValueT>
+   class ApiSingleFlight
+   {
+   public:
+      ApiSingleFlight() = default;
+
+      template <typename F>
+      [[nodiscard]] ValueT Run(const std::string& key, F&& func)
+      {
+         std::unique_lock lock(lock_);
+         if (auto iter = flights_.find(key); iter != flights_.end())
+         {
+            auto flight = iter->second;
+            lock.unlock();
+
+            sharedCalls_.fetch_add(1u, std::memory_order_relaxed);
+            return flight.get();
+         }
+
+         std::promise<ValueT> promise;
+         auto flight = promise.get_future().share();
+         flights_.emplace(key, flight);
+         lock.unlock();
+
+         try
+         {
+            promise.set_value(func());
+         }
+         catch (...)
+         {
+            promise.set_exception(std::current_exception());
+         }
+
+         // Callers arriving from here on start a new call so they never see a stale result
+         lock.lock();
+         flights_.erase(key);
+         lock.unlock();
+
+         return flight.get();
+      }
+
+      // Number of calls answered by a call that was already in flight
+      [[nodiscard]] uint64_t GetSharedCalls() const
+      {
+         return sharedCalls_.load(std::memory_order_relaxed);
+      }
+
+   private:
+      std::unordered_map<std::string, std::shared_future<ValueT>> flights_;
+      std::mutex lock_;
+      std::atomic<uint64_t> sharedCalls_{0u};
+   };
+}
@@ -1,31 +1,44 @@
-#pragma once
-
-#include <cstdint>
-#include <string>
-#include <vector>
-
-namespace loomis
-{
-   struct TautulliUserInfo
-   {
-      int32_t id{0};
-      std::string friendlyName;
-   };
-
-   // data representing an Tautulli History item
-   struct TautulliHistoryItem
-   {
-      std::string name;
-      std::string fullName;
-      int32_t id;
-      bool watched;
-      int64_t timeWatchedEpoch;
-      int32_t playbackPercentage;
-   };
-
-   // data representing an Tautulli History items
-   struct TautulliHistoryItems
-   {
-      std::vector<TautulliHistoryItem> items;
-   };
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace loomis
+{
+   struct TautulliUserInfo
+   {
+      int32_t id{0};
+      std::string friendlyName;
+   };
+
+   // Newest history row already handled. Rows are ordered by stop time and then by row id
+   // since several plays can stop in the same second.
+   struct TautulliHistoryWatermark
+   {
+      int64_t stopped{0};
+      int64_t rowId{0};
+   };
+
+   // data representing an Tautulli History item
+   struct TautulliHistoryItem
+   {
+      std::string name;
+      std::string fullName;
+      int32_t id;
+      int64_t rowId;
+      bool watched;
+      int64_t timeWatchedEpoch;
+      int32_t playbackPercentage;
+   };
+
+   // data representing an Tautulli History items
+   struct TautulliHistoryItems
+   {
+      std::vector<TautulliHistoryItem> items;
+
+      // Newest row read. Stays at the requested watermark when there were no new rows.
+      std::optional<TautulliHistoryWatermark> watermark;
+   };
 }
\ No newline at end of file
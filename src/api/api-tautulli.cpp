@@ -1,210 +1,301 @@
-#include "api-tautulli.h"
-
-#include "api/api-tautulli-json-types.h"
-#include "logger/log-utils.h"
-#include "version.h"
-
-#include <glaze/glaze.hpp>
-
-#include <format>
-#include <ranges>
-
-namespace loomis
-{
-   namespace
-   {
-      const std::string API_BASE{"/api/v2"};
-      const std::string API_TOKEN_NAME{"apikey"};
-      const std::string API_COMMAND{"cmd"};
-
-      const std::string CMD_GET_SERVER_FRIENDLY_NAME("get_server_friendly_name");
-      const std::string CMD_GET_SETTINGS{"get_settings"};
-      const std::string CMD_GET_USERS("get_users");
-      const std::string CMD_GET_HISTORY("get_history");
-      const std::string CMD_SERVER_INFO{"get_server_info"};
-
-      constexpr std::string_view USER("user");
-      constexpr std::string_view INCLUDE_ACTIVITY("include_activity");
-      constexpr std::string_view AFTER("after");
-      constexpr std::string_view SEARCH("search");
-
-      const std::string USER_AGENT{std::format("Loomis/{}", LOOMIS_VERSION)};
-   }
-
-   TautulliApi::TautulliApi(const ServerConfig& serverConfig)
-      : ApiBase(serverConfig.server_name, serverConfig.tracker_url, serverConfig.tracker_api_key, "TautulliApi", log::ANSI_CODE_TAUTULLI)
-      , client_(GetUrl())
-   {
-      constexpr time_t timeoutSec{5};
-      client_.set_connection_timeout(timeoutSec);
-
-      // Standardize headers
-      headers_.insert({"User-Agent", USER_AGENT});
-      headers_.insert({"Accept", "application/json"});
-   }
-
-   std::optional<std::vector<Task>> TautulliApi::GetTaskList()
-   {
-      std::vector<Task> tasks;
-
-      auto& fullUpdate = tasks.emplace_back();
-      fullUpdate.name = std::format("TautulliApi({}) - Settings Update", GetName());
-      fullUpdate.cronExpression = "0 50 3 * * *";
-      fullUpdate.func = [this]() {this->RunSettingsUpdate(); };
-
-      return tasks;
-   }
-
-   std::string_view TautulliApi::GetApiBase() const
-   {
-      return API_BASE;
-   }
-
-   std::string_view TautulliApi::GetApiTokenName() const
-   {
-      return API_TOKEN_NAME;
-   }
-
-   std::pair<std::string_view, std::string_view> TautulliApi::GetCmdParam(std::string_view cmd) const
-   {
-      return {API_COMMAND, cmd};
-   }
-
-   bool TautulliApi::GetValid()
-   {
-      auto apiPath = BuildApiParamsPath("", {GetCmdParam(CMD_GET_SERVER_FRIENDLY_NAME)});
-      auto res = client_.Get(apiPath, headers_);
-      return res.error() == httplib::Error::Success && res.value().status < VALID_HTTP_RESPONSE_MAX;
-   }
-
-   std::optional<std::string> TautulliApi::GetServerReportedName()
-   {
-      auto res = client_.Get(BuildApiParamsPath("", {GetCmdParam(CMD_SERVER_INFO)}), headers_);
-
-      if (!IsHttpSuccess(__func__, res))
-      {
-         return std::nullopt;
-      }
-
-      JsonTautulliResponse<JsonTautulliServerInfo> serverResponse;
-      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (serverResponse, res.value().body))
-      {
-         LogWarning("{} - JSON Parse Error: {}",
-                    __func__, glz::format_error(ec, res.value().body));
-         return std::nullopt;
-      }
-
-      if (serverResponse.response.data.pms_name.empty())
-      {
-         return std::nullopt;
-      }
-      return std::move(serverResponse.response.data.pms_name);
-   }
-
-   std::optional<TautulliUserInfo> TautulliApi::GetUserInfo(std::string_view name)
-   {
-      auto res = client_.Get(BuildApiParamsPath("", {GetCmdParam(CMD_GET_USERS)}), headers_);
-      if (!IsHttpSuccess(__func__, res)) return std::nullopt;
-
-      JsonTautulliResponse<std::vector<JsonUserInfo>> serverResponse;
-      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (serverResponse, res.value().body))
-      {
-         LogWarning("{} - JSON Parse Error: {}",
-                    __func__, glz::format_error(ec, res.value().body));
-         return std::nullopt;
-      }
-
-      auto it = std::ranges::find_if(serverResponse.response.data, [&](const auto& item) {
-         return item.username == name;
-      });
-
-      if (it == serverResponse.response.data.end())
-      {
-         return std::nullopt;
-      }
-
-      return TautulliUserInfo{it->user_id, std::move(it->friendly_name)};
-   }
-
-   bool TautulliApi::ReadMonitoringData()
-   {
-      auto apiPath = BuildApiParamsPath("", {
-         GetCmdParam(CMD_GET_SETTINGS),
-          {"key", "Monitoring"},
-      });
-
-      auto res = client_.Get(apiPath, headers_);
-      if (!IsHttpSuccess(__func__, res, false)) return false;
-
-      JsonTautulliResponse<JsonTautulliMonitorInfo> serverResponse;
-      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (serverResponse, res.value().body))
-      {
-         LogWarning("{} - JSON Parse Error: {}",
-                    __func__, glz::format_error(ec, res.value().body));
-         return false;
-      }
-
-      watchedPercent_ = serverResponse.response.data.movie_watched_percent;
-      return true;
-   }
-
-   int32_t TautulliApi::GetWatchedPercent()
-   {
-      if (watchedPercent_) return *watchedPercent_;
-
-      constexpr int32_t defaultWatchedPercent = 85;
-      return ReadMonitoringData() ? *watchedPercent_ : defaultWatchedPercent;
-   }
-
-   std::optional<TautulliHistoryItems> TautulliApi::GetWatchHistory(std::string_view user, const ApiParams& extraParams)
-   {
-      ApiParams params = {
-         GetCmdParam(CMD_GET_HISTORY),
-         {INCLUDE_ACTIVITY, "0"},
-         {USER, user}
-      };
-      params.reserve(params.size() + extraParams.size());
-      params.insert(params.end(), extraParams.begin(), extraParams.end());
-
-      auto res = client_.Get(BuildApiParamsPath("", params), headers_);
-      if (!IsHttpSuccess(__func__, res)) return std::nullopt;
-
-      JsonTautulliResponse<JsonTautulliHistoryData> serverResponse;
-      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (serverResponse, res.value().body))
-      {
-         LogWarning("{} - JSON Parse Error: {}",
-                    __func__, glz::format_error(ec, res.value().body));
-         return std::nullopt;
-      }
-
-      TautulliHistoryItems history;
-      history.items.reserve(serverResponse.response.data.data.size());
-
-      auto watchedPercent = GetWatchedPercent();
-      for (auto& item : serverResponse.response.data.data)
-      {
-         history.items.emplace_back(TautulliHistoryItem{
-             .name = std::move(item.title),
-             .fullName = std::move(item.full_title),
-             .id = item.rating_key,
-             .watched = item.percent_complete >= watchedPercent,
-             .timeWatchedEpoch = item.stopped,
-             .playbackPercentage = item.percent_complete
-         });
-      }
-
-      return history;
-   }
-
-   std::optional<TautulliHistoryItems> TautulliApi::GetWatchHistoryForUser(std::string_view user, std::string_view dateForHistory)
-   {
-      return GetWatchHistory(user, {
-         {AFTER, dateForHistory}
-      });
-   }
-
-   void TautulliApi::RunSettingsUpdate()
-   {
-      ReadMonitoringData();
-   }
+#include "api-tautulli.h"
+
+#include "api/api-tautulli-json-types.h"
+#include "api/api-utils.h"
+#include "logger/log-utils.h"
+#include "version.h"
+
+#include <glaze/glaze.hpp>
+
+#include <format>
+#include <ranges>
+
+namespace loomis
+{
+   namespace
+   {
+      const std::string API_BASE{"/api/v2"};
+      const std::string API_TOKEN_NAME{"apikey"};
+      const std::string API_COMMAND{"cmd"};
+
+      const std::string CMD_GET_SERVER_FRIENDLY_NAME("get_server_friendly_name");
+      const std::string CMD_GET_SETTINGS{"get_settings"};
+      const std::string CMD_GET_USERS("get_users");
+      const std::string CMD_GET_HISTORY("get_history");
+      const std::string CMD_SERVER_INFO{"get_server_info"};
+
+      constexpr std::string_view USER("user");
+      constexpr std::string_view INCLUDE_ACTIVITY("include_activity");
+      constexpr std::string_view AFTER("after");
+      constexpr std::string_view SEARCH("search");
+      constexpr std::string_view START("start");
+      constexpr std::string_view LENGTH("length");
+      constexpr std::string_view ORDER_COLUMN("order_column");
+      constexpr std::string_view ORDER_DIR("order_dir");
+      constexpr std::string_view GROUPING("grouping");
+
+      constexpr size_t HISTORY_PAGE_SIZE{200u};
+
+      bool GetAfterWatermark(int64_t stopped, int64_t rowId, const std::optional<TautulliHistoryWatermark>& watermark)
+      {
+         if (!watermark) return true;
+         return stopped != watermark->stopped ? stopped > watermark->stopped : rowId > watermark->rowId;
+      }
+
+      const std::string USER_AGENT{std::format("Loomis/{}", LOOMIS_VERSION)};
+   }
+
+   TautulliApi::TautulliApi(const ServerConfig& serverConfig, const std::filesystem::path& cachePath)
+      : ApiBase(serverConfig, serverConfig.tracker_url, serverConfig.tracker_api_key, "TautulliApi", log::ANSI_CODE_TAUTULLI)
+      , historyWatermarks_(cachePath.empty() ? std::filesystem::path{} : GetServerCacheFileName(cachePath, "tautulli-history-", serverConfig.server_name, ".json"))
+   {
+      // Standardize headers
+      headers_.insert({"User-Agent", USER_AGENT});
+      headers_.insert({"Accept", "application/json"});
+   }
+
+   std::optional<std::vector<Task>> TautulliApi::GetTaskList()
+   {
+      auto tasks = ApiBase::GetTaskList().value_or(std::vector<Task>{});
+
+      auto& fullUpdate = tasks.emplace_back();
+      fullUpdate.name = std::format("TautulliApi({}) - Settings Update", GetName());
+      fullUpdate.cronExpression = "0 50 3 * * *";
+      fullUpdate.func = [this]() {this->RunSettingsUpdate(); };
+
+      return tasks;
+   }
+
+   std::string_view TautulliApi::GetApiBase() const
+   {
+      return API_BASE;
+   }
+
+   std::string_view TautulliApi::GetApiTokenName() const
+   {
+      return API_TOKEN_NAME;
+   }
+
+   std::pair<std::string_view, std::string_view> TautulliApi::GetCmdParam(std::string_view cmd) const
+   {
+      return {API_COMMAND, cmd};
+   }
+
+   bool TautulliApi::ProbeServer()
+   {
+      auto apiPath = BuildApiParamsPath("", {GetCmdParam(CMD_GET_SERVER_FRIENDLY_NAME)});
+      auto res = Get(apiPath, headers_);
+      return res.error() == httplib::Error::Success && res.value().status < VALID_HTTP_RESPONSE_MAX;
+   }
+
+   std::string TautulliApi::GetEndpointName(std::string_view path) const
+   {
+      auto endpoint = ApiBase::GetEndpointName(path);
+
+      const auto cmdParam = std::format("{}=", API_COMMAND);
+      auto query = path.find('?');
+      for (auto start = query; start != std::string_view::npos; start = path.find('&', start + 1u))
+      {
+         auto param = path.substr(start + 1u);
+         if (!param.starts_with(cmdParam)) continue;
+
+         auto value = param.substr(0, param.find('&'));
+         return std::format("{}?{}", endpoint, value);
+      }
+      return endpoint;
+   }
+
+   std::optional<std::string> TautulliApi::GetServerReportedName()
+   {
+      auto res = Get(BuildApiParamsPath("", {GetCmdParam(CMD_SERVER_INFO)}), headers_);
+
+      if (!IsHttpSuccess(__func__, res))
+      {
+         return std::nullopt;
+      }
+
+      JsonTautulliResponse<JsonTautulliServerInfo> serverResponse;
+      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (serverResponse, res.value().body))
+      {
+         LogWarning("{} - JSON Parse Error: {}",
+                    __func__, glz::format_error(ec, res.value().body));
+         return std::nullopt;
+      }
+
+      if (serverResponse.response.data.pms_name.empty())
+      {
+         return std::nullopt;
+      }
+      return std::move(serverResponse.response.data.pms_name);
+   }
+
+   std::optional<TautulliUserInfo> TautulliApi::GetUserInfo(std::string_view name)
+   {
+      return users_.Find(name);
+   }
+
+   std::optional<ApiLookupCache<TautulliUserInfo>::Map> TautulliApi::LoadUsers()
+   {
+      auto body = GetCached(__func__, BuildApiParamsPath("", {GetCmdParam(CMD_GET_USERS)}), headers_, GetCacheTtl());
+      if (!body) return std::nullopt;
+
+      JsonTautulliResponse<std::vector<JsonUserInfo>> serverResponse;
+      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (serverResponse, *body))
+      {
+         LogWarning("{} - JSON Parse Error: {}",
+                    __func__, glz::format_error(ec, *body));
+         return std::nullopt;
+      }
+
+      ApiLookupCache<TautulliUserInfo>::Map users;
+      users.reserve(serverResponse.response.data.size());
+      for (auto& user : serverResponse.response.data)
+      {
+         users.emplace(std::move(user.username), TautulliUserInfo{user.user_id, std::move(user.friendly_name)});
+      }
+      return users;
+   }
+
+   bool TautulliApi::ReadMonitoringData()
+   {
+      auto apiPath = BuildApiParamsPath("", {
+         GetCmdParam(CMD_GET_SETTINGS),
+          {"key", "Monitoring"},
+      });
+
+      auto res = Get(apiPath, headers_);
+      if (!IsHttpSuccess(__func__, res, false)) return false;
+
+      JsonTautulliResponse<JsonTautulliMonitorInfo> serverResponse;
+      if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (serverResponse, res.value().body))
+      {
+         LogWarning("{} - JSON Parse Error: {}",
+                    __func__, glz::format_error(ec, res.value().body));
+         return false;
+      }
+
+      watchedPercent_.store(serverResponse.response.data.movie_watched_percent);
+      return true;
+   }
+
+   int32_t TautulliApi::GetWatchedPercent()
+   {
+      if (auto watchedPercent = watchedPercent_.load(); watchedPercent > 0) return watchedPercent;
+
+      constexpr int32_t defaultWatchedPercent = 85;
+      return ReadMonitoringData() ? watchedPercent_.load() : defaultWatchedPercent;
+   }
+
+   std::optional<TautulliApi::HistoryPageCount> TautulliApi::GetWatchHistoryPage(const ApiParams& params,
+                                                                               int32_t watchedPercent,
+                                                                               const std::optional<TautulliHistoryWatermark>& watermark,
+                                                                               TautulliHistoryItems& history)
+   {
+      // History grows without bound so it is decoded one item at a time as it arrives
+      HistoryPageCount count;
+      JsonTautulliHistoryItem item;
+      JsonArrayStream stream({"response", "data", "data"}, [&](const std::string& element) {
+         item = {};
+         if (auto ec = glz::read < glz::opts{.error_on_unknown_keys = false} > (item, element))
+         {
+            LogWarning("{} - JSON Parse Error: {}",
+                       __func__, glz::format_error(ec, element));
+            return false;
+         }
+
+         ++count.rows;
+         if (!GetAfterWatermark(item.stopped, item.id, watermark)) return true;
+
+         ++count.newRows;
+         if (GetAfterWatermark(item.stopped, item.id, history.watermark))
+         {
+            history.watermark = TautulliHistoryWatermark{.stopped = item.stopped, .rowId = item.id};
+         }
+
+         history.items.emplace_back(TautulliHistoryItem{
+             .name = std::move(item.title),
+             .fullName = std::move(item.full_title),
+             .id = item.rating_key,
+             .rowId = item.id,
+             .watched = item.percent_complete >= watchedPercent,
+             .timeWatchedEpoch = item.stopped,
+             .playbackPercentage = item.percent_complete
+         });
+         return true;
+      });
+
+      auto res = GetStream(BuildApiParamsPath("", params), headers_, stream.GetReceiver());
+      if (!IsJsonStreamSuccess(__func__, res, stream)) return std::nullopt;
+
+      return count;
+   }
+
+   std::optional<TautulliHistoryItems> TautulliApi::GetWatchHistoryForUser(std::string_view user,
+                                                                           std::string_view dateForHistory,
+                                                                           const std::optional<TautulliHistoryWatermark>& watermark)
+   {
+      auto watchedPercent = GetWatchedPercent();
+      const auto length = std::to_string(HISTORY_PAGE_SIZE);
+
+      TautulliHistoryItems history;
+      history.watermark = watermark;
+      for (size_t startIndex = 0;; startIndex += HISTORY_PAGE_SIZE)
+      {
+         const auto start = std::to_string(startIndex);
+
+         // Ungrouped rows so each play has its own stop time and row id
+         auto count = GetWatchHistoryPage({
+            GetCmdParam(CMD_GET_HISTORY),
+            {INCLUDE_ACTIVITY, "0"},
+            {GROUPING, "0"},
+            {USER, user},
+            {AFTER, dateForHistory},
+            {ORDER_COLUMN, "stopped"},
+            {ORDER_DIR, "desc"},
+            {START, start},
+            {LENGTH, length}
+         }, watchedPercent, watermark, history);
+         if (!count) return std::nullopt;
+
+         // Rows come newest stop time first, the order of the watermark, so once a page has nothing new
+         // the rest were handled by an earlier run
+         if (count->rows < HISTORY_PAGE_SIZE || count->newRows == 0) break;
+      }
+
+      return history;
+   }
+
+   std::optional<TautulliHistoryWatermark> TautulliApi::GetHistoryWatermark(std::string_view key) const
+   {
+      return historyWatermarks_.Find(key);
+   }
+
+   void TautulliApi::SetHistoryWatermark(std::string_view key, const TautulliHistoryWatermark& watermark)
+   {
+      if (!historyWatermarks_.Set(key, watermark))
+      {
+         LogWarning("{} - Failed to save the history watermark {}", __func__, log::GetTag("key", key));
+      }
+   }
+
+   std::future<std::optional<TautulliUserInfo>> TautulliApi::GetUserInfoAsync(std::string_view name)
+   {
+      return RunAsync([this, name = std::string(name)]() {
+         return GetUserInfo(name);
+      });
+   }
+
+   std::future<std::optional<TautulliHistoryItems>> TautulliApi::GetWatchHistoryForUserAsync(std::string_view user,
+                                                                                              std::string_view dateForHistory,
+                                                                                              const std::optional<TautulliHistoryWatermark>& watermark)
+   {
+      return RunAsync([this, user = std::string(user), dateForHistory = std::string(dateForHistory), watermark]() {
+         return GetWatchHistoryForUser(user, dateForHistory, watermark);
+      });
+   }
+
+   void TautulliApi::RunSettingsUpdate()
+   {
+      ReadMonitoringData();
+   }
 }
\ No newline at end of file
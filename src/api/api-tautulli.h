@@ -1,50 +1,94 @@
-#pragma once
-
-#include "api/api-base.h"
-#include "api/api-tautulli-types.h"
-#include "config-reader/config-reader-types.h"
-
-#include <httplib.h>
-
-#include <cstdint>
-#include <list>
-#include <optional>
-#include <string>
-
-namespace loomis
-{
-   class TautulliApi : public ApiBase
-   {
-   public:
-      TautulliApi(const ServerConfig& serverConfig);
-      virtual ~TautulliApi() = default;
-
-      [[nodiscard]] std::optional<std::vector<Task>> GetTaskList() override;
-
-      // Returns true if the server is reachable and the API key is valid
-      [[nodiscard]] bool GetValid() override;
-      [[nodiscard]] std::optional<std::string> GetServerReportedName() override;
-
-      [[nodiscard]] std::optional<TautulliUserInfo> GetUserInfo(std::string_view name);
-
-      [[nodiscard]] std::optional<TautulliHistoryItems> GetWatchHistoryForUser(std::string_view user, std::string_view dateForHistory);
-
-   private:
-      std::string_view GetApiBase() const override;
-      std::string_view GetApiTokenName() const override;
-
-      [[nodiscard]] std::pair<std::string_view, std::string_view> GetCmdParam(std::string_view cmd) const;
-      [[nodiscard]] std::optional<TautulliHistoryItems> GetWatchHistory(std::string_view user, const ApiParams& extraParams);
-
-      // Server should be responding before making this call
-      int32_t GetWatchedPercent();
-
-      bool ReadMonitoringData();
-      void RunSettingsUpdate();
-
-      httplib::Client client_;
-      httplib::Headers headers_;
-
-      std::optional<int32_t> watchedPercent_;
-   };
+#pragma once
+
+#include "api/api-base.h"
+#include "api/api-lookup-cache.h"
+#include "api/api-tautulli-types.h"
+#include "api/api-watermark-store.h"
+#include "config-reader/config-reader-types.h"
+
+#include <httplib.h>
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <list>
+#include <optional>
+#include <string>
+
+namespace loomis
+{
+   class TautulliApi : public ApiBase
+   {
+   public:
+      TautulliApi(const ServerConfig& serverConfig, const std::filesystem::path& cachePath = {});
+
+      // Ensure the worker pool is stopped before the members its work uses are destroyed
+      ~TautulliApi() override
+      {
+         Shutdown();
+      }
+
+      [[nodiscard]] std::optional<std::vector<Task>> GetTaskList() override;
+
+      [[nodiscard]] std::optional<std::string> GetServerReportedName() override;
+
+      [[nodiscard]] std::optional<TautulliUserInfo> GetUserInfo(std::string_view name);
+
+      // Pages through the history of the user since the date, newest first. With a watermark only the rows
+      // after it are returned and paging stops at the first page that holds no newer rows.
+      [[nodiscard]] std::optional<TautulliHistoryItems> GetWatchHistoryForUser(std::string_view user,
+                                                                               std::string_view dateForHistory,
+                                                                               const std::optional<TautulliHistoryWatermark>& watermark = std::nullopt);
+
+      // Watermarks are saved in the cache folder so a restart does not process the same rows again
+      [[nodiscard]] std::optional<TautulliHistoryWatermark> GetHistoryWatermark(std::string_view key) const;
+      void SetHistoryWatermark(std::string_view key, const TautulliHistoryWatermark& watermark);
+
+      // Async variants run on the api worker pool
+      [[nodiscard]] std::future<std::optional<TautulliUserInfo>> GetUserInfoAsync(std::string_view name);
+      [[nodiscard]] std::future<std::optional<TautulliHistoryItems>> GetWatchHistoryForUserAsync(std::string_view user,
+                                                                                                 std::string_view dateForHistory,
+                                                                                                 const std::optional<TautulliHistoryWatermark>& watermark = std::nullopt);
+
+   private:
+      [[nodiscard]] bool ProbeServer() override;
+
+      // Every command shares one path so the command is part of the endpoint name
+      [[nodiscard]] std::string GetEndpointName(std::string_view path) const override;
+      std::string_view GetApiBase() const override;
+      std::string_view GetApiTokenName() const override;
+
+      [[nodiscard]] std::pair<std::string_view, std::string_view> GetCmdParam(std::string_view cmd) const;
+
+      struct HistoryPageCount
+      {
+         size_t rows{0u};
+         size_t newRows{0u};
+      };
+
+      // Adds the rows of one page that are after the watermark to the history
+      [[nodiscard]] std::optional<HistoryPageCount> GetWatchHistoryPage(const ApiParams& params,
+                                                                        int32_t watchedPercent,
+                                                                        const std::optional<TautulliHistoryWatermark>& watermark,
+                                                                        TautulliHistoryItems& history);
+
+      // Server should be responding before making this call
+      int32_t GetWatchedPercent();
+
+      [[nodiscard]] std::optional<ApiLookupCache<TautulliUserInfo>::Map> LoadUsers();
+
+      bool ReadMonitoringData();
+      void RunSettingsUpdate();
+
+      httplib::Headers headers_;
+
+      // History can be requested from several threads. Zero until read from the server.
+      std::atomic<int32_t> watchedPercent_{0};
+
+      // User name -> user info. Shared by every configured user of this server and reloaded once the cache ttl passes.
+      ApiLookupCache<TautulliUserInfo> users_{[this]() { return LoadUsers(); }};
+
+      ApiWatermarkStore<TautulliHistoryWatermark> historyWatermarks_;
+   };
 }
\ No newline at end of file
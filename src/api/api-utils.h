@@ -1,40 +1,56 @@
-#pragma once
-
-#include <algorithm>
-#include <numeric>
-#include <string>
-#include <vector>
-
-namespace loomis
-{
-   inline std::string BuildCommaSeparatedList(const std::vector<std::string>& list)
-   {
-      if (list.empty()) return "";
-
-      return std::accumulate(std::next(list.begin()), list.end(), list[0],
-         [](std::string a, const std::string& b) {
-         return std::move(a) + "," + b;
-      });
-   }
-
-   inline std::string BuildCommaSeparatedList(const std::vector<int32_t>& ids)
-   {
-      if (ids.empty()) return {};
-
-      std::string result;
-      // Optimization: Pre-reserve to avoid reallocations
-      result.reserve(ids.size() * 7);
-
-      auto it = ids.begin();
-      // Format the first element without a comma
-      std::format_to(std::back_inserter(result), "{}", *it);
-
-      // Format subsequent elements with a leading comma
-      for (++it; it != ids.end(); ++it)
-      {
-         std::format_to(std::back_inserter(result), ",{}", *it);
-      }
-
-      return result;
-   }
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace loomis
+{
+   inline std::string BuildCommaSeparatedList(const std::vector<std::string>& list)
+   {
+      if (list.empty()) return "";
+
+      return std::accumulate(std::next(list.begin()), list.end(), list[0],
+         [](std::string a, const std::string& b) {
+         return std::move(a) + "," + b;
+      });
+   }
+
+   inline std::string BuildCommaSeparatedList(const std::vector<int32_t>& ids)
+   {
+      if (ids.empty()) return {};
+
+      std::string result;
+      // Optimization: Pre-reserve to avoid reallocations
+      result.reserve(ids.size() * 7);
+
+      auto it = ids.begin();
+      // Format the first element without a comma
+      std::format_to(std::back_inserter(result), "{}", *it);
+
+      // Format subsequent elements with a leading comma
+      for (++it; it != ids.end(); ++it)
+      {
+         std::format_to(std::back_inserter(result), ",{}", *it);
+      }
+
+      return result;
+   }
+
+   // File in the cache folder for data kept for one server
+   inline std::filesystem::path GetServerCacheFileName(const std::filesystem::path& cachePath, std::string_view prefix, std::string_view serverName, std::string_view extension)
+   {
+      // Server names are user supplied so keep only characters that are safe in a file name
+      std::string fileName{prefix};
+      for (char c : serverName)
+      {
+         fileName += std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' ? c : '_';
+      }
+      fileName += extension;
+      return cachePath / fileName;
+   }
 }
\ No newline at end of file
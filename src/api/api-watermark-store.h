@@ -0,0 +1,89 @@
+#pragma once
+
+#include <glaze/glaze.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace loomis
+{
+   // Thread safe key -> watermark map kept in a JSON file so history reads pick up where the last run stopped.
+   // Without a file the watermarks only last until a restart.
+   template <typename WatermarkT>
+   class ApiWatermarkStore
+   {
+   public:
+      explicit ApiWatermarkStore(std::filesystem::path file = {})
+         : file_(std::move(file))
+      {
+         Load();
+      }
+
+      [[nodiscard]] std::optional<WatermarkT> Find(std::string_view key) const
+      {
+         std::lock_guard lock(lock_);
+         if (auto iter = watermarks_.find(key); iter != watermarks_.end()) return iter->second;
+         return std::nullopt;
+      }
+
+      // Stores the watermark and saves the file. Returns false if the file could not be written.
+      bool Set(std::string_view key, const WatermarkT& watermark)
+      {
+         std::lock_guard lock(lock_);
+         watermarks_.insert_or_assign(std::string(key), watermark);
+         return Save();
+      }
+
+   private:
+      void Load()
+      {
+         if (file_.empty()) return;
+
+         std::error_code ec;
+         if (!std::filesystem::exists(file_, ec)) return;
+
+         // A damaged file only costs a re-read of the history window
+         std::string buffer;
+         if (glz::read_file_json<glz::opts{.error_on_unknown_keys = false}>(watermarks_, file_.string(), buffer))
+         {
+            watermarks_.clear();
+         }
+      }
+
+      bool Save() const
+      {
+         if (file_.empty()) return true;
+
+         auto json = glz::write_json(watermarks_);
+         if (!json) return false;
+
+         std::error_code ec;
+         std::filesystem::create_directories(file_.parent_path(), ec);
+         if (ec) return false;
+
+         // Written to a temporary file and renamed so a crash never leaves a partial file
+         auto tempFile = file_;
+         tempFile += ".tmp";
+         {
+            std::ofstream stream(tempFile, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!stream.is_open()) return false;
+            stream.write(json->data(), static_cast<std::streamsize>(json->size()));
+            if (!stream.good()) return false;
+         }
+
+         std::filesystem::rename(tempFile, file_, ec);
+         return !ec;
+      }
+
+      std::filesystem::path file_;
+      std::map<std::string, WatermarkT, std::less<>> watermarks_;
+      mutable std::mutex lock_;
+   };
+}
@@ -1,32 +1,38 @@
-#pragma once
-
-#include "config-reader/config-reader-types.h"
-#include "types.h"
-
-#include <span>
-#include <vector>
-
-namespace loomis
-{
-   class ConfigReader
-   {
-   public:
-      ConfigReader();
-      virtual ~ConfigReader() = default;
-
-      [[nodiscard]] bool IsConfigValid() const;
-
-      [[nodiscard]] const std::vector<ServerConfig>& GetPlexServers() const;
-      [[nodiscard]] const std::vector<ServerConfig>& GetEmbyServers() const;
-      [[nodiscard]] const AppriseLoggingConfig& GetAppriseLogging() const;
-      [[nodiscard]] const PlaylistSyncConfig& GetPlaylistSyncConfig() const;
-      [[nodiscard]] const WatchStateSyncConfig& GetWatchStateSyncConfig() const;
-      [[nodiscard]] const FolderCleanupConfig& GetFolderCleanupConfig() const;
-
-   private:
-      void ReadConfigFile(const char* path);
-
-      bool configValid_{false};
-      ConfigData configData_;
-   };
+#pragma once
+
+#include "config-reader/config-reader-types.h"
+#include "types.h"
+
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace loomis
+{
+   class ConfigReader
+   {
+   public:
+      ConfigReader();
+      virtual ~ConfigReader() = default;
+
+      [[nodiscard]] bool IsConfigValid() const;
+
+      [[nodiscard]] const std::vector<ServerConfig>& GetPlexServers() const;
+      [[nodiscard]] const std::vector<ServerConfig>& GetEmbyServers() const;
+      [[nodiscard]] const AppriseLoggingConfig& GetAppriseLogging() const;
+      [[nodiscard]] const MetricsServerConfig& GetMetricsServerConfig() const;
+      [[nodiscard]] const PlaylistSyncConfig& GetPlaylistSyncConfig() const;
+      [[nodiscard]] const WatchStateSyncConfig& GetWatchStateSyncConfig() const;
+      [[nodiscard]] const FolderCleanupConfig& GetFolderCleanupConfig() const;
+
+      // Directory under the config volume for data that can be rebuilt from the servers. Empty if CONFIG_PATH is not set.
+      [[nodiscard]] const std::filesystem::path& GetCachePath() const;
+
+   private:
+      void ReadConfigFile(const char* path);
+
+      bool configValid_{false};
+      ConfigData configData_;
+      std::filesystem::path cachePath_;
+   };
 }
\ No newline at end of file
@@ -1,108 +1,146 @@
-﻿#include "cron-scheduler.h"
-
-#include "logger/logger.h"
-#include "logger/log-utils.h"
-
-namespace loomis
-{
-   void CronScheduler::Add(const Task& task)
-   {
-      if (runThread_)
-      {
-         Logger::Instance().Error("Cron Scheduler: Attempted to add task {} after start", task.name);
-         return;
-      }
-
-      try
-      {
-         auto& cronTask = cronTasks_.emplace_back();
-         cronTask.task = task;
-         cronTask.cron = cron::make_cron(task.cronExpression);
-         // Initialize the first run time immediately
-         cronTask.nextRun = cron::cron_next(cronTask.cron, std::chrono::system_clock::now());
-
-         Logger::Instance().Trace("Cron Scheduler: Added task {} with {}",
-                                  log::GetTag("name", cronTask.task.name),
-                                  log::GetTag("cron", cronTask.task.cronExpression));
-      }
-      catch (const cron::bad_cronexpr& ex)
-      {
-         Logger::Instance().Error("Cron Scheduler: {} bad CRON {} - {}",
-                                  task.name, task.cronExpression, ex.what());
-      }
-   }
-
-   void CronScheduler::Work(std::stop_token stopToken)
-   {
-      while (!stopToken.stop_requested())
-      {
-         auto currentTime = std::chrono::system_clock::now();
-         auto nextWaitPoint = currentTime + std::chrono::years(1);
-
-         // 1. Find the earliest nextRun
-         for (const auto& task : cronTasks_)
-         {
-            if (task.nextRun < nextWaitPoint) nextWaitPoint = task.nextRun;
-         }
-
-         std::unique_lock<std::mutex> lock(cvLock_);
-
-         cv_.wait_until(lock, stopToken, nextWaitPoint, [&] {
-            return stopToken.stop_requested();
-         });
-
-         if (stopToken.stop_requested()) break;
-
-         currentTime = std::chrono::system_clock::now();
-         for (auto& cronTask : cronTasks_)
-         {
-            if (cronTask.nextRun <= currentTime)
-            {
-               Logger::Instance().Trace("Cron Scheduler: Running task {} with {}",
-                                        log::GetTag("name", cronTask.task.name),
-                                        log::GetTag("cron", cronTask.task.cronExpression));
-               try
-               {
-                  cronTask.task.func();
-               }
-               catch (const std::exception& e)
-               {
-                  Logger::Instance().Error("Task {} failed: {}", cronTask.task.name, e.what());
-               }
-               // Update nextRun for next time
-               cronTask.nextRun = cron::cron_next(cronTask.cron, std::chrono::system_clock::now());
-            }
-         }
-      }
-      Logger::Instance().Info("Cron Scheduler: Work thread shutting down");
-   }
-
-   bool CronScheduler::Start()
-   {
-      if (cronTasks_.empty()) return false;
-
-      // jthread starts immediately and manages its own lifetime
-      runThread_ = std::make_unique<std::jthread>([this](std::stop_token st) { Work(st); });
-
-      for (const auto& cronTask : cronTasks_)
-      {
-         if (cronTask.task.service)
-         {
-            Logger::Instance().Info("{}: Enabled - Schedule: {}",
-                                    cronTask.task.name, cronTask.task.cronExpression);
-         }
-      }
-      return true;
-   }
-
-   void CronScheduler::Shutdown()
-   {
-      if (!runThread_) return;
-
-      runThread_->request_stop();
-      cv_.notify_all();
-
-      if (runThread_->joinable()) runThread_->join();
-      runThread_.reset();
-   }
+﻿#include "cron-scheduler.h"
+
+#include "logger/logger.h"
+#include "logger/log-utils.h"
+
+namespace loomis
+{
+   void CronScheduler::Add(const Task& task)
+   {
+      if (runThread_)
+      {
+         Logger::Instance().Error("Cron Scheduler: Attempted to add task {} after start", task.name);
+         return;
+      }
+
+      try
+      {
+         auto& cronTask = cronTasks_.emplace_back();
+         cronTask.task = task;
+         cronTask.cron = cron::make_cron(task.cronExpression);
+         // Initialize the first run time immediately
+         cronTask.nextRun = cron::cron_next(cronTask.cron, std::chrono::system_clock::now());
+
+         Logger::Instance().Trace("Cron Scheduler: Added task {} with {}",
+                                  log::GetTag("name", cronTask.task.name),
+                                  log::GetTag("cron", cronTask.task.cronExpression));
+      }
+      catch (const cron::bad_cronexpr& ex)
+      {
+         Logger::Instance().Error("Cron Scheduler: {} bad CRON {} - {}",
+                                  task.name, task.cronExpression, ex.what());
+      }
+   }
+
+   void CronScheduler::Work(std::stop_token stopToken)
+   {
+      while (!stopToken.stop_requested())
+      {
+         auto currentTime = std::chrono::system_clock::now();
+         auto nextWaitPoint = currentTime + std::chrono::years(1);
+
+         // 1. Find the earliest nextRun
+         for (const auto& task : cronTasks_)
+         {
+            if (task.nextRun < nextWaitPoint) nextWaitPoint = task.nextRun;
+         }
+
+         std::unique_lock<std::mutex> lock(cvLock_);
+
+         cv_.wait_until(lock, stopToken, nextWaitPoint, [&] {
+            return stopToken.stop_requested();
+         });
+
+         if (stopToken.stop_requested()) break;
+
+         currentTime = std::chrono::system_clock::now();
+         for (auto& cronTask : cronTasks_)
+         {
+            if (cronTask.nextRun <= currentTime)
+            {
+               Logger::Instance().Trace("Cron Scheduler: Running task {} with {}",
+                                        log::GetTag("name", cronTask.task.name),
+                                        log::GetTag("cron", cronTask.task.cronExpression));
+               {
+                  std::lock_guard statusLock(statusLock_);
+                  cronTask.running = true;
+                  cronTask.lastRun = std::chrono::system_clock::now();
+               }
+
+               auto runStart = std::chrono::steady_clock::now();
+               bool failed{false};
+               try
+               {
+                  cronTask.task.func();
+               }
+               catch (const std::exception& e)
+               {
+                  failed = true;
+                  Logger::Instance().Error("Task {} failed: {}", cronTask.task.name, e.what());
+               }
+
+               // Update nextRun for next time
+               std::lock_guard statusLock(statusLock_);
+               cronTask.running = false;
+               cronTask.runs++;
+               if (failed) cronTask.failures++;
+               cronTask.lastRunDuration = std::chrono::steady_clock::now() - runStart;
+               cronTask.nextRun = cron::cron_next(cronTask.cron, std::chrono::system_clock::now());
+            }
+         }
+      }
+      Logger::Instance().Info("Cron Scheduler: Work thread shutting down");
+   }
+
+   bool CronScheduler::Start()
+   {
+      if (cronTasks_.empty()) return false;
+
+      // jthread starts immediately and manages its own lifetime
+      runThread_ = std::make_unique<std::jthread>([this](std::stop_token st) { Work(st); });
+
+      for (const auto& cronTask : cronTasks_)
+      {
+         if (cronTask.task.service)
+         {
+            Logger::Instance().Info("{}: Enabled - Schedule: {}",
+                                    cronTask.task.name, cronTask.task.cronExpression);
+         }
+      }
+      return true;
+   }
+
+   std::vector<CronTaskStatus> CronScheduler::GetTaskStatus() const
+   {
+      std::lock_guard statusLock(statusLock_);
+
+      std::vector<CronTaskStatus> status;
+      status.reserve(cronTasks_.size());
+      for (const auto& cronTask : cronTasks_)
+      {
+         status.emplace_back(CronTaskStatus{
+            .name = cronTask.task.plainName.empty() ? cronTask.task.name : cronTask.task.plainName,
+            .cronExpression = cronTask.task.cronExpression,
+            .service = cronTask.task.service,
+            .running = cronTask.running,
+            .runs = cronTask.runs,
+            .failures = cronTask.failures,
+            .lastRun = cronTask.lastRun,
+            .lastRunDuration = cronTask.lastRunDuration,
+            .nextRun = cronTask.nextRun
+         });
+      }
+      return status;
+   }
+
+   void CronScheduler::Shutdown()
+   {
+      if (!runThread_) return;
+
+      runThread_->request_stop();
+      cv_.notify_all();
+
+      if (runThread_->joinable()) runThread_->join();
+      runThread_.reset();
+   }
 }
\ No newline at end of file
@@ -1,52 +1,82 @@
-#pragma once
-
-#include "types.h"
-
-#include <chrono>
-#include <condition_variable>
-#include <croncpp.h>
-#include <functional>
-#include <mutex>
-#include <string>
-#include <thread>
-#include <vector>
-
-namespace loomis
-{
-   struct CronTask
-   {
-      Task task;
-      cron::cronexpr cron;
-      std::chrono::system_clock::time_point nextRun;
-   };
-
-   class CronScheduler
-   {
-   public:
-      CronScheduler() = default;
-      // Ensure the thread is stopped before the object is destroyed
-      ~CronScheduler()
-      {
-         Shutdown();
-      }
-
-      // Standardize: Add tasks before starting
-      void Add(const Task& task);
-
-      bool Start();
-      void Shutdown();
-
-   private:
-      // The worker thread logic
-      void Work(std::stop_token stopToken);
-
-      std::vector<CronTask> cronTasks_;
-
-      // Mutex and CV_ANY are required for the C++20 stop_token pattern
-      std::mutex cvLock_;
-      std::condition_variable_any cv_;
-
-      // jthread manages its own stop_state and joins on destruction
-      std::unique_ptr<std::jthread> runThread_;
-   };
+#pragma once
+
+#include "types.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <croncpp.h>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace loomis
+{
+   struct CronTask
+   {
+      Task task;
+      cron::cronexpr cron;
+      std::chrono::system_clock::time_point nextRun;
+
+      bool running{false};
+      uint64_t runs{0u};
+      uint64_t failures{0u};
+      std::optional<std::chrono::system_clock::time_point> lastRun;
+      std::chrono::steady_clock::duration lastRunDuration{0};
+   };
+
+   // Copy of a task's schedule and run history for reporting
+   struct CronTaskStatus
+   {
+      // Plain task name without ANSI codes
+      std::string name;
+      std::string cronExpression;
+      bool service{false};
+      bool running{false};
+      uint64_t runs{0u};
+
+      // Runs that ended with an exception
+      uint64_t failures{0u};
+      std::optional<std::chrono::system_clock::time_point> lastRun;
+      std::chrono::steady_clock::duration lastRunDuration{0};
+      std::chrono::system_clock::time_point nextRun;
+   };
+
+   class CronScheduler
+   {
+   public:
+      CronScheduler() = default;
+      // Ensure the thread is stopped before the object is destroyed
+      ~CronScheduler()
+      {
+         Shutdown();
+      }
+
+      // Standardize: Add tasks before starting
+      void Add(const Task& task);
+
+      bool Start();
+      void Shutdown();
+
+      // Safe to call from any thread while the scheduler runs
+      [[nodiscard]] std::vector<CronTaskStatus> GetTaskStatus() const;
+
+   private:
+      // The worker thread logic
+      void Work(std::stop_token stopToken);
+
+      std::vector<CronTask> cronTasks_;
+
+      // Mutex and CV_ANY are required for the C++20 stop_token pattern
+      std::mutex cvLock_;
+      std::condition_variable_any cv_;
+
+      // Guards the run state of the tasks. The schedule itself only changes before the start.
+      mutable std::mutex statusLock_;
+
+      // jthread manages its own stop_state and joins on destruction
+      std::unique_ptr<std::jthread> runThread_;
+   };
 }
\ No newline at end of file
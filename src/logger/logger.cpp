@@ -1,68 +1,74 @@
-#include "logger.h"
-
-#include "logger/ansii-formatter.h"
-#include "logger/ansii-remove-formatter.h"
-#include "logger/log-apprise-sync.h"
-#include "logger/logger-types.h"
-#include "logger/log-utils.h"
-
-#include <spdlog/async.h>
-#include <spdlog/async_logger.h>
-#include <spdlog/sinks/rotating_file_sink.h>
-#include <spdlog/sinks/stdout_color_sinks.h>
-
-#include <ranges>
-#include <regex>
-
-namespace loomis
-{
-   Logger::Logger()
-   {
-      // 8192 is the queue size (must be power of 2), 1 is the number of worker threads
-      spdlog::init_thread_pool(128, 1);
-
-      std::vector<spdlog::sink_ptr> sinks;
-      auto& consoleSink{sinks.emplace_back(std::make_shared<spdlog::sinks::stdout_color_sink_mt>())};
-      consoleSink->set_formatter(std::make_unique<AnsiiFormatter>());
-
-      // If the log path is defined create a rotating file logger
-      if (const auto* logPath = std::getenv("LOG_PATH");
-          logPath != nullptr)
-      {
-         std::string logPathFilename = logPath;
-         logPathFilename.append("/loomis.log");
-
-         constexpr size_t max_size{1048576 * 5};
-         constexpr size_t max_files{5};
-         auto& fileSink{sinks.emplace_back(std::make_shared<spdlog::sinks::rotating_file_sink_mt>(logPathFilename, max_size, max_files))};
-         fileSink->set_formatter(std::make_unique<AnsiiRemoveFormatter>());
-      }
-
-      logger_ = std::make_shared<spdlog::async_logger>("loomis",
-                                                       sinks.begin(),
-                                                       sinks.end(),
-                                                       spdlog::thread_pool(),
-                                                       spdlog::async_overflow_policy::block);
-      logger_->flush_on(spdlog::level::info);
-
-#if defined(_DEBUG) || !defined(NDEBUG)
-      logger_->set_level(spdlog::level::trace);
-#endif
-   }
-
-   void Logger::InitApprise(const AppriseLoggingConfig& config)
-   {
-      if (config.enabled)
-      {
-         auto app_sink = std::make_shared<loomis::apprise_sink_mt>(config);
-
-         // Only notify on Warnings and Errors
-         app_sink->set_level(spdlog::level::warn);
-
-         // Clean pattern for mobile/email notifications (No colors)
-         app_sink->set_pattern("[%l] %v");
-
-         logger_->sinks().push_back(app_sink);
-      }
-   }
+#include "logger.h"
+
+#include "logger/ansii-formatter.h"
+#include "logger/ansii-remove-formatter.h"
+#include "logger/log-apprise-sync.h"
+#include "logger/logger-types.h"
+#include "logger/log-utils.h"
+
+#include <spdlog/async.h>
+#include <spdlog/async_logger.h>
+#include <spdlog/sinks/rotating_file_sink.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+#include <ranges>
+#include <regex>
+
+namespace loomis
+{
+   Logger::Logger()
+   {
+      // 8192 is the queue size (must be power of 2), 1 is the number of worker threads
+      spdlog::init_thread_pool(128, 1);
+
+      std::vector<spdlog::sink_ptr> sinks;
+      auto& consoleSink{sinks.emplace_back(std::make_shared<spdlog::sinks::stdout_color_sink_mt>())};
+      consoleSink->set_formatter(std::make_unique<AnsiiFormatter>());
+
+      // If the log path is defined create a rotating file logger
+      if (const auto* logPath = std::getenv("LOG_PATH");
+          logPath != nullptr)
+      {
+         std::string logPathFilename = logPath;
+         logPathFilename.append("/loomis.log");
+
+         constexpr size_t max_size{1048576 * 5};
+         constexpr size_t max_files{5};
+         auto& fileSink{sinks.emplace_back(std::make_shared<spdlog::sinks::rotating_file_sink_mt>(logPathFilename, max_size, max_files))};
+         fileSink->set_formatter(std::make_unique<AnsiiRemoveFormatter>());
+      }
+
+      logger_ = std::make_shared<spdlog::async_logger>("loomis",
+                                                       sinks.begin(),
+                                                       sinks.end(),
+                                                       spdlog::thread_pool(),
+                                                       spdlog::async_overflow_policy::block);
+      logger_->flush_on(spdlog::level::info);
+
+#if defined(_DEBUG) || !defined(NDEBUG)
+      logger_->set_level(spdlog::level::trace);
+#endif
+   }
+
+   size_t Logger::GetQueueDepth() const
+   {
+      auto threadPool = spdlog::thread_pool();
+      return threadPool ? threadPool->queue_size() : 0u;
+   }
+
+   void Logger::InitApprise(const AppriseLoggingConfig& config)
+   {
+      if (config.enabled)
+      {
+         auto app_sink = std::make_shared<loomis::apprise_sink_mt>(config);
+
+         // Only notify on Warnings and Errors
+         app_sink->set_level(spdlog::level::warn);
+
+         // Clean pattern for mobile/email notifications (No colors)
+         app_sink->set_pattern("[%l] %v");
+
+         logger_->sinks().push_back(app_sink);
+      }
+   }
 }
\ No newline at end of file
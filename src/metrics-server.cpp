@@ -0,0 +1,442 @@
+#include "metrics-server.h"
+
+#include "logger/logger.h"
+#include "logger/log-utils.h"
+#include "version.h"
+
+#include <glaze/glaze.hpp>
+
+#include <format>
+#include <initializer_list>
+#include <iterator>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace loomis
+{
+   namespace
+   {
+      const std::string CONTENT_TYPE_PROMETHEUS{"text/plain; version=0.0.4; charset=utf-8"};
+      const std::string CONTENT_TYPE_JSON{"application/json"};
+
+      struct ApiSnapshot
+      {
+         std::string className;
+         std::string name;
+         ApiHealth health;
+         ApiTransferStats transfer;
+         ApiCacheStats cache;
+         std::vector<ApiEndpointStats> endpoints;
+         std::optional<EmbyPathMapStats> pathMap;
+      };
+
+      std::vector<ApiSnapshot> GetApiSnapshots(const ApiManager& apiManager)
+      {
+         std::vector<ApiSnapshot> snapshots;
+         for (auto* api : apiManager.GetApis())
+         {
+            auto& snapshot = snapshots.emplace_back();
+            snapshot.className = api->GetClassName();
+            snapshot.name = api->GetName();
+            snapshot.health = api->GetHealth();
+            snapshot.transfer = api->GetTransferStats();
+            snapshot.cache = api->GetCacheStats();
+            snapshot.endpoints = api->GetEndpointStats();
+            if (const auto* embyApi = dynamic_cast<const EmbyApi*>(api)) snapshot.pathMap = embyApi->GetPathMapStats();
+         }
+         return snapshots;
+      }
+
+      int64_t GetEpochSeconds(std::chrono::system_clock::time_point timePoint)
+      {
+         return std::chrono::duration_cast<std::chrono::seconds>(timePoint.time_since_epoch()).count();
+      }
+
+      template <typename Rep, typename Period>
+      double GetSeconds(std::chrono::duration<Rep, Period> duration)
+      {
+         return std::chrono::duration<double>(duration).count();
+      }
+
+      using Labels = std::initializer_list<std::pair<std::string_view, std::string_view>>;
+
+      // Label values escape backslash, double quote and line feed
+      std::string GetLabels(Labels labels)
+      {
+         std::string text{"{"};
+         for (const auto& [name, value] : labels)
+         {
+            if (text.size() > 1u) text += ',';
+            text += name;
+            text += "=\"";
+            for (char c : value)
+            {
+               switch (c)
+               {
+                  case '\\': text += "\\\\"; break;
+                  case '"': text += "\\\""; break;
+                  case '\n': text += "\\n"; break;
+                  default: text += c; break;
+               }
+            }
+            text += '"';
+         }
+         text += '}';
+         return text;
+      }
+
+      // Writes the Prometheus text format. Every sample of a family has to follow its header.
+      class PrometheusWriter
+      {
+      public:
+         void Family(std::string_view name, std::string_view type, std::string_view help)
+         {
+            std::format_to(std::back_inserter(text_), "# HELP {} {}\n# TYPE {} {}\n", name, help, name, type);
+         }
+
+         template <typename T>
+         void Sample(std::string_view name, const std::string& labels, T value)
+         {
+            std::format_to(std::back_inserter(text_), "{}{} {}\n", name, labels, value);
+         }
+
+         [[nodiscard]] std::string& GetText()
+         {
+            return text_;
+         }
+
+      private:
+         std::string text_;
+      };
+
+      struct JsonTaskStatus
+      {
+         std::string name;
+         std::string cron;
+         bool service{false};
+         bool running{false};
+         uint64_t runs{0u};
+         uint64_t failures{0u};
+         std::optional<int64_t> last_run_epoch;
+         double last_run_duration_seconds{0.0};
+         int64_t next_run_epoch{0};
+      };
+
+      struct JsonEndpointStatus
+      {
+         std::string endpoint;
+         uint64_t requests{0u};
+         uint64_t errors{0u};
+         uint64_t retries{0u};
+         uint64_t bytes_sent{0u};
+         uint64_t bytes_received{0u};
+         double latency_total_seconds{0.0};
+         double latency_p50_seconds{0.0};
+         double latency_p90_seconds{0.0};
+         double latency_p99_seconds{0.0};
+         double latency_max_seconds{0.0};
+      };
+
+      struct JsonPathMapStatus
+      {
+         size_t index_items{0u};
+         size_t index_bytes{0u};
+         size_t delta_items{0u};
+         size_t delta_bytes{0u};
+      };
+
+      struct JsonApiStatus
+      {
+         std::string api;
+         std::string server;
+         bool online{false};
+         uint32_t failed_probes{0u};
+         int64_t last_change_epoch{0};
+         int64_t last_probe_epoch{0};
+         uint64_t replies{0u};
+         uint64_t compressed_replies{0u};
+         uint64_t body_bytes{0u};
+         uint64_t wire_bytes{0u};
+         uint64_t shared_requests{0u};
+         uint64_t retries{0u};
+         uint64_t throttled_ms{0u};
+         uint64_t cache_hits{0u};
+         uint64_t cache_revalidated{0u};
+         uint64_t cache_misses{0u};
+         size_t cache_entries{0u};
+         std::optional<JsonPathMapStatus> path_map;
+         std::vector<JsonEndpointStatus> endpoints;
+      };
+
+      struct JsonStatus
+      {
+         std::string version;
+         size_t logger_queue_depth{0u};
+         std::vector<JsonTaskStatus> tasks;
+         std::vector<JsonApiStatus> apis;
+      };
+   }
+
+   MetricsServer::MetricsServer(const CronScheduler& cronScheduler, std::shared_ptr<ApiManager> apiManager)
+      : cronScheduler_(cronScheduler)
+      , apiManager_(apiManager)
+   {
+   }
+
+   bool MetricsServer::Start(const MetricsServerConfig& config)
+   {
+      if (!config.enabled || runThread_) return false;
+
+      server_.Get("/metrics", [this](const httplib::Request&, httplib::Response& res) {
+         res.set_content(GetPrometheusMetrics(), CONTENT_TYPE_PROMETHEUS);
+      });
+
+      server_.Get("/status", [this](const httplib::Request&, httplib::Response& res) {
+         res.set_content(GetStatusJson(), CONTENT_TYPE_JSON);
+      });
+
+      // Bind on this thread so a port in use is reported here instead of failing quietly on the listen thread
+      if (!server_.bind_to_port(config.address, static_cast<int>(config.port)))
+      {
+         Logger::Instance().Error("Metrics Server: Failed to listen on {} {}",
+                                  log::GetTag("address", config.address),
+                                  log::GetTag("port", config.port));
+         return false;
+      }
+
+      runThread_ = std::make_unique<std::jthread>([this]() { server_.listen_after_bind(); });
+
+      // A stop before the server is running would be lost and leave the thread listening
+      server_.wait_until_ready();
+
+      Logger::Instance().Info("Metrics Server: Serving /metrics and /status on {} {}",
+                              log::GetTag("address", config.address),
+                              log::GetTag("port", config.port));
+      return true;
+   }
+
+   void MetricsServer::Shutdown()
+   {
+      if (!runThread_) return;
+
+      server_.stop();
+
+      if (runThread_->joinable()) runThread_->join();
+      runThread_.reset();
+   }
+
+   std::string MetricsServer::GetPrometheusMetrics() const
+   {
+      const auto tasks = cronScheduler_.GetTaskStatus();
+      const auto apis = GetApiSnapshots(*apiManager_);
+
+      PrometheusWriter writer;
+      writer.Family("loomis_build_info", "gauge", "Version of the running Loomis");
+      writer.Sample("loomis_build_info", GetLabels({{"version", LOOMIS_VERSION}}), 1);
+
+      writer.Family("loomis_logger_queue_depth", "gauge", "Log messages waiting for the log thread");
+      writer.Sample("loomis_logger_queue_depth", "", Logger::Instance().GetQueueDepth());
+
+      auto taskFamily = [&](std::string_view name, std::string_view type, std::string_view help, auto getValue) {
+         writer.Family(name, type, help);
+         for (const auto& task : tasks) writer.Sample(name, GetLabels({{"task", task.name}}), getValue(task));
+      };
+
+      taskFamily("loomis_task_running", "gauge", "1 while the task is running",
+                 [](const CronTaskStatus& task) { return task.running ? 1 : 0; });
+      taskFamily("loomis_task_runs_total", "counter", "Completed runs of the task",
+                 [](const CronTaskStatus& task) { return task.runs; });
+      taskFamily("loomis_task_failures_total", "counter", "Runs of the task that ended with an exception",
+                 [](const CronTaskStatus& task) { return task.failures; });
+      taskFamily("loomis_task_last_run_duration_seconds", "gauge", "Time the last completed run took",
+                 [](const CronTaskStatus& task) { return GetSeconds(task.lastRunDuration); });
+      taskFamily("loomis_task_last_run_timestamp_seconds", "gauge", "Start of the last run. 0 if the task has not run",
+                 [](const CronTaskStatus& task) { return task.lastRun ? GetEpochSeconds(*task.lastRun) : 0; });
+      taskFamily("loomis_task_next_run_timestamp_seconds", "gauge", "Next scheduled start of the task",
+                 [](const CronTaskStatus& task) { return GetEpochSeconds(task.nextRun); });
+
+      auto apiFamily = [&](std::string_view name, std::string_view type, std::string_view help, auto getValue) {
+         writer.Family(name, type, help);
+         for (const auto& api : apis)
+         {
+            writer.Sample(name, GetLabels({{"api", api.className}, {"server", api.name}}), getValue(api));
+         }
+      };
+
+      apiFamily("loomis_api_up", "gauge", "1 if the last health probe reached the server",
+                [](const ApiSnapshot& api) { return api.health.online ? 1 : 0; });
+      apiFamily("loomis_api_failed_probes", "gauge", "Health probes failed in a row",
+                [](const ApiSnapshot& api) { return api.health.failedProbes; });
+      apiFamily("loomis_api_replies_total", "counter", "Replies read from the server",
+                [](const ApiSnapshot& api) { return api.transfer.replies; });
+      apiFamily("loomis_api_compressed_replies_total", "counter", "Replies the server sent compressed",
+                [](const ApiSnapshot& api) { return api.transfer.compressedReplies; });
+      apiFamily("loomis_api_body_bytes_total", "counter", "Reply body bytes after decompression",
+                [](const ApiSnapshot& api) { return api.transfer.bodyBytes; });
+      apiFamily("loomis_api_wire_bytes_total", "counter", "Reply body bytes on the wire for replies with a Content-Length",
+                [](const ApiSnapshot& api) { return api.transfer.wireBytes; });
+      apiFamily("loomis_api_shared_requests_total", "counter", "Calls answered by a request already in flight",
+                [](const ApiSnapshot& api) { return api.transfer.sharedRequests; });
+      apiFamily("loomis_api_retries_total", "counter", "Requests sent again after a transient failure",
+                [](const ApiSnapshot& api) { return api.transfer.retries; });
+      apiFamily("loomis_api_throttled_seconds_total", "counter", "Time requests waited on the rate limit",
+                [](const ApiSnapshot& api) { return GetSeconds(std::chrono::milliseconds(api.transfer.throttledMs)); });
+      apiFamily("loomis_api_cache_entries", "gauge", "Responses held in the response cache",
+                [](const ApiSnapshot& api) { return api.cache.entries; });
+
+      writer.Family("loomis_api_cache_requests_total", "counter", "Cached GET requests by result. hit and revalidated did not download the body");
+      for (const auto& api : apis)
+      {
+         for (const auto& [result, count] : {std::pair{"hit", api.cache.hits},
+                                             std::pair{"revalidated", api.cache.revalidated},
+                                             std::pair{"miss", api.cache.misses}})
+         {
+            writer.Sample("loomis_api_cache_requests_total", GetLabels({{"api", api.className}, {"server", api.name}, {"result", result}}), count);
+         }
+      }
+
+      auto endpointFamily = [&](std::string_view name, std::string_view help, auto getValue) {
+         writer.Family(name, "counter", help);
+         for (const auto& api : apis)
+         {
+            for (const auto& endpoint : api.endpoints)
+            {
+               writer.Sample(name, GetLabels({{"api", api.className}, {"server", api.name}, {"endpoint", endpoint.endpoint}}), getValue(endpoint));
+            }
+         }
+      };
+
+      endpointFamily("loomis_api_requests_total", "Requests sent to the endpoint including retries",
+                     [](const ApiEndpointStats& endpoint) { return endpoint.requests; });
+      endpointFamily("loomis_api_request_errors_total", "Requests that failed to connect or got an error status",
+                     [](const ApiEndpointStats& endpoint) { return endpoint.errors; });
+      endpointFamily("loomis_api_request_retries_total", "Requests to the endpoint sent again after a transient failure",
+                     [](const ApiEndpointStats& endpoint) { return endpoint.retries; });
+      endpointFamily("loomis_api_request_sent_bytes_total", "Request body bytes sent",
+                     [](const ApiEndpointStats& endpoint) { return endpoint.bytesSent; });
+      endpointFamily("loomis_api_request_received_bytes_total", "Reply body bytes received after decompression",
+                     [](const ApiEndpointStats& endpoint) { return endpoint.bytesReceived; });
+
+      writer.Family("loomis_api_request_duration_seconds", "summary", "Request latency of the endpoint");
+      for (const auto& api : apis)
+      {
+         for (const auto& endpoint : api.endpoints)
+         {
+            for (const auto& [quantile, latency] : {std::pair{"0.5", endpoint.p50},
+                                                    std::pair{"0.9", endpoint.p90},
+                                                    std::pair{"0.99", endpoint.p99}})
+            {
+               writer.Sample("loomis_api_request_duration_seconds",
+                             GetLabels({{"api", api.className}, {"server", api.name}, {"endpoint", endpoint.endpoint}, {"quantile", quantile}}),
+                             GetSeconds(latency));
+            }
+
+            auto labels = GetLabels({{"api", api.className}, {"server", api.name}, {"endpoint", endpoint.endpoint}});
+            writer.Sample("loomis_api_request_duration_seconds_sum", labels, GetSeconds(endpoint.latencySum));
+            writer.Sample("loomis_api_request_duration_seconds_count", labels, endpoint.requests);
+         }
+      }
+
+      writer.Family("loomis_emby_path_map_items", "gauge", "Items in the Emby path map by part");
+      for (const auto& api : apis)
+      {
+         if (!api.pathMap) continue;
+         writer.Sample("loomis_emby_path_map_items", GetLabels({{"server", api.name}, {"part", "index"}}), api.pathMap->indexItems);
+         writer.Sample("loomis_emby_path_map_items", GetLabels({{"server", api.name}, {"part", "delta"}}), api.pathMap->deltaItems);
+      }
+
+      writer.Family("loomis_emby_path_map_bytes", "gauge", "Memory held by the Emby path map by part. The delta is an estimate");
+      for (const auto& api : apis)
+      {
+         if (!api.pathMap) continue;
+         writer.Sample("loomis_emby_path_map_bytes", GetLabels({{"server", api.name}, {"part", "index"}}), api.pathMap->indexBytes);
+         writer.Sample("loomis_emby_path_map_bytes", GetLabels({{"server", api.name}, {"part", "delta"}}), api.pathMap->deltaBytes);
+      }
+
+      return std::move(writer.GetText());
+   }
+
+   std::string MetricsServer::GetStatusJson() const
+   {
+      JsonStatus status;
+      status.version = std::string(LOOMIS_VERSION);
+      status.logger_queue_depth = Logger::Instance().GetQueueDepth();
+
+      for (const auto& task : cronScheduler_.GetTaskStatus())
+      {
+         status.tasks.emplace_back(JsonTaskStatus{
+            .name = task.name,
+            .cron = task.cronExpression,
+            .service = task.service,
+            .running = task.running,
+            .runs = task.runs,
+            .failures = task.failures,
+            .last_run_epoch = task.lastRun ? std::optional<int64_t>(GetEpochSeconds(*task.lastRun)) : std::nullopt,
+            .last_run_duration_seconds = GetSeconds(task.lastRunDuration),
+            .next_run_epoch = GetEpochSeconds(task.nextRun)
+         });
+      }
+
+      for (const auto& api : GetApiSnapshots(*apiManager_))
+      {
+         auto& apiStatus = status.apis.emplace_back(JsonApiStatus{
+            .api = api.className,
+            .server = api.name,
+            .online = api.health.online,
+            .failed_probes = api.health.failedProbes,
+            .last_change_epoch = GetEpochSeconds(api.health.lastChange),
+            .last_probe_epoch = GetEpochSeconds(api.health.lastProbe),
+            .replies = api.transfer.replies,
+            .compressed_replies = api.transfer.compressedReplies,
+            .body_bytes = api.transfer.bodyBytes,
+            .wire_bytes = api.transfer.wireBytes,
+            .shared_requests = api.transfer.sharedRequests,
+            .retries = api.transfer.retries,
+            .throttled_ms = api.transfer.throttledMs,
+            .cache_hits = api.cache.hits,
+            .cache_revalidated = api.cache.revalidated,
+            .cache_misses = api.cache.misses,
+            .cache_entries = api.cache.entries,
+            .path_map = std::nullopt,
+            .endpoints = {}
+         });
+
+         if (api.pathMap)
+         {
+            apiStatus.path_map = JsonPathMapStatus{
+               .index_items = api.pathMap->indexItems,
+               .index_bytes = api.pathMap->indexBytes,
+               .delta_items = api.pathMap->deltaItems,
+               .delta_bytes = api.pathMap->deltaBytes
+            };
+         }
+
+         for (const auto& endpoint : api.endpoints)
+         {
+            apiStatus.endpoints.emplace_back(JsonEndpointStatus{
+               .endpoint = endpoint.endpoint,
+               .requests = endpoint.requests,
+               .errors = endpoint.errors,
+               .retries = endpoint.retries,
+               .bytes_sent = endpoint.bytesSent,
+               .bytes_received = endpoint.bytesReceived,
+               .latency_total_seconds = GetSeconds(endpoint.latencySum),
+               .latency_p50_seconds = GetSeconds(endpoint.p50),
+               .latency_p90_seconds = GetSeconds(endpoint.p90),
+               .latency_p99_seconds = GetSeconds(endpoint.p99),
+               .latency_max_seconds = GetSeconds(endpoint.max)
+            });
+         }
+      }
+
+      auto json = glz::write_json(status);
+      if (!json)
+      {
+         Logger::Instance().Warning("Metrics Server: {} - JSON Write Error", __func__);
+         return "{}";
+      }
+      return std::move(*json);
+   }
+}
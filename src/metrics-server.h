@@ -0,0 +1,44 @@
+#pragma once
+
+#include "api/api-manager.h"
+#include "config-reader/config-reader-types.h"
+#include "cron-scheduler.h"
+
+#include <httplib.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace loomis
+{
+   // Optional http server reporting on the running process.
+   //    /metrics : Prometheus text format
+   //    /status  : the same data as JSON
+   // Every request builds a new snapshot so nothing is collected while nobody is asking.
+   class MetricsServer
+   {
+   public:
+      MetricsServer(const CronScheduler& cronScheduler, std::shared_ptr<ApiManager> apiManager);
+
+      // Ensure the listen thread is stopped before the object is destroyed
+      ~MetricsServer()
+      {
+         Shutdown();
+      }
+
+      // Returns false if the server is disabled or could not listen on the configured address
+      bool Start(const MetricsServerConfig& config);
+      void Shutdown();
+
+   private:
+      [[nodiscard]] std::string GetPrometheusMetrics() const;
+      [[nodiscard]] std::string GetStatusJson() const;
+
+      const CronScheduler& cronScheduler_;
+      std::shared_ptr<ApiManager> apiManager_;
+
+      httplib::Server server_;
+      std::unique_ptr<std::jthread> runThread_;
+   };
+}
@@ -1,84 +1,89 @@
-﻿#include "service-manager.h"
-
-#include "logger/logger.h"
-#include "logger/log-utils.h"
-#include "services/folder-cleanup/folder-cleanup-service.h"
-#include "services/playlist-sync/playlist-sync-service.h"
-#include "services/watch-state-sync/watch-state-sync-service.h"
-
-#include <algorithm>
-#include <format>
-
-namespace loomis
-{
-   ServiceManager::ServiceManager(std::shared_ptr<ConfigReader> configReader)
-      : configReader_(configReader)
-      , apiManager_(std::make_shared<ApiManager>(configReader))
-   {
-   }
-
-   void ServiceManager::CreateServices()
-   {
-      if (configReader_->GetPlaylistSyncConfig().enabled)
-      {
-         services_.emplace_back(std::make_unique<PlaylistSyncService>(configReader_->GetPlaylistSyncConfig(), apiManager_));
-      }
-
-      if (configReader_->GetWatchStateSyncConfig().enabled)
-      {
-         services_.emplace_back(std::make_unique<WatchStateSyncService>(configReader_->GetWatchStateSyncConfig(), apiManager_));
-      }
-
-      if (configReader_->GetFolderCleanupConfig().enabled)
-      {
-         services_.emplace_back(std::make_unique<FolderCleanupService>(configReader_->GetFolderCleanupConfig(), apiManager_));
-      }
-   }
-
-   void ServiceManager::Run()
-   {
-      CreateServices();
-
-      if (services_.empty())
-      {
-         Logger::Instance().Critical("No services are enabled in the configuration.");
-         return;
-      }
-
-      // Add any needed api tasks
-      apiManager_->AddTasks(cronScheduler_);
-
-      // Services are required to have tasks so add
-      for (const auto& service : services_)
-      {
-         cronScheduler_.Add(service->GetTask());
-      }
-
-      // If the scheduler successfully started hold the run thread. If not no work to do.
-      if (cronScheduler_.Start())
-      {
-         // Hold the main thread until shutdown is requested
-         std::unique_lock<std::mutex> cvUniqueLock(runCvLock_);
-         runCv_.wait(cvUniqueLock, [this] { return shutdownService_.load(); });
-      }
-      else
-      {
-         Logger::Instance().Critical("No enabled services");
-      }
-
-      Logger::Instance().Info("Run has completed");
-   }
-
-   void ServiceManager::ProcessShutdown()
-   {
-      Logger::Instance().Info("Shutdown request received");
-
-      cronScheduler_.Shutdown();
-
-      {
-         std::unique_lock<std::mutex> cvUniqueLock(runCvLock_);
-         shutdownService_.store(true);
-         runCv_.notify_all();
-      }
-   }
+﻿#include "service-manager.h"
+
+#include "logger/logger.h"
+#include "logger/log-utils.h"
+#include "services/folder-cleanup/folder-cleanup-service.h"
+#include "services/playlist-sync/playlist-sync-service.h"
+#include "services/watch-state-sync/watch-state-sync-service.h"
+
+#include <algorithm>
+#include <format>
+
+namespace loomis
+{
+   ServiceManager::ServiceManager(std::shared_ptr<ConfigReader> configReader)
+      : configReader_(configReader)
+      , apiManager_(std::make_shared<ApiManager>(configReader))
+      , metricsServer_(cronScheduler_, apiManager_)
+   {
+   }
+
+   void ServiceManager::CreateServices()
+   {
+      if (configReader_->GetPlaylistSyncConfig().enabled)
+      {
+         services_.emplace_back(std::make_unique<PlaylistSyncService>(configReader_->GetPlaylistSyncConfig(), apiManager_));
+      }
+
+      if (configReader_->GetWatchStateSyncConfig().enabled)
+      {
+         services_.emplace_back(std::make_unique<WatchStateSyncService>(configReader_->GetWatchStateSyncConfig(), apiManager_));
+      }
+
+      if (configReader_->GetFolderCleanupConfig().enabled)
+      {
+         services_.emplace_back(std::make_unique<FolderCleanupService>(configReader_->GetFolderCleanupConfig(), apiManager_));
+      }
+   }
+
+   void ServiceManager::Run()
+   {
+      CreateServices();
+
+      if (services_.empty())
+      {
+         Logger::Instance().Critical("No services are enabled in the configuration.");
+         return;
+      }
+
+      // Add any needed api tasks
+      apiManager_->AddTasks(cronScheduler_);
+
+      // Services are required to have tasks so add
+      for (const auto& service : services_)
+      {
+         cronScheduler_.Add(service->GetTask());
+      }
+
+      // If the scheduler successfully started hold the run thread. If not no work to do.
+      if (cronScheduler_.Start())
+      {
+         metricsServer_.Start(configReader_->GetMetricsServerConfig());
+
+         // Hold the main thread until shutdown is requested
+         std::unique_lock<std::mutex> cvUniqueLock(runCvLock_);
+         runCv_.wait(cvUniqueLock, [this] { return shutdownService_.load(); });
+      }
+      else
+      {
+         Logger::Instance().Critical("No enabled services");
+      }
+
+      Logger::Instance().Info("Run has completed");
+   }
+
+   void ServiceManager::ProcessShutdown()
+   {
+      Logger::Instance().Info("Shutdown request received");
+
+      metricsServer_.Shutdown();
+
+      cronScheduler_.Shutdown();
+
+      {
+         std::unique_lock<std::mutex> cvUniqueLock(runCvLock_);
+         shutdownService_.store(true);
+         runCv_.notify_all();
+      }
+   }
 }
\ No newline at end of file
@@ -1,37 +1,41 @@
-#pragma once
-
-#include "api/api-manager.h"
-#include "config-reader/config-reader-types.h"
-#include "services/service-base.h"
-
-#include <atomic>
-#include <cstdint>
-#include <memory>
-#include <mutex>
-#include <vector>
-
-namespace loomis
-{
-   class PlaylistSyncService : public ServiceBase
-   {
-   public:
-      PlaylistSyncService(const PlaylistSyncConfig& config,
-                          std::shared_ptr<ApiManager> apiManager);
-      virtual ~PlaylistSyncService() = default;
-
-      void Run() override;
-
-   private:
-      void Init(const PlaylistSyncConfig& config);
-
-      // Returns added then deleted item numbers in the pair
-      std::pair<size_t, size_t> AddRemoveEmbyPlaylistItems(EmbyApi* embyApi, const EmbyPlaylist& currentPlaylist, const std::vector<std::string>& updatedPlaylistIds);
-      void UpdateEmbyPlaylist(PlexApi* plexApi, EmbyApi* embyApi, EmbyPlaylist embyPlaylist, const std::vector<std::string>& correctIds);
-      void SyncEmbyPlaylist(PlexApi* plexApi, EmbyApi* embyApi, const PlexCollection& plexCollection);
-      void SyncPlexCollection(PlexApi* plexApi, EmbyApi* embyApi, const PlaylistPlexCollection& collection);
-
-      uint32_t timeForEmbyUpdateSec_{1u};
-      uint32_t timeBetweenSyncsSec_{1u};
-      std::vector<PlaylistPlexCollection> plexCollections_;
-   };
+#pragma once
+
+#include "api/api-manager.h"
+#include "config-reader/config-reader-types.h"
+#include "services/service-base.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace loomis
+{
+   class PlaylistSyncService : public ServiceBase
+   {
+   public:
+      PlaylistSyncService(const PlaylistSyncConfig& config,
+                          std::shared_ptr<ApiManager> apiManager);
+      virtual ~PlaylistSyncService() = default;
+
+      void Run() override;
+
+   private:
+      void Init(const PlaylistSyncConfig& config);
+
+      // Returns added then deleted item numbers in the pair
+      std::pair<size_t, size_t> AddRemoveEmbyPlaylistItems(EmbyApi* embyApi, const EmbyPlaylist& currentPlaylist, const std::vector<std::string>& updatedPlaylistIds);
+      // Re-reads the playlist until it has the expected length or the update time runs out
+      std::optional<EmbyPlaylist> WaitForEmbyPlaylist(EmbyApi* embyApi, std::string_view name, size_t expectedSize);
+      void UpdateEmbyPlaylist(PlexApi* plexApi, EmbyApi* embyApi, EmbyPlaylist embyPlaylist, const std::vector<std::string>& correctIds);
+      void SyncEmbyPlaylist(PlexApi* plexApi, EmbyApi* embyApi, const PlexCollection& plexCollection);
+      void SyncPlexCollection(PlexApi* plexApi, EmbyApi* embyApi, const PlaylistPlexCollection& collection);
+
+      uint32_t timeForEmbyUpdateSec_{1u};
+      uint32_t timeBetweenSyncsSec_{1u};
+      std::vector<PlaylistPlexCollection> plexCollections_;
+   };
 }
\ No newline at end of file
@@ -1,34 +1,46 @@
-﻿#include "service-base.h"
-
-#include "logger/logger.h"
-#include "logger/log-utils.h"
-
-#include <chrono>
-#include <format>
-#include <ranges>
-
-namespace loomis
-{
-   ServiceBase::ServiceBase(std::string_view name,
-                            std::string_view ansiiColor,
-                            std::shared_ptr<ApiManager> apiManager,
-                            const std::string& cronSchedule)
-      : Base(name, ansiiColor, std::nullopt)
-      , apiManager_(apiManager)
-   {
-      task_.service = true;
-      task_.name = log::GetAnsiText(name, ansiiColor);
-      task_.cronExpression = cronSchedule;
-      task_.func = [this]() { this->Run(); };
-   }
-
-   const Task& ServiceBase::GetTask() const
-   {
-      return task_;
-   }
-
-   const std::shared_ptr<ApiManager> ServiceBase::GetApiManager() const
-   {
-      return apiManager_;
-   }
+﻿#include "service-base.h"
+
+#include "api/api-retry-policy.h"
+#include "logger/logger.h"
+#include "logger/log-utils.h"
+
+#include <chrono>
+#include <format>
+#include <ranges>
+
+namespace loomis
+{
+   namespace
+   {
+      // Failed requests are retried until the run has taken this long. After that each request is sent once
+      // so a slow or flapping server can not stretch a run into a long chain of timeouts.
+      constexpr auto RUN_RETRY_DEADLINE{std::chrono::minutes(15)};
+   }
+
+   ServiceBase::ServiceBase(std::string_view name,
+                            std::string_view ansiiColor,
+                            std::shared_ptr<ApiManager> apiManager,
+                            const std::string& cronSchedule)
+      : Base(name, ansiiColor, std::nullopt)
+      , apiManager_(apiManager)
+   {
+      task_.service = true;
+      task_.name = log::GetAnsiText(name, ansiiColor);
+      task_.plainName = name;
+      task_.cronExpression = cronSchedule;
+      task_.func = [this]() {
+         ApiDeadlineScope deadline(RUN_RETRY_DEADLINE);
+         this->Run();
+      };
+   }
+
+   const Task& ServiceBase::GetTask() const
+   {
+      return task_;
+   }
+
+   const std::shared_ptr<ApiManager> ServiceBase::GetApiManager() const
+   {
+      return apiManager_;
+   }
 }
\ No newline at end of file
@@ -1,170 +1,376 @@
-﻿#include "emby-user.h"
-
-#include "logger/log-utils.h"
-#include "services/service-utils.h"
-
-namespace loomis
-{
-   namespace
-   {
-      constexpr int32_t playbackPercentageThreshold{99};
-   }
-
-   EmbyUser::EmbyUser(const ServerUser& config,
-                      const std::shared_ptr<ApiManager>& apiManager,
-                      WatchStateLogger logger)
-      : logger_(logger)
-      , config_(config)
-      , typeServerName_(log::GetServerName(log::GetFormattedEmby(), config_.server))
-   {
-      // Do some quick checking on the users and make sure the api in the config exists.
-      // Don't want to check if the user is valid on the api yet since it might be offline.
-      // This will be checked every run frame.
-      embyApi_ = apiManager->GetEmbyApi(config_.server);
-      jellystatApi_ = apiManager->GetJellystatApi(config_.server);
-      if (embyApi_ && jellystatApi_)
-      {
-         // Will get users from emby. Do a small pre-check and warn the system.
-         if (embyApi_->GetValid() && !embyApi_->GetUser(config_.user_name))
-         {
-            logger_.LogWarning("{} not found on {}. Is user name correct?",
-                               log::GetTag("user", config_.user_name),
-                               typeServerName_);
-         }
-
-         valid_ = true;
-      }
-      else
-      {
-         if (!embyApi_)
-         {
-            logger_.LogWarning("{} api not found for {}",
-                               typeServerName_,
-                               log::GetTag("user", config_.user_name));
-         }
-
-         if (!jellystatApi_)
-         {
-            logger_.LogWarning("{} tracker api not found for {}. Required for this service.",
-                               log::GetServerName(log::GetFormattedJellystat(), config_.server),
-                               log::GetTag("user", config_.user_name));
-         }
-      }
-   }
-
-   bool EmbyUser::GetValid() const
-   {
-      return valid_;
-   }
-
-   std::string EmbyUser::GetServerAndUserName() const
-   {
-      return typeServerName_ + ":" + config_.user_name;
-   }
-
-   std::string_view EmbyUser::GetServerName() const
-   {
-      return config_.server;
-   }
-
-   std::string_view EmbyUser::GetTypeAndServerName() const
-   {
-      return typeServerName_;
-   }
-
-   std::string_view EmbyUser::GetUser() const
-   {
-      return config_.user_name;
-   }
-
-   const std::string& EmbyUser::GetMediaPath() const
-   {
-      return embyApi_->GetMediaPath();
-   }
-
-   std::optional<EmbyPlayState> EmbyUser::GetPlayState(std::string_view id)
-   {
-      return embyApi_->GetPlayState(userId_, id);
-   }
-
-   void EmbyUser::Update()
-   {
-      auto user = embyApi_->GetUser(config_.user_name);
-      valid_ = user.has_value();
-      if (valid_) userId_ = std::move(user->id);
-   }
-
-   std::optional<JellystatHistoryItems> EmbyUser::GetWatchHistory()
-   {
-      return jellystatApi_->GetWatchHistoryForUser(userId_);
-   }
-
-   bool EmbyUser::SyncPlexWatchedState(const std::string& plexPath)
-   {
-      auto id = embyApi_->GetIdFromPathMap(plexPath);
-      if (!id) return false;
-
-      // If this item is already watched just return
-      if (embyApi_->GetWatchedStatus(userId_, *id)) return false;
-
-      embyApi_->SetWatchedStatus(userId_, *id);
-
-      return true;
-   }
-
-   bool EmbyUser::SyncPlexPlayState(const PlexSyncState& syncState)
-   {
-      auto id = embyApi_->GetIdFromPathMap(syncState.path);
-      if (!id) return false;
-
-      auto playState = embyApi_->GetPlayState(userId_, *id);
-      if (!playState || syncState.playbackPercentage == std::lround(playState->percentage)) return false;
-
-      int64_t tickLocation = std::llround(static_cast<double>(playState->runTimeTicks) * (static_cast<double>(syncState.playbackPercentage) / 100.0));
-      if (tickLocation == playState->runTimeTicks)
-      {
-         return SyncPlexWatchedState(syncState.path);
-      }
-
-      auto timeString = GetIsoTimeStr(std::chrono::sys_time<std::chrono::seconds>{std::chrono::seconds{syncState.timeWatchedEpoch}});
-      return embyApi_->SetPlayState(userId_, *id, tickLocation, timeString);
-   }
-
-   void EmbyUser::SyncStateWithPlex(const PlexSyncState& syncState, std::string& syncResults)
-   {
-      bool forceWatched = syncState.watched || syncState.playbackPercentage >= playbackPercentageThreshold;
-      bool success = forceWatched ? SyncPlexWatchedState(syncState.path) : SyncPlexPlayState(syncState);
-      if (success)
-      {
-         syncResults = log::BuildSyncServerString(syncResults, log::GetFormattedEmby(), config_.server);
-      }
-   }
-
-   bool EmbyUser::SyncEmbyWatchedState(std::string_view id)
-   {
-      if (embyApi_->GetWatchedStatus(userId_, id)) return false;
-      return embyApi_->SetWatchedStatus(userId_, id);
-   }
-
-   bool EmbyUser::SyncEmbyPlayState(const EmbySyncState& syncState, std::string_view id)
-   {
-      auto playState = embyApi_->GetPlayState(userId_, id);
-      if (!playState || syncState.playbackPercentage == std::lround(playState->percentage)) return false;
-
-      int64_t tickLocation = std::llround(static_cast<double>(playState->runTimeTicks) * (static_cast<double>(syncState.playbackPercentage) / 100.0));
-      return embyApi_->SetPlayState(userId_, id, tickLocation, syncState.timeWatched);
-   }
-
-   void EmbyUser::SyncStateWithEmby(const EmbySyncState& syncState, std::string& syncResults)
-   {
-      auto id = embyApi_->GetIdFromPathMap(ReplaceMediaPath(syncState.path, syncState.mediaPath, GetMediaPath()));
-      if (!id) return;
-
-      bool forceWatched = syncState.watched || syncState.playbackPercentage >= playbackPercentageThreshold;
-      bool success = forceWatched ? SyncEmbyWatchedState(*id) : SyncEmbyPlayState(syncState, *id);
-      if (success)
-      {
-         syncResults = log::BuildSyncServerString(syncResults, log::GetFormattedEmby(), config_.server);
-      }
-   }
+﻿#include "emby-user.h"
+
+#include "logger/log-utils.h"
+#include "services/service-utils.h"
+
+#include <algorithm>
+#include <format>
+#include <ranges>
+
+namespace loomis
+{
+   namespace
+   {
+      constexpr int32_t playbackPercentageThreshold{99};
+
+      constexpr auto watchStateFullLoadInterval{std::chrono::hours(24)};
+
+      // Refreshes ask for a little before the last refresh so plays saved while it ran are not missed
+      constexpr auto watchStateRefreshOverlap{std::chrono::minutes(5)};
+
+      EmbyWatchState ToWatchState(const EmbyPlayState& playState)
+      {
+         return EmbyWatchState{.runTimeTicks = playState.runTimeTicks,
+                               .playbackPositionTicks = playState.playbackPositionTicks,
+                               .percentage = playState.percentage,
+                               .played = playState.played};
+      }
+   }
+
+   EmbyUser::EmbyUser(const ServerUser& config,
+                      const std::shared_ptr<ApiManager>& apiManager,
+                      WatchStateLogger logger,
+                      std::string_view syncGroup)
+      : logger_(logger)
+      , config_(config)
+      , typeServerName_(log::GetServerName(log::GetFormattedEmby(), config_.server))
+      , historyKey_(std::format("{}>{}", config_.user_name, syncGroup))
+   {
+      // Do some quick checking on the users and make sure the api in the config exists.
+      // Don't want to check if the user is valid on the api yet since it might be offline.
+      // This will be checked every run frame.
+      embyApi_ = apiManager->GetEmbyApi(config_.server);
+      jellystatApi_ = apiManager->GetJellystatApi(config_.server);
+      if (embyApi_ && jellystatApi_)
+      {
+         // Will get users from emby. Do a small pre-check and warn the system.
+         if (embyApi_->GetValid() && !embyApi_->GetUser(config_.user_name))
+         {
+            logger_.LogWarning("{} not found on {}. Is user name correct?",
+                               log::GetTag("user", config_.user_name),
+                               typeServerName_);
+         }
+
+         valid_ = true;
+      }
+      else
+      {
+         if (!embyApi_)
+         {
+            logger_.LogWarning("{} api not found for {}",
+                               typeServerName_,
+                               log::GetTag("user", config_.user_name));
+         }
+
+         if (!jellystatApi_)
+         {
+            logger_.LogWarning("{} tracker api not found for {}. Required for this service.",
+                               log::GetServerName(log::GetFormattedJellystat(), config_.server),
+                               log::GetTag("user", config_.user_name));
+         }
+      }
+   }
+
+   bool EmbyUser::GetValid() const
+   {
+      return valid_;
+   }
+
+   std::string EmbyUser::GetServerAndUserName() const
+   {
+      return typeServerName_ + ":" + config_.user_name;
+   }
+
+   std::string_view EmbyUser::GetServerName() const
+   {
+      return config_.server;
+   }
+
+   std::string_view EmbyUser::GetTypeAndServerName() const
+   {
+      return typeServerName_;
+   }
+
+   std::string_view EmbyUser::GetUser() const
+   {
+      return config_.user_name;
+   }
+
+   const std::string& EmbyUser::GetMediaPath() const
+   {
+      return embyApi_->GetMediaPath();
+   }
+
+   std::optional<EmbyPlayState> EmbyUser::GetPlayState(const std::string& id)
+   {
+      if (auto iter = playStates_.find(id); iter != playStates_.end()) return iter->second;
+
+      // Not part of a batch so fall back to asking for the single item
+      auto playState = embyApi_->GetPlayState(userId_, id);
+      if (playState) playStates_.insert_or_assign(id, *playState);
+      return playState;
+   }
+
+   void EmbyUser::LoadPlayStates(std::span<const std::string> ids)
+   {
+      std::vector<std::string> missingIds;
+      for (const auto& id : ids)
+      {
+         if (!playStates_.contains(id)) missingIds.emplace_back(id);
+      }
+
+      // Remove duplicates so each item is only requested once
+      std::ranges::sort(missingIds);
+      auto [newEnd, _] = std::ranges::unique(missingIds);
+      missingIds.erase(newEnd, missingIds.end());
+      if (missingIds.empty()) return;
+
+      playStates_.merge(embyApi_->GetPlayStates(userId_, missingIds));
+   }
+
+   void EmbyUser::LoadPlayStatesForPaths(std::span<const std::string> paths)
+   {
+      std::vector<std::string> ids;
+      for (auto& id : embyApi_->GetIdsFromPathMap(paths))
+      {
+         // Items in the watch state table are answered locally
+         if (id && !watchStates_.contains(*id)) ids.emplace_back(std::move(*id));
+      }
+      LoadPlayStates(ids);
+   }
+
+   void EmbyUser::LoadPlayStatesForPlex(std::span<const PlexSyncState> syncStates)
+   {
+      std::vector<std::string> paths;
+      paths.reserve(syncStates.size());
+      for (const auto& syncState : syncStates)
+      {
+         // With the table loaded the server is only needed for the run time of unplayed items getting a play state
+         bool forceWatched = syncState.watched || syncState.playbackPercentage >= playbackPercentageThreshold;
+         if (!watchStatesLoaded_ || !forceWatched) paths.emplace_back(syncState.path);
+      }
+      LoadPlayStatesForPaths(paths);
+   }
+
+   void EmbyUser::LoadPlayStatesForEmby(std::span<const EmbySyncState> syncStates)
+   {
+      std::vector<std::string> paths;
+      paths.reserve(syncStates.size());
+      for (const auto& syncState : syncStates)
+      {
+         bool forceWatched = syncState.watched || syncState.playbackPercentage >= playbackPercentageThreshold;
+         if (!watchStatesLoaded_ || !forceWatched) paths.emplace_back(ReplaceMediaPath(syncState.path, syncState.mediaPath, GetMediaPath()));
+      }
+      LoadPlayStatesForPaths(paths);
+   }
+
+   void EmbyUser::RefreshWatchStates()
+   {
+      auto now = std::chrono::system_clock::now();
+      bool fullLoad = !watchStatesLoaded_ || (now - watchStatesFullLoadTime_) >= watchStateFullLoadInterval;
+
+      auto watchStates = embyApi_->GetWatchStates(userId_, fullLoad ? std::string{} : watchStatesSyncTime_);
+      if (!watchStates)
+      {
+         // Fall back to asking the server per batch until a refresh works
+         watchStates_.clear();
+         watchStatesLoaded_ = false;
+         return;
+      }
+
+      if (fullLoad)
+      {
+         watchStates_ = std::move(*watchStates);
+         watchStatesFullLoadTime_ = now;
+      }
+      else
+      {
+         // Items marked unplayed or with their resume point cleared are in the changes too and leave the table
+         for (auto& [id, watchState] : *watchStates)
+         {
+            if (watchState.played || watchState.playbackPositionTicks > 0) watchStates_.insert_or_assign(id, watchState);
+            else watchStates_.erase(id);
+         }
+      }
+
+      watchStatesLoaded_ = true;
+      watchStatesSyncTime_ = GetIsoTimeStr(now - watchStateRefreshOverlap);
+   }
+
+   std::optional<EmbyWatchState> EmbyUser::GetWatchState(const std::string& id, bool needRunTime)
+   {
+      if (auto iter = playStates_.find(id); iter != playStates_.end()) return ToWatchState(iter->second);
+
+      if (watchStatesLoaded_)
+      {
+         if (auto iter = watchStates_.find(id); iter != watchStates_.end()) return iter->second;
+
+         // Not played and not in progress
+         if (!needRunTime) return EmbyWatchState{};
+      }
+
+      auto playState = GetPlayState(id);
+      if (!playState) return std::nullopt;
+      return ToWatchState(*playState);
+   }
+
+   void EmbyUser::Update()
+   {
+      playStates_.clear();
+
+      // The user lookup is cached and keeps old entries when a load fails so check the server as well
+      valid_ = embyApi_->GetValid();
+      if (!valid_) return;
+
+      auto user = embyApi_->GetUser(config_.user_name);
+      valid_ = user.has_value();
+      if (!valid_) return;
+
+      // A different user id means a different user so start the table over
+      if (userId_ != user->id) watchStatesLoaded_ = false;
+      userId_ = std::move(user->id);
+
+      RefreshWatchStates();
+   }
+
+   std::optional<JellystatHistoryItems> EmbyUser::GetWatchHistory(std::string_view minWatchTime)
+   {
+      return jellystatApi_->GetWatchHistoryForUser(userId_, minWatchTime, jellystatApi_->GetHistoryWatermark(historyKey_));
+   }
+
+   std::future<std::optional<JellystatHistoryItems>> EmbyUser::GetWatchHistoryAsync(std::string_view minWatchTime)
+   {
+      return jellystatApi_->GetWatchHistoryForUserAsync(userId_, minWatchTime, jellystatApi_->GetHistoryWatermark(historyKey_));
+   }
+
+   void EmbyUser::SetHistorySynced(const JellystatHistoryWatermark& watermark)
+   {
+      jellystatApi_->SetHistoryWatermark(historyKey_, watermark);
+   }
+
+   bool EmbyUser::SetWatched(const std::string& id)
+   {
+      if (!embyApi_->SetWatchedStatus(userId_, id)) return false;
+
+      auto markWatched = [](auto& state) {
+         state.played = true;
+         state.percentage = 0.0f;
+         state.playbackPositionTicks = 0;
+      };
+
+      if (auto iter = playStates_.find(id); iter != playStates_.end()) markWatched(iter->second);
+      if (watchStatesLoaded_) markWatched(watchStates_[id]);
+      return true;
+   }
+
+   bool EmbyUser::SetPlayState(const std::string& id, const EmbyWatchState& watchState, int64_t positionTicks, std::string_view dateTimeStr)
+   {
+      if (!embyApi_->SetPlayState(userId_, id, positionTicks, dateTimeStr)) return false;
+
+      auto percentage = watchState.runTimeTicks > 0 ? static_cast<float>(static_cast<double>(positionTicks) * 100.0 / static_cast<double>(watchState.runTimeTicks)) : 0.0f;
+      auto updatePosition = [&](auto& state) {
+         state.runTimeTicks = watchState.runTimeTicks;
+         state.playbackPositionTicks = positionTicks;
+         state.percentage = percentage;
+      };
+
+      if (auto iter = playStates_.find(id); iter != playStates_.end()) updatePosition(iter->second);
+      if (watchStatesLoaded_) updatePosition(watchStates_[id]);
+      return true;
+   }
+
+   SyncResult EmbyUser::GetPathMissResult() const
+   {
+      // Until the path map is built a miss says nothing about the library
+      return embyApi_->GetPathMapEmpty() ? SyncResult::failed : SyncResult::missing;
+   }
+
+   SyncResult EmbyUser::SyncPlexWatchedState(const std::string& plexPath)
+   {
+      auto id = embyApi_->GetIdFromPathMap(plexPath);
+      if (!id) return GetPathMissResult();
+
+      // If this item is already watched just return
+      auto watchState = GetWatchState(*id, false);
+      if (!watchState) return SyncResult::failed;
+      if (watchState->played) return SyncResult::unchanged;
+
+      return SetWatched(*id) ? SyncResult::synced : SyncResult::failed;
+   }
+
+   SyncResult EmbyUser::SyncPlexPlayState(const PlexSyncState& syncState)
+   {
+      auto id = embyApi_->GetIdFromPathMap(syncState.path);
+      if (!id) return GetPathMissResult();
+
+      auto watchState = GetWatchState(*id, false);
+      if (!watchState) return SyncResult::failed;
+      if (syncState.playbackPercentage == std::lround(watchState->percentage)) return SyncResult::unchanged;
+
+      // There is a difference so the run time is needed to work out the position
+      if (watchState->runTimeTicks == 0)
+      {
+         watchState = GetWatchState(*id, true);
+         if (!watchState) return SyncResult::failed;
+      }
+
+      int64_t tickLocation = std::llround(static_cast<double>(watchState->runTimeTicks) * (static_cast<double>(syncState.playbackPercentage) / 100.0));
+      if (tickLocation == watchState->runTimeTicks)
+      {
+         return SyncPlexWatchedState(syncState.path);
+      }
+
+      auto timeString = GetIsoTimeStr(std::chrono::sys_time<std::chrono::seconds>{std::chrono::seconds{syncState.timeWatchedEpoch}});
+      return SetPlayState(*id, *watchState, tickLocation, timeString) ? SyncResult::synced : SyncResult::failed;
+   }
+
+   bool EmbyUser::SyncStateWithPlex(const PlexSyncState& syncState, std::string& syncResults)
+   {
+      bool forceWatched = syncState.watched || syncState.playbackPercentage >= playbackPercentageThreshold;
+      auto result = forceWatched ? SyncPlexWatchedState(syncState.path) : SyncPlexPlayState(syncState);
+      if (result == SyncResult::synced)
+      {
+         syncResults = log::BuildSyncServerString(syncResults, log::GetFormattedEmby(), config_.server);
+      }
+      return result != SyncResult::failed;
+   }
+
+   SyncResult EmbyUser::SyncEmbyWatchedState(const std::string& id)
+   {
+      auto watchState = GetWatchState(id, false);
+      if (!watchState) return SyncResult::failed;
+      if (watchState->played) return SyncResult::unchanged;
+
+      return SetWatched(id) ? SyncResult::synced : SyncResult::failed;
+   }
+
+   SyncResult EmbyUser::SyncEmbyPlayState(const EmbySyncState& syncState, const std::string& id)
+   {
+      auto watchState = GetWatchState(id, false);
+      if (!watchState) return SyncResult::failed;
+      if (syncState.playbackPercentage == std::lround(watchState->percentage)) return SyncResult::unchanged;
+
+      if (watchState->runTimeTicks == 0)
+      {
+         watchState = GetWatchState(id, true);
+         if (!watchState) return SyncResult::failed;
+      }
+
+      int64_t tickLocation = std::llround(static_cast<double>(watchState->runTimeTicks) * (static_cast<double>(syncState.playbackPercentage) / 100.0));
+      return SetPlayState(id, *watchState, tickLocation, syncState.timeWatched) ? SyncResult::synced : SyncResult::failed;
+   }
+
+   bool EmbyUser::SyncStateWithEmby(const EmbySyncState& syncState, std::string& syncResults)
+   {
+      auto id = embyApi_->GetIdFromPathMap(ReplaceMediaPath(syncState.path, syncState.mediaPath, GetMediaPath()));
+      if (!id) return GetPathMissResult() != SyncResult::failed;
+
+      bool forceWatched = syncState.watched || syncState.playbackPercentage >= playbackPercentageThreshold;
+      auto result = forceWatched ? SyncEmbyWatchedState(*id) : SyncEmbyPlayState(syncState, *id);
+      if (result == SyncResult::synced)
+      {
+         syncResults = log::BuildSyncServerString(syncResults, log::GetFormattedEmby(), config_.server);
+      }
+      return result != SyncResult::failed;
+   }
 }
\ No newline at end of file
@@ -1,70 +1,117 @@
-#pragma once
-
-#include "api/api-emby.h"
-#include "api/api-jellystat.h"
-#include "api/api-manager.h"
-#include "api/api-tautulli-types.h"
-#include "config-reader/config-reader-types.h"
-#include "services/watch-state-sync/watch-state-logger.h"
-#include "types.h"
-
-#include <chrono>
-#include <functional>
-
-namespace loomis
-{
-   class EmbyUser
-   {
-   public:
-      EmbyUser(const ServerUser& config,
-               const std::shared_ptr<ApiManager>& apiManager,
-               WatchStateLogger logger);
-      virtual ~EmbyUser() = default;
-
-      [[nodiscard]] bool GetValid() const;
-      [[nodiscard]] std::string GetServerAndUserName() const;
-      [[nodiscard]] std::string_view GetServerName() const;
-      [[nodiscard]] std::string_view GetTypeAndServerName() const;
-      [[nodiscard]] std::string_view GetUser() const;
-      [[nodiscard]] const std::string& GetMediaPath() const;
-      [[nodiscard]] std::optional<JellystatHistoryItems> GetWatchHistory();
-      [[nodiscard]] std::optional<EmbyPlayState> GetPlayState(std::string_view id);
-
-      void Update();
-
-      struct PlexSyncState
-      {
-         const std::string& path;
-         bool watched{false};
-         int32_t playbackPercentage{0};
-         int64_t timeWatchedEpoch{0};
-      };
-      void SyncStateWithPlex(const PlexSyncState& syncState, std::string& syncResults);
-
-      struct EmbySyncState
-      {
-         const std::string& mediaPath;
-         const std::string& path;
-         bool watched{false};
-         int32_t playbackPercentage{0};
-         const std::string& timeWatched;
-      };
-      void SyncStateWithEmby(const EmbySyncState& syncState, std::string& syncResults);
-
-   private:
-      bool SyncPlexWatchedState(const std::string& plexPath);
-      bool SyncPlexPlayState(const PlexSyncState& syncState);
-
-      bool SyncEmbyWatchedState(std::string_view id);
-      bool SyncEmbyPlayState(const EmbySyncState& syncState, std::string_view id);
-
-      bool valid_{false};
-      WatchStateLogger logger_;
-      ServerUser config_;
-      std::string userId_;
-      std::string typeServerName_;
-
-      EmbyApi* embyApi_{nullptr};
-      JellystatApi* jellystatApi_{nullptr};
-   };
+#pragma once
+
+#include "api/api-emby.h"
+#include "api/api-jellystat.h"
+#include "api/api-manager.h"
+#include "api/api-tautulli-types.h"
+#include "config-reader/config-reader-types.h"
+#include "services/watch-state-sync/watch-state-logger.h"
+#include "services/watch-state-sync/watch-state-types.h"
+#include "types.h"
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace loomis
+{
+   class EmbyUser
+   {
+   public:
+      // The sync group names the users this user is synced with so each group keeps its own history watermark
+      EmbyUser(const ServerUser& config,
+               const std::shared_ptr<ApiManager>& apiManager,
+               WatchStateLogger logger,
+               std::string_view syncGroup);
+      virtual ~EmbyUser() = default;
+
+      [[nodiscard]] bool GetValid() const;
+      [[nodiscard]] std::string GetServerAndUserName() const;
+      [[nodiscard]] std::string_view GetServerName() const;
+      [[nodiscard]] std::string_view GetTypeAndServerName() const;
+      [[nodiscard]] std::string_view GetUser() const;
+      [[nodiscard]] const std::string& GetMediaPath() const;
+      // Only the history since the time and after the last synced row is returned
+      [[nodiscard]] std::optional<JellystatHistoryItems> GetWatchHistory(std::string_view minWatchTime);
+      [[nodiscard]] std::future<std::optional<JellystatHistoryItems>> GetWatchHistoryAsync(std::string_view minWatchTime);
+
+      // Moves the watermark to the row so the next run only reads newer rows
+      void SetHistorySynced(const JellystatHistoryWatermark& watermark);
+      [[nodiscard]] std::optional<EmbyPlayState> GetPlayState(const std::string& id);
+
+      // Fetches the play state of all the ids in one batch for the rest of the run
+      void LoadPlayStates(std::span<const std::string> ids);
+
+      void Update();
+
+      struct PlexSyncState
+      {
+         const std::string& path;
+         bool watched{false};
+         int32_t playbackPercentage{0};
+         int64_t timeWatchedEpoch{0};
+      };
+      // Returns false if the row could not be synced to this user
+      bool SyncStateWithPlex(const PlexSyncState& syncState, std::string& syncResults);
+
+      // Batch loads the play state of every item a run will sync so each sync does not query the server
+      void LoadPlayStatesForPlex(std::span<const PlexSyncState> syncStates);
+
+      struct EmbySyncState
+      {
+         const std::string& mediaPath;
+         const std::string& path;
+         bool watched{false};
+         int32_t playbackPercentage{0};
+         const std::string& timeWatched;
+      };
+      // Returns false if the row could not be synced to this user
+      bool SyncStateWithEmby(const EmbySyncState& syncState, std::string& syncResults);
+      void LoadPlayStatesForEmby(std::span<const EmbySyncState> syncStates);
+
+   private:
+      void LoadPlayStatesForPaths(std::span<const std::string> paths);
+
+      // Brings the local watch state table up to date with what was played since the last refresh
+      void RefreshWatchStates();
+
+      // Returns what the user has for the item, from the local table when it is loaded.
+      // If a run time is needed and the item is unplayed the server is asked for it.
+      [[nodiscard]] std::optional<EmbyWatchState> GetWatchState(const std::string& id, bool needRunTime);
+
+      SyncResult SyncPlexWatchedState(const std::string& plexPath);
+      SyncResult SyncPlexPlayState(const PlexSyncState& syncState);
+
+      // Result for an item whose path is not in the path map
+      [[nodiscard]] SyncResult GetPathMissResult() const;
+      SyncResult SyncEmbyWatchedState(const std::string& id);
+      SyncResult SyncEmbyPlayState(const EmbySyncState& syncState, const std::string& id);
+
+      bool SetWatched(const std::string& id);
+      bool SetPlayState(const std::string& id, const EmbyWatchState& watchState, int64_t positionTicks, std::string_view dateTimeStr);
+
+      bool valid_{false};
+      WatchStateLogger logger_;
+      ServerUser config_;
+      std::string userId_;
+      std::string typeServerName_;
+      std::string historyKey_;
+
+      // Play states fetched this run. Cleared on update and kept in step with the writes made.
+      EmbyPlayStates playStates_;
+
+      // Every played or in progress item of the user. Items not in the table are unplayed.
+      // Refreshed each run with the items whose user data was saved since the last refresh, which drops items
+      // marked unplayed, and fully reloaded once a day in case a change was missed.
+      EmbyWatchStates watchStates_;
+      bool watchStatesLoaded_{false};
+      std::string watchStatesSyncTime_;
+      std::chrono::system_clock::time_point watchStatesFullLoadTime_;
+
+      EmbyApi* embyApi_{nullptr};
+      JellystatApi* jellystatApi_{nullptr};
+   };
 }
\ No newline at end of file
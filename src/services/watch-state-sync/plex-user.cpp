@@ -1,138 +1,202 @@
-﻿#include "plex-user.h"
-
-#include "logger/log-utils.h"
-#include "services/service-utils.h"
-
-namespace loomis
-{
-   PlexUser::PlexUser(const ServerUser& config,
-                      const std::shared_ptr<ApiManager>& apiManager,
-                      WatchStateLogger logger)
-      : logger_(logger)
-      , config_(config)
-      , typeServerName_(log::GetServerName(log::GetFormattedPlex(), config_.server))
-   {
-      // Do some quick checking on the users and make sure the api in the config exists.
-      // Don't want to check if the user is valid on the api yet since it might be offline.
-      // This will be checked every run frame.
-      api_ = apiManager->GetPlexApi(config_.server);
-      trackerApi_ = apiManager->GetTautulliApi(config_.server);
-      if (api_ && trackerApi_)
-      {
-         // Will get users from tautulli for plex. Do a small pre-check and warn the system.
-         if (trackerApi_->GetValid() && !trackerApi_->GetUserInfo(config_.user_name))
-         {
-            logger_.LogWarning("{} not found on {}. Is user name correct?",
-                               log::GetTag("user", config_.user_name),
-                               log::GetServerName(log::GetFormattedTautulli(), config_.server));
-         }
-
-         valid_ = true;
-      }
-      else
-      {
-         if (!api_)
-         {
-            logger_.LogWarning("{} api not found for {}",
-                               typeServerName_,
-                               log::GetTag("user", config_.user_name));
-         }
-
-         if (!trackerApi_)
-         {
-            logger_.LogWarning("{} tracker api not found for {}. Required for this service.",
-                               log::GetServerName(log::GetFormattedTautulli(), config_.server),
-                               log::GetTag("user", config_.user_name));
-         }
-      }
-   }
-
-   bool PlexUser::GetValid() const
-   {
-      return valid_;
-   }
-
-   std::string PlexUser::GetServerAndUserName() const
-   {
-      return typeServerName_ + ":" + config_.user_name;
-   }
-
-   int32_t PlexUser::GetId() const
-   {
-      return userInfo_.id;
-   }
-
-   std::string_view PlexUser::GetServerName() const
-   {
-      return config_.server;
-   }
-
-   std::string_view PlexUser::GetTypeAndServerName() const
-   {
-      return typeServerName_;
-   }
-
-   std::string_view PlexUser::GetUser() const
-   {
-      return userInfo_.friendlyName.empty() ? config_.user_name : userInfo_.friendlyName;
-   }
-
-   std::optional<TautulliHistoryItems> PlexUser::GetWatchHistory(std::string_view historyDate)
-   {
-      return trackerApi_->GetWatchHistoryForUser(config_.user_name, historyDate);
-   }
-
-   void PlexUser::Update()
-   {
-      auto userInfo{trackerApi_->GetUserInfo(config_.user_name)};
-      valid_ = userInfo.has_value();
-      if (valid_) userInfo_ = *userInfo;
-   }
-
-   void PlexUser::SyncStateWithPlex()
-   {
-      // Currently not supported. Future Growth?
-   }
-
-   bool PlexUser::SyncEmbyWatchedState(const EmbySyncState& syncState)
-   {
-      auto info = api_->GetItemInfo(syncState.name);
-      if (!info) return false;
-
-      auto iter = std::ranges::find_if(info->items, [&](const auto& item) {
-         return item.path == ReplaceMediaPath(syncState.path, syncState.mediaPath, api_->GetMediaPath());
-      });
-
-      // If the item was not found or is already watched just return
-      if (iter == info->items.end() || iter->watched) return false;
-
-      return api_->SetWatched(iter->ratingKey);
-   }
-
-   bool PlexUser::SyncEmbyPlayState(const EmbySyncState& syncState)
-   {
-      auto info = api_->GetItemInfo(syncState.name);
-      if (!info) return false;
-
-      // Find the correct item based on the path
-      auto iter = std::ranges::find_if(info->items, [&](const auto& item) {
-         return item.path == ReplaceMediaPath(syncState.path, syncState.mediaPath, api_->GetMediaPath());
-      });
-
-      // If the item was not found or is already watched just return
-      if (iter == info->items.end() || iter->playbackPercentage == syncState.playbackPercentage) return false;
-
-      auto msLocation = iter->durationMs * static_cast<int64_t>(syncState.playbackPercentage) / 100;
-      return api_->SetPlayed(iter->ratingKey, msLocation);
-   }
-
-   void PlexUser::SyncStateWithEmby(const EmbySyncState& syncState, std::string& syncResults)
-   {
-      if (!config_.can_sync) return;
-
-      if (syncState.watched ? SyncEmbyWatchedState(syncState) : SyncEmbyPlayState(syncState))
-      {
-         syncResults = log::BuildSyncServerString(syncResults, log::GetFormattedPlex(), config_.server);
-      }
-   }
+﻿#include "plex-user.h"
+
+#include "logger/log-utils.h"
+#include "services/service-utils.h"
+
+#include <algorithm>
+#include <format>
+
+namespace loomis
+{
+   PlexUser::PlexUser(const ServerUser& config,
+                      const std::shared_ptr<ApiManager>& apiManager,
+                      WatchStateLogger logger,
+                      std::string_view syncGroup)
+      : logger_(logger)
+      , config_(config)
+      , typeServerName_(log::GetServerName(log::GetFormattedPlex(), config_.server))
+      , historyKey_(std::format("{}>{}", config_.user_name, syncGroup))
+   {
+      // Do some quick checking on the users and make sure the api in the config exists.
+      // Don't want to check if the user is valid on the api yet since it might be offline.
+      // This will be checked every run frame.
+      api_ = apiManager->GetPlexApi(config_.server);
+      trackerApi_ = apiManager->GetTautulliApi(config_.server);
+      if (api_ && trackerApi_)
+      {
+         // Will get users from tautulli for plex. Do a small pre-check and warn the system.
+         if (trackerApi_->GetValid() && !trackerApi_->GetUserInfo(config_.user_name))
+         {
+            logger_.LogWarning("{} not found on {}. Is user name correct?",
+                               log::GetTag("user", config_.user_name),
+                               log::GetServerName(log::GetFormattedTautulli(), config_.server));
+         }
+
+         valid_ = true;
+      }
+      else
+      {
+         if (!api_)
+         {
+            logger_.LogWarning("{} api not found for {}",
+                               typeServerName_,
+                               log::GetTag("user", config_.user_name));
+         }
+
+         if (!trackerApi_)
+         {
+            logger_.LogWarning("{} tracker api not found for {}. Required for this service.",
+                               log::GetServerName(log::GetFormattedTautulli(), config_.server),
+                               log::GetTag("user", config_.user_name));
+         }
+      }
+   }
+
+   bool PlexUser::GetValid() const
+   {
+      return valid_;
+   }
+
+   std::string PlexUser::GetServerAndUserName() const
+   {
+      return typeServerName_ + ":" + config_.user_name;
+   }
+
+   int32_t PlexUser::GetId() const
+   {
+      return userInfo_.id;
+   }
+
+   std::string_view PlexUser::GetServerName() const
+   {
+      return config_.server;
+   }
+
+   std::string_view PlexUser::GetTypeAndServerName() const
+   {
+      return typeServerName_;
+   }
+
+   std::string_view PlexUser::GetUser() const
+   {
+      return userInfo_.friendlyName.empty() ? config_.user_name : userInfo_.friendlyName;
+   }
+
+   std::optional<TautulliHistoryItems> PlexUser::GetWatchHistory(std::string_view historyDate)
+   {
+      return trackerApi_->GetWatchHistoryForUser(config_.user_name, historyDate, trackerApi_->GetHistoryWatermark(historyKey_));
+   }
+
+   std::future<std::optional<TautulliHistoryItems>> PlexUser::GetWatchHistoryAsync(std::string_view historyDate)
+   {
+      return trackerApi_->GetWatchHistoryForUserAsync(config_.user_name, historyDate, trackerApi_->GetHistoryWatermark(historyKey_));
+   }
+
+   void PlexUser::SetHistorySynced(const TautulliHistoryWatermark& watermark)
+   {
+      trackerApi_->SetHistoryWatermark(historyKey_, watermark);
+   }
+
+   void PlexUser::Update()
+   {
+      playStates_.clear();
+
+      // The user lookup is cached and keeps old entries when a load fails so check the servers as well
+      valid_ = api_->GetValid() && trackerApi_->GetValid();
+      if (!valid_) return;
+
+      auto userInfo{trackerApi_->GetUserInfo(config_.user_name)};
+      valid_ = userInfo.has_value();
+      if (valid_) userInfo_ = *userInfo;
+   }
+
+   void PlexUser::SyncStateWithPlex()
+   {
+      // Currently not supported. Future Growth?
+   }
+
+   std::optional<PlexPlayState> PlexUser::GetPlayState(const std::string& ratingKey)
+   {
+      if (auto iter = playStates_.find(ratingKey); iter != playStates_.end()) return iter->second;
+
+      // Not part of a batch so fall back to asking for the single item
+      auto playStates = api_->GetPlayStates({ratingKey});
+      if (!playStates) return std::nullopt;
+
+      auto iter = playStates->find(ratingKey);
+      if (iter == playStates->end()) return std::nullopt;
+
+      playStates_.insert_or_assign(ratingKey, iter->second);
+      return iter->second;
+   }
+
+   void PlexUser::LoadPlayStatesForEmby(std::span<const EmbySyncState> syncStates)
+   {
+      if (!config_.can_sync) return;
+
+      std::vector<std::string> ratingKeys;
+      for (const auto& syncState : syncStates)
+      {
+         auto ratingKey = api_->GetRatingKeyFromPathMap(ReplaceMediaPath(syncState.path, syncState.mediaPath, api_->GetMediaPath()));
+         if (ratingKey && !playStates_.contains(*ratingKey)) ratingKeys.emplace_back(std::move(*ratingKey));
+      }
+
+      // Remove duplicates so each item is only requested once
+      std::ranges::sort(ratingKeys);
+      auto [newEnd, _] = std::ranges::unique(ratingKeys);
+      ratingKeys.erase(newEnd, ratingKeys.end());
+      if (ratingKeys.empty()) return;
+
+      if (auto playStates = api_->GetPlayStates(ratingKeys)) playStates_.merge(*playStates);
+   }
+
+   SyncResult PlexUser::GetPathMissResult() const
+   {
+      // Until the path map is built a miss says nothing about the library
+      return api_->GetPathMapEmpty() ? SyncResult::failed : SyncResult::missing;
+   }
+
+   SyncResult PlexUser::SyncEmbyWatchedState(const EmbySyncState& syncState)
+   {
+      auto ratingKey = api_->GetRatingKeyFromPathMap(ReplaceMediaPath(syncState.path, syncState.mediaPath, api_->GetMediaPath()));
+      if (!ratingKey) return GetPathMissResult();
+
+      // If this item is already watched just return
+      auto playState = GetPlayState(*ratingKey);
+      if (!playState) return SyncResult::failed;
+      if (playState->watched) return SyncResult::unchanged;
+
+      if (!api_->SetWatched(*ratingKey)) return SyncResult::failed;
+
+      playStates_.insert_or_assign(*ratingKey, PlexPlayState{.durationMs = playState->durationMs, .playbackPercentage = 100, .watched = true});
+      return SyncResult::synced;
+   }
+
+   SyncResult PlexUser::SyncEmbyPlayState(const EmbySyncState& syncState)
+   {
+      auto ratingKey = api_->GetRatingKeyFromPathMap(ReplaceMediaPath(syncState.path, syncState.mediaPath, api_->GetMediaPath()));
+      if (!ratingKey) return GetPathMissResult();
+
+      auto playState = GetPlayState(*ratingKey);
+      if (!playState) return SyncResult::failed;
+      if (playState->playbackPercentage == syncState.playbackPercentage) return SyncResult::unchanged;
+
+      auto msLocation = playState->durationMs * static_cast<int64_t>(syncState.playbackPercentage) / 100;
+      if (!api_->SetPlayed(*ratingKey, msLocation)) return SyncResult::failed;
+
+      playStates_.insert_or_assign(*ratingKey, PlexPlayState{.durationMs = playState->durationMs, .playbackPercentage = syncState.playbackPercentage, .watched = false});
+      return SyncResult::synced;
+   }
+
+   bool PlexUser::SyncStateWithEmby(const EmbySyncState& syncState, std::string& syncResults)
+   {
+      if (!config_.can_sync) return true;
+
+      auto result = syncState.watched ? SyncEmbyWatchedState(syncState) : SyncEmbyPlayState(syncState);
+      if (result == SyncResult::synced)
+      {
+         syncResults = log::BuildSyncServerString(syncResults, log::GetFormattedPlex(), config_.server);
+      }
+      return result != SyncResult::failed;
+   }
 }
\ No newline at end of file
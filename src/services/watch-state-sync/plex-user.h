@@ -1,61 +1,84 @@
-#pragma once
-
-#include "api/api-manager.h"
-#include "api/api-plex.h"
-#include "api/api-tautulli.h"
-#include "config-reader/config-reader-types.h"
-#include "services/watch-state-sync/watch-state-logger.h"
-#include "types.h"
-
-#include <functional>
-#include <string>
-#include <vector>
-
-namespace loomis
-{
-   class PlexUser
-   {
-   public:
-      PlexUser(const ServerUser& config,
-               const std::shared_ptr<ApiManager>& apiManager,
-               WatchStateLogger logger);
-      virtual ~PlexUser() = default;
-
-      [[nodiscard]] bool GetValid() const;
-      [[nodiscard]] std::string GetServerAndUserName() const;
-      [[nodiscard]] int32_t GetId() const;
-      [[nodiscard]] std::string_view GetServerName() const;
-      [[nodiscard]] std::string_view GetTypeAndServerName() const;
-      [[nodiscard]] std::string_view GetUser() const;
-      [[nodiscard]] std::optional<TautulliHistoryItems> GetWatchHistory(std::string_view historyDate);
-
-      void Update();
-
-      void SyncStateWithPlex();
-
-      struct EmbySyncState
-      {
-         const std::string& name;
-         const std::string& mediaPath;
-         const std::string& path;
-         bool watched{false};
-         int32_t playbackPercentage{0};
-         const std::string& timeWatched;
-      };
-      void SyncStateWithEmby(const EmbySyncState& syncState, std::string& syncResults);
-
-   private:
-      bool SyncEmbyWatchedState(const EmbySyncState& syncState);
-      bool SyncEmbyPlayState(const EmbySyncState& syncState);
-
-      bool valid_{false};
-      WatchStateLogger logger_;
-      ServerUser config_;
-      std::string typeServerName_;
-
-      PlexApi* api_{nullptr};
-      TautulliApi* trackerApi_{nullptr};
-
-      TautulliUserInfo userInfo_;
-   };
+#pragma once
+
+#include "api/api-manager.h"
+#include "api/api-plex.h"
+#include "api/api-tautulli.h"
+#include "config-reader/config-reader-types.h"
+#include "services/watch-state-sync/watch-state-logger.h"
+#include "services/watch-state-sync/watch-state-types.h"
+#include "types.h"
+
+#include <functional>
+#include <future>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace loomis
+{
+   class PlexUser
+   {
+   public:
+      // The sync group names the users this user is synced with so each group keeps its own history watermark
+      PlexUser(const ServerUser& config,
+               const std::shared_ptr<ApiManager>& apiManager,
+               WatchStateLogger logger,
+               std::string_view syncGroup);
+      virtual ~PlexUser() = default;
+
+      [[nodiscard]] bool GetValid() const;
+      [[nodiscard]] std::string GetServerAndUserName() const;
+      [[nodiscard]] int32_t GetId() const;
+      [[nodiscard]] std::string_view GetServerName() const;
+      [[nodiscard]] std::string_view GetTypeAndServerName() const;
+      [[nodiscard]] std::string_view GetUser() const;
+      // Only the history after the last synced row is returned
+      [[nodiscard]] std::optional<TautulliHistoryItems> GetWatchHistory(std::string_view historyDate);
+      [[nodiscard]] std::future<std::optional<TautulliHistoryItems>> GetWatchHistoryAsync(std::string_view historyDate);
+
+      // Moves the watermark to the row so the next run only reads newer rows
+      void SetHistorySynced(const TautulliHistoryWatermark& watermark);
+
+      void Update();
+
+      void SyncStateWithPlex();
+
+      struct EmbySyncState
+      {
+         const std::string& name;
+         const std::string& mediaPath;
+         const std::string& path;
+         bool watched{false};
+         int32_t playbackPercentage{0};
+         const std::string& timeWatched;
+      };
+      // Returns false if the row could not be synced to this user
+      bool SyncStateWithEmby(const EmbySyncState& syncState, std::string& syncResults);
+
+      // Batch loads the play state of every item a run will sync so each sync does not query the server
+      void LoadPlayStatesForEmby(std::span<const EmbySyncState> syncStates);
+
+   private:
+      // Result for an item whose path is not in the path map
+      [[nodiscard]] SyncResult GetPathMissResult() const;
+      SyncResult SyncEmbyWatchedState(const EmbySyncState& syncState);
+      SyncResult SyncEmbyPlayState(const EmbySyncState& syncState);
+
+      [[nodiscard]] std::optional<PlexPlayState> GetPlayState(const std::string& ratingKey);
+
+      bool valid_{false};
+      WatchStateLogger logger_;
+      ServerUser config_;
+      std::string typeServerName_;
+      std::string historyKey_;
+
+      PlexApi* api_{nullptr};
+      TautulliApi* trackerApi_{nullptr};
+
+      TautulliUserInfo userInfo_;
+
+      // Play states fetched this run. Cleared on update and kept in step with the writes made.
+      PlexPlayStates playStates_;
+   };
 }
\ No newline at end of file
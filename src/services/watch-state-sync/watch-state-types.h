@@ -0,0 +1,18 @@
+#pragma once
+
+namespace loomis
+{
+   // Outcome of syncing one history row to one user
+   enum class SyncResult
+   {
+      // The user already had the state
+      unchanged,
+      synced,
+
+      // The item is not in the user's libraries so there is nothing to sync
+      missing,
+
+      // The server could not be read or the write failed. The row is read again next run.
+      failed
+   };
+}
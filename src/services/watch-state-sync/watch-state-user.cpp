@@ -1,249 +1,384 @@
-﻿#include "watch-state-user.h"
-
-#include "logger/log-utils.h"
-#include "services/service-utils.h"
-
-#include <algorithm>
-#include <ranges>
-
-namespace loomis
-{
-   WatchStateUser::WatchStateUser(const UserSyncConfig& config,
-                                  std::shared_ptr<ApiManager> apiManager,
-                                  WatchStateLogger logger)
-      : apiManager_(std::move(apiManager))
-      , logger_(logger)
-   {
-      std::ranges::for_each(config.plex, [this](const auto& configPlexUser) {
-         auto plexUser{std::make_unique<PlexUser>(configPlexUser,
-                                                  apiManager_,
-                                                  logger_)};
-         if (plexUser->GetValid())
-         {
-            this->plexUsers_.emplace_back(std::move(plexUser));
-         }
-      });
-
-      std::ranges::for_each(config.emby, [this](const auto& configEmbyUser) {
-         auto embyUser{std::make_unique<EmbyUser>(configEmbyUser,
-                                                  apiManager_,
-                                                  logger_)};
-         if (embyUser->GetValid())
-         {
-            this->embyUsers_.emplace_back(std::move(embyUser));
-         }
-      });
-
-      if ((plexUsers_.size() + embyUsers_.size()) >= 2)
-      {
-         valid_ = true;
-      }
-   }
-
-   bool WatchStateUser::GetValid() const
-   {
-      return valid_;
-   }
-
-   std::string WatchStateUser::GetServerAndUserName() const
-   {
-      std::string names;
-      for (const auto& plexUser : plexUsers_)
-      {
-         if (!names.empty()) names += ", ";
-         names += plexUser->GetServerAndUserName();
-      }
-      for (const auto& embyUser : embyUsers_)
-      {
-         if (!names.empty()) names += ", ";
-         names += embyUser->GetServerAndUserName();
-      }
-      return names;
-   }
-
-   void WatchStateUser::UpdateAllUsers()
-   {
-      std::ranges::for_each(plexUsers_, [this](auto& plexUser) {
-         plexUser->Update();
-      });
-
-      std::ranges::for_each(embyUsers_, [this](auto& embyUser) {
-         embyUser->Update();
-      });
-   }
-
-   template <typename T, typename TimeFieldProj>
-   std::vector<const T*> ConsolidateHistory(const std::vector<T>& items, TimeFieldProj timeProj)
-   {
-      if (items.empty()) return {};
-
-      std::vector<const T*> consolidated;
-      consolidated.reserve(items.size());
-      for (const auto& item : items) consolidated.push_back(&item);
-
-      // Sort by ID, then by Time (descending)
-      std::ranges::sort(consolidated, [&](const auto* a, const auto* b) {
-         if (a->id != b->id) return a->id < b->id;
-         return timeProj(a) > timeProj(b); // Use the projection here
-      });
-
-      // Unique based on ID
-      auto [new_end, _] = std::ranges::unique(consolidated, std::ranges::equal_to{}, &T::id);
-      consolidated.erase(new_end, consolidated.end());
-
-      return consolidated;
-   }
-
-   std::vector<const TautulliHistoryItem*> WatchStateUser::GetConsolidatedPlexHistory(const TautulliHistoryItems& historyItems)
-   {
-      return ConsolidateHistory(historyItems.items, [](const auto* i) { return i->timeWatchedEpoch; });
-   }
-
-   std::vector<const JellystatHistoryItem*> WatchStateUser::GetConsolidatedEmbyHistory(const JellystatHistoryItems& historyItems)
-   {
-      return ConsolidateHistory(historyItems.items, [](const auto* i) { return i->watchTime; });
-   }
-
-   void WatchStateUser::LogSyncSummary(const LogSyncData& syncSummary)
-   {
-      if (syncSummary.watched)
-      {
-         logger_.LogInfo("{}:{} watched {} sync {} watch state",
-                         syncSummary.server,
-                         syncSummary.user,
-                         log::GetStandoutText(syncSummary.name),
-                         syncSummary.syncResults);
-      }
-      else
-      {
-         logger_.LogInfo("{}:{} played {}% of {} sync {} play state",
-                         syncSummary.server,
-                         syncSummary.user,
-                         syncSummary.playbackPercentage,
-                         log::GetStandoutText(syncSummary.name),
-                         syncSummary.syncResults);
-      }
-   }
-
-   std::unordered_map<int32_t, std::string> WatchStateUser::GetPlexPathsForHistoryItems(std::string_view server, const std::vector<const TautulliHistoryItem*> historyItems)
-   {
-      auto plexApi = apiManager_->GetPlexApi(server);
-
-      // Guard Clause: Exit early if API is unavailable
-      if (!plexApi || !plexApi->GetValid()) return {};
-
-      std::vector<int32_t> ids;
-      ids.reserve(historyItems.size());
-      for (const auto* item : historyItems) ids.push_back(item->id);
-
-      return plexApi->GetItemsPaths(ids);
-   }
-
-   void WatchStateUser::SyncPlexState(PlexUser& plexUser, std::string_view historyDate)
-   {
-      auto userHistory = plexUser.GetWatchHistory(historyDate);
-      if (!userHistory || userHistory->items.empty()) return;
-
-      auto consolidatedHistory = GetConsolidatedPlexHistory(*userHistory);
-      auto historyWithPaths = GetPlexPathsForHistoryItems(plexUser.GetServerName(), consolidatedHistory);
-
-      for (const auto* history : consolidatedHistory)
-      {
-         if (auto iter = historyWithPaths.find(history->id); iter != historyWithPaths.end())
-         {
-            std::string syncServers;
-
-            auto plexSyncState = EmbyUser::PlexSyncState{
-               .path = iter->second,
-               .watched = history->watched,
-               .playbackPercentage = history->playbackPercentage,
-               .timeWatchedEpoch = history->timeWatchedEpoch};
-
-            for (auto& user : plexUsers_)
-               if (user->GetValid()) user->SyncStateWithPlex();
-            for (auto& user : embyUsers_)
-               if (user->GetValid()) user->SyncStateWithPlex(plexSyncState, syncServers);
-
-            if (!syncServers.empty())
-            {
-               LogSyncSummary({
-                  .server = plexUser.GetTypeAndServerName(),
-                  .user = plexUser.GetUser(),
-                  .name = history->fullName,
-                  .watched = history->watched,
-                  .playbackPercentage = history->playbackPercentage,
-                  .syncResults = syncServers
-               });
-            }
-         }
-      }
-   }
-
-   void WatchStateUser::SyncEmbyState(EmbyUser& embyUser)
-   {
-      auto userHistory = embyUser.GetWatchHistory();
-      if (!userHistory || userHistory->items.empty()) return;
-
-      const auto cutoff = GetIsoTimeStr(std::chrono::system_clock::now() - std::chrono::days(1));
-
-      // Remove all items older than 24 hours
-      std::erase_if(userHistory->items, [&cutoff](const auto& item) {
-         return item.watchTime < cutoff;
-      });
-
-      auto consolidatedHistory = GetConsolidatedEmbyHistory(*userHistory);
-      for (auto& item : consolidatedHistory)
-      {
-         std::string syncServers;
-         auto playState = embyUser.GetPlayState(item->episodeId.has_value() ? *item->episodeId : item->id);
-
-         if (!playState) continue;
-
-         auto plexSyncState = PlexUser::EmbySyncState{
-            .name = item->name,
-            .mediaPath = embyUser.GetMediaPath(),
-            .path = playState->path,
-            .watched = playState->played,
-            .playbackPercentage = static_cast<int32_t>(std::lround(playState->percentage)),
-            .timeWatched = item->watchTime
-         };
-
-         auto embySyncState = EmbyUser::EmbySyncState{
-            .mediaPath = embyUser.GetMediaPath(),
-            .path = playState->path,
-            .watched = playState->played,
-            .playbackPercentage = static_cast<int32_t>(std::lround(playState->percentage)),
-            .timeWatched = item->watchTime
-         };
-
-         for (auto& user : plexUsers_)
-            if (user->GetValid()) user->SyncStateWithEmby(plexSyncState, syncServers);
-         for (auto& user : embyUsers_)
-            if (user->GetServerName() != embyUser.GetServerName() && user->GetValid()) user->SyncStateWithEmby(embySyncState, syncServers);
-
-         if (!syncServers.empty())
-         {
-            auto itemFullName = item->GetFullName();
-            LogSyncSummary({
-               .server = embyUser.GetTypeAndServerName(),
-               .user = embyUser.GetUser(),
-               .name = itemFullName,
-               .watched = playState->played,
-               .playbackPercentage = static_cast<int32_t>(std::lround(playState->percentage)),
-               .syncResults = syncServers
-            });
-         }
-      }
-   }
-
-   void WatchStateUser::Sync()
-   {
-      // Have all users update to the latest data
-      UpdateAllUsers();
-
-      constexpr uint32_t daysOfHistory{1};
-      auto plexHistoryTime{GetDatetimeForHistoryPlex(daysOfHistory)};
-      for (auto& plexUser : plexUsers_) SyncPlexState(*plexUser, plexHistoryTime);
-      for (auto& embyUser : embyUsers_) SyncEmbyState(*embyUser);
-   }
+﻿#include "watch-state-user.h"
+
+#include "logger/log-utils.h"
+#include "services/service-utils.h"
+
+#include <algorithm>
+#include <format>
+#include <ranges>
+#include <tuple>
+#include <unordered_set>
+
+namespace loomis
+{
+   namespace
+   {
+      // Names every configured user of a sync group
+      std::string GetSyncGroupName(const UserSyncConfig& config)
+      {
+         std::string name;
+         for (const auto& user : config.plex) name += std::format("plex:{}:{};", user.server, user.user_name);
+         for (const auto& user : config.emby) name += std::format("emby:{}:{};", user.server, user.user_name);
+         return name;
+      }
+   }
+
+   WatchStateUser::WatchStateUser(const UserSyncConfig& config,
+                                  std::shared_ptr<ApiManager> apiManager,
+                                  WatchStateLogger logger)
+      : apiManager_(std::move(apiManager))
+      , logger_(logger)
+   {
+      auto syncGroup = GetSyncGroupName(config);
+      std::ranges::for_each(config.plex, [this, &syncGroup](const auto& configPlexUser) {
+         auto plexUser{std::make_unique<PlexUser>(configPlexUser,
+                                                  apiManager_,
+                                                  logger_,
+                                                  syncGroup)};
+         if (plexUser->GetValid())
+         {
+            this->plexUsers_.emplace_back(std::move(plexUser));
+         }
+      });
+
+      std::ranges::for_each(config.emby, [this, &syncGroup](const auto& configEmbyUser) {
+         auto embyUser{std::make_unique<EmbyUser>(configEmbyUser,
+                                                  apiManager_,
+                                                  logger_,
+                                                  syncGroup)};
+         if (embyUser->GetValid())
+         {
+            this->embyUsers_.emplace_back(std::move(embyUser));
+         }
+      });
+
+      if ((plexUsers_.size() + embyUsers_.size()) >= 2)
+      {
+         valid_ = true;
+      }
+   }
+
+   bool WatchStateUser::GetValid() const
+   {
+      return valid_;
+   }
+
+   std::string WatchStateUser::GetServerAndUserName() const
+   {
+      std::string names;
+      for (const auto& plexUser : plexUsers_)
+      {
+         if (!names.empty()) names += ", ";
+         names += plexUser->GetServerAndUserName();
+      }
+      for (const auto& embyUser : embyUsers_)
+      {
+         if (!names.empty()) names += ", ";
+         names += embyUser->GetServerAndUserName();
+      }
+      return names;
+   }
+
+   void WatchStateUser::UpdateAllUsers()
+   {
+      std::ranges::for_each(plexUsers_, [this](auto& plexUser) {
+         plexUser->Update();
+      });
+
+      std::ranges::for_each(embyUsers_, [this](auto& embyUser) {
+         embyUser->Update();
+      });
+   }
+
+   template <typename T, typename TimeFieldProj>
+   std::vector<const T*> ConsolidateHistory(const std::vector<T>& items, TimeFieldProj timeProj)
+   {
+      if (items.empty()) return {};
+
+      std::vector<const T*> consolidated;
+      consolidated.reserve(items.size());
+      for (const auto& item : items) consolidated.push_back(&item);
+
+      // Sort by ID, then by Time (descending)
+      std::ranges::sort(consolidated, [&](const auto* a, const auto* b) {
+         if (a->id != b->id) return a->id < b->id;
+         return timeProj(a) > timeProj(b); // Use the projection here
+      });
+
+      // Unique based on ID
+      auto [new_end, _] = std::ranges::unique(consolidated, std::ranges::equal_to{}, &T::id);
+      consolidated.erase(new_end, consolidated.end());
+
+      return consolidated;
+   }
+
+   // Returns the newest row that is older than every row of a failed item so the failed rows are read again next run.
+   // Returns nullptr if no row is that old and the watermark has to stay where it was.
+   // The history window still bounds the re-reads so an item that keeps failing is dropped once its rows age out.
+   template <typename T, typename FailedPred, typename OrderProj>
+   const T* GetLastRowBeforeFailure(const std::vector<T>& items, FailedPred failed, OrderProj orderProj)
+   {
+      const T* firstFailed{nullptr};
+      for (const auto& item : items)
+      {
+         if (failed(item) && (!firstFailed || orderProj(item) < orderProj(*firstFailed))) firstFailed = &item;
+      }
+      if (!firstFailed) return nullptr;
+
+      const T* lastSynced{nullptr};
+      for (const auto& item : items)
+      {
+         if (orderProj(item) < orderProj(*firstFailed) && (!lastSynced || orderProj(item) > orderProj(*lastSynced))) lastSynced = &item;
+      }
+      return lastSynced;
+   }
+
+   std::vector<const TautulliHistoryItem*> WatchStateUser::GetConsolidatedPlexHistory(const TautulliHistoryItems& historyItems)
+   {
+      return ConsolidateHistory(historyItems.items, [](const auto* i) { return i->timeWatchedEpoch; });
+   }
+
+   std::vector<const JellystatHistoryItem*> WatchStateUser::GetConsolidatedEmbyHistory(const JellystatHistoryItems& historyItems)
+   {
+      return ConsolidateHistory(historyItems.items, [](const auto* i) { return i->watchTime; });
+   }
+
+   void WatchStateUser::LogSyncSummary(const LogSyncData& syncSummary)
+   {
+      if (syncSummary.watched)
+      {
+         logger_.LogInfo("{}:{} watched {} sync {} watch state",
+                         syncSummary.server,
+                         syncSummary.user,
+                         log::GetStandoutText(syncSummary.name),
+                         syncSummary.syncResults);
+      }
+      else
+      {
+         logger_.LogInfo("{}:{} played {}% of {} sync {} play state",
+                         syncSummary.server,
+                         syncSummary.user,
+                         syncSummary.playbackPercentage,
+                         log::GetStandoutText(syncSummary.name),
+                         syncSummary.syncResults);
+      }
+   }
+
+   std::optional<std::unordered_map<int32_t, std::string>> WatchStateUser::GetPlexPathsForHistoryItems(std::string_view server, const std::vector<const TautulliHistoryItem*> historyItems)
+   {
+      auto plexApi = apiManager_->GetPlexApi(server);
+
+      // Guard Clause: Exit early if API is unavailable
+      if (!plexApi || !plexApi->GetValid()) return std::nullopt;
+
+      std::vector<int32_t> ids;
+      ids.reserve(historyItems.size());
+      for (const auto* item : historyItems) ids.push_back(item->id);
+
+      return plexApi->GetItemsPaths(ids);
+   }
+
+   void WatchStateUser::SyncPlexState(PlexUser& plexUser, std::optional<TautulliHistoryItems> userHistory)
+   {
+      if (!userHistory || userHistory->items.empty()) return;
+
+      // The rows are only marked as synced once there is a server to sync them to
+      if (std::ranges::none_of(embyUsers_, [](const auto& user) { return user->GetValid(); })) return;
+
+      auto consolidatedHistory = GetConsolidatedPlexHistory(*userHistory);
+      auto historyWithPaths = GetPlexPathsForHistoryItems(plexUser.GetServerName(), consolidatedHistory);
+      if (!historyWithPaths) return;
+
+      // Items without a path have been removed from Plex since they were played so there is nothing to sync
+      std::unordered_set<int32_t> failedIds;
+      std::vector<const TautulliHistoryItem*> syncHistory;
+      std::vector<EmbyUser::PlexSyncState> plexSyncStates;
+      for (const auto* history : consolidatedHistory)
+      {
+         auto iter = historyWithPaths->find(history->id);
+         if (iter == historyWithPaths->end()) continue;
+
+         syncHistory.push_back(history);
+         plexSyncStates.push_back(EmbyUser::PlexSyncState{
+            .path = iter->second,
+            .watched = history->watched,
+            .playbackPercentage = history->playbackPercentage,
+            .timeWatchedEpoch = history->timeWatchedEpoch});
+      }
+
+      // Load what each user already has for all the items up front so only the writes are per item
+      for (auto& user : embyUsers_)
+         if (user->GetValid()) user->LoadPlayStatesForPlex(plexSyncStates);
+
+      for (size_t i = 0; i < syncHistory.size(); ++i)
+      {
+         const auto* history = syncHistory[i];
+         std::string syncServers;
+
+         bool synced{true};
+         for (auto& user : plexUsers_)
+            if (user->GetValid()) user->SyncStateWithPlex();
+         for (auto& user : embyUsers_)
+            if (user->GetValid() && !user->SyncStateWithPlex(plexSyncStates[i], syncServers)) synced = false;
+
+         if (!synced) failedIds.insert(history->id);
+
+         if (!syncServers.empty())
+         {
+            LogSyncSummary({
+               .server = plexUser.GetTypeAndServerName(),
+               .user = plexUser.GetUser(),
+               .name = history->fullName,
+               .watched = history->watched,
+               .playbackPercentage = history->playbackPercentage,
+               .syncResults = syncServers
+            });
+         }
+      }
+
+      // The watermark only moves past rows that synced to every user
+      auto orderProj = [](const TautulliHistoryItem& item) { return std::tie(item.timeWatchedEpoch, item.rowId); };
+      if (failedIds.empty())
+      {
+         if (userHistory->watermark) plexUser.SetHistorySynced(*userHistory->watermark);
+      }
+      else if (const auto* lastSynced = GetLastRowBeforeFailure(userHistory->items, [&failedIds](const auto& item) { return failedIds.contains(item.id); }, orderProj))
+      {
+         plexUser.SetHistorySynced(TautulliHistoryWatermark{.stopped = lastSynced->timeWatchedEpoch, .rowId = lastSynced->rowId});
+      }
+   }
+
+   void WatchStateUser::SyncEmbyState(EmbyUser& embyUser, std::optional<JellystatHistoryItems> userHistory)
+   {
+      if (!embyUser.GetValid() || !userHistory || userHistory->items.empty()) return;
+
+      // The rows are only marked as synced once there is a server to sync them to
+      auto otherEmbyValid = std::ranges::any_of(embyUsers_, [&embyUser](const auto& user) {
+         return user->GetServerName() != embyUser.GetServerName() && user->GetValid();
+      });
+      auto plexValid = std::ranges::any_of(plexUsers_, [](const auto& user) { return user->GetValid(); });
+      if (!otherEmbyValid && !plexValid) return;
+
+      auto consolidatedHistory = GetConsolidatedEmbyHistory(*userHistory);
+
+      // Get the play state of every history item in one batch
+      std::vector<std::string> itemIds;
+      itemIds.reserve(consolidatedHistory.size());
+      for (const auto* item : consolidatedHistory) itemIds.push_back(item->episodeId.has_value() ? *item->episodeId : item->id);
+      embyUser.LoadPlayStates(itemIds);
+
+      struct HistoryPlayState
+      {
+         const JellystatHistoryItem* item{nullptr};
+         EmbyPlayState playState;
+      };
+      // Items whose play state could not be read can not be synced so they count as failed
+      std::unordered_set<std::string> failedIds;
+      std::vector<HistoryPlayState> historyPlayStates;
+      historyPlayStates.reserve(consolidatedHistory.size());
+      for (size_t i = 0; i < consolidatedHistory.size(); ++i)
+      {
+         if (auto playState = embyUser.GetPlayState(itemIds[i]))
+         {
+            historyPlayStates.push_back({.item = consolidatedHistory[i], .playState = std::move(*playState)});
+         }
+         else
+         {
+            failedIds.insert(consolidatedHistory[i]->id);
+         }
+      }
+
+      // Sync states reference the play states so they are built once the play states are in place
+      std::vector<EmbyUser::EmbySyncState> embySyncStates;
+      embySyncStates.reserve(historyPlayStates.size());
+      for (const auto& [item, playState] : historyPlayStates)
+      {
+         embySyncStates.push_back(EmbyUser::EmbySyncState{
+            .mediaPath = embyUser.GetMediaPath(),
+            .path = playState.path,
+            .watched = playState.played,
+            .playbackPercentage = static_cast<int32_t>(std::lround(playState.percentage)),
+            .timeWatched = item->watchTime
+         });
+      }
+
+      std::vector<PlexUser::EmbySyncState> plexSyncStates;
+      plexSyncStates.reserve(historyPlayStates.size());
+      for (const auto& [item, playState] : historyPlayStates)
+      {
+         plexSyncStates.push_back(PlexUser::EmbySyncState{
+            .name = item->name,
+            .mediaPath = embyUser.GetMediaPath(),
+            .path = playState.path,
+            .watched = playState.played,
+            .playbackPercentage = static_cast<int32_t>(std::lround(playState.percentage)),
+            .timeWatched = item->watchTime
+         });
+      }
+
+      for (auto& user : plexUsers_)
+         if (user->GetValid()) user->LoadPlayStatesForEmby(plexSyncStates);
+      for (auto& user : embyUsers_)
+         if (user->GetServerName() != embyUser.GetServerName() && user->GetValid()) user->LoadPlayStatesForEmby(embySyncStates);
+
+      for (size_t i = 0; i < historyPlayStates.size(); ++i)
+      {
+         const auto& [item, playState] = historyPlayStates[i];
+         std::string syncServers;
+
+         bool synced{true};
+         for (auto& user : plexUsers_)
+            if (user->GetValid() && !user->SyncStateWithEmby(plexSyncStates[i], syncServers)) synced = false;
+         for (auto& user : embyUsers_)
+            if (user->GetServerName() != embyUser.GetServerName() && user->GetValid() && !user->SyncStateWithEmby(embySyncStates[i], syncServers)) synced = false;
+
+         if (!synced) failedIds.insert(item->id);
+
+         if (!syncServers.empty())
+         {
+            auto itemFullName = item->GetFullName();
+            LogSyncSummary({
+               .server = embyUser.GetTypeAndServerName(),
+               .user = embyUser.GetUser(),
+               .name = itemFullName,
+               .watched = playState.played,
+               .playbackPercentage = static_cast<int32_t>(std::lround(playState.percentage)),
+               .syncResults = syncServers
+            });
+         }
+      }
+
+      // The watermark only moves past rows that synced to every user
+      auto orderProj = [](const JellystatHistoryItem& item) { return std::tie(item.watchTime, item.activityId); };
+      if (failedIds.empty())
+      {
+         if (userHistory->watermark) embyUser.SetHistorySynced(*userHistory->watermark);
+      }
+      else if (const auto* lastSynced = GetLastRowBeforeFailure(userHistory->items, [&failedIds](const auto& item) { return failedIds.contains(item.id); }, orderProj))
+      {
+         embyUser.SetHistorySynced(JellystatHistoryWatermark{.watchTime = lastSynced->watchTime, .activityId = lastSynced->activityId});
+      }
+   }
+
+   void WatchStateUser::Sync()
+   {
+      // Have all users update to the latest data
+      UpdateAllUsers();
+
+      constexpr uint32_t daysOfHistory{1};
+      auto plexHistoryTime{GetDatetimeForHistoryPlex(daysOfHistory)};
+      auto embyHistoryTime{GetIsoTimeStr(std::chrono::system_clock::now() - std::chrono::days(daysOfHistory))};
+
+      // Request every users history up front so the trackers are queried concurrently
+      std::vector<std::future<std::optional<TautulliHistoryItems>>> plexHistories;
+      plexHistories.reserve(plexUsers_.size());
+      for (auto& plexUser : plexUsers_) plexHistories.emplace_back(plexUser->GetWatchHistoryAsync(plexHistoryTime));
+
+      std::vector<std::future<std::optional<JellystatHistoryItems>>> embyHistories;
+      embyHistories.reserve(embyUsers_.size());
+      for (auto& embyUser : embyUsers_) embyHistories.emplace_back(embyUser->GetWatchHistoryAsync(embyHistoryTime));
+
+      for (size_t i = 0; i < plexUsers_.size(); ++i) SyncPlexState(*plexUsers_[i], plexHistories[i].get());
+      for (size_t i = 0; i < embyUsers_.size(); ++i) SyncEmbyState(*embyUsers_[i], embyHistories[i].get());
+   }
 }
\ No newline at end of file
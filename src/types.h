@@ -1,33 +1,36 @@
-#pragma once
-
-#include <functional>
-#include <string>
-
-namespace loomis
-{
-   static constexpr int VALID_HTTP_RESPONSE_MAX{300};
-
-   enum class LogType
-   {
-      TRACE,
-      INFO,
-      WARN,
-      ERR
-   };
-
-   enum class ApiType
-   {
-      PLEX,
-      EMBY,
-      TAUTULLI,
-      JELLYSTAT
-   };
-
-   struct Task
-   {
-      bool service{false};
-      std::string name;
-      std::string cronExpression;
-      std::function<void()> func;
-   };
+#pragma once
+
+#include <functional>
+#include <string>
+
+namespace loomis
+{
+   static constexpr int VALID_HTTP_RESPONSE_MAX{300};
+
+   enum class LogType
+   {
+      TRACE,
+      INFO,
+      WARN,
+      ERR
+   };
+
+   enum class ApiType
+   {
+      PLEX,
+      EMBY,
+      TAUTULLI,
+      JELLYSTAT
+   };
+
+   struct Task
+   {
+      bool service{false};
+      std::string name;
+
+      // Name without ANSI codes for metrics and status. Empty when name is already plain
+      std::string plainName;
+      std::string cronExpression;
+      std::function<void()> func;
+   };
 }
\ No newline at end of file
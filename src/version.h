@@ -1,7 +1,7 @@
-
-#include <string>
-
-namespace loomis
-{
-   static constexpr const std::string_view LOOMIS_VERSION("v0.7.1");
+
+#include <string>
+
+namespace loomis
+{
+   static constexpr const std::string_view LOOMIS_VERSION("v0.7.1");
 }
\ No newline at end of file